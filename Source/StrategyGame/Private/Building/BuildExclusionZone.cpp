@@ -3,12 +3,14 @@
 
 #include "Building/BuildExclusionZone.h"
 
+#include "Building/BuildGridSubsystem.h"
+
 
 // Sets default values
 ABuildExclusionZone::ABuildExclusionZone()
 {
 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bCanEverTick = false;
 
 	BoxTrigger = CreateDefaultSubobject<UBoxComponent>("Box Trigger");
 	BoxTrigger->SetBoxExtent(FVector(2000.0f, 2000.0f, 2000.0f));
@@ -20,12 +22,20 @@ ABuildExclusionZone::ABuildExclusionZone()
 void ABuildExclusionZone::BeginPlay()
 {
 	Super::BeginPlay();
-	
+
+	// Blocks every cell the trigger touches, buildings check the build grid instead of overlapping the trigger.
+	if (UBuildGridSubsystem* BuildGrid = GetWorld()->GetSubsystem<UBuildGridSubsystem>())
+	{
+		BuildGrid->StampRect(this, EBuildGridLayer::ExclusionZone, BuildGrid->WorldBoxToCellRect(BoxTrigger->Bounds.GetBox(), 1.0f));
+	}
 }
 
-// Called every frame
-void ABuildExclusionZone::Tick(float DeltaTime)
+void ABuildExclusionZone::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	Super::Tick(DeltaTime);
+	if (UBuildGridSubsystem* BuildGrid = GetWorld()->GetSubsystem<UBuildGridSubsystem>())
+	{
+		BuildGrid->Unstamp(this);
+	}
+	
+	Super::EndPlay(EndPlayReason);
 }
-
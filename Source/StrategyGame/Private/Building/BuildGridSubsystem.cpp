@@ -0,0 +1,351 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Building/BuildGridSubsystem.h"
+
+#include "EngineUtils.h"
+#include "Building/Buildable.h"
+#include "Game/StrategyGameModeBase.h"
+
+bool UBuildGridSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UBuildGridSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// Exclusion zones stamp themselves in BeginPlay, buildables only once they begin construction.
+	for (TActorIterator<ABuildable> It(&InWorld); It; ++It)
+	{
+		if (It->IsConstructionComplete()) It->AddToBuildGrid();
+	}
+}
+
+void UBuildGridSubsystem::Deinitialize()
+{
+	Chunks.Empty();
+	Stamps.Empty();
+
+	Super::Deinitialize();
+}
+
+template <typename FunctionType>
+void UBuildGridSubsystem::ForEachChunkSpan(const FIntRect& CellRect, FunctionType&& Function)
+{
+	if (CellRect.Min.X >= CellRect.Max.X || CellRect.Min.Y >= CellRect.Max.Y) return;
+
+	const FIntPoint MinChunk(FMath::FloorToInt32(CellRect.Min.X / static_cast<float>(ChunkSize)), FMath::FloorToInt32(CellRect.Min.Y / static_cast<float>(ChunkSize)));
+	const FIntPoint MaxChunk(FMath::FloorToInt32((CellRect.Max.X - 1) / static_cast<float>(ChunkSize)), FMath::FloorToInt32((CellRect.Max.Y - 1) / static_cast<float>(ChunkSize)));
+
+	for (int32 ChunkY = MinChunk.Y; ChunkY <= MaxChunk.Y; ChunkY++)
+	{
+		for (int32 ChunkX = MinChunk.X; ChunkX <= MaxChunk.X; ChunkX++)
+		{
+			const FIntPoint ChunkOrigin(ChunkX * ChunkSize, ChunkY * ChunkSize);
+
+			// The part of the rect inside this chunk, in chunk local cells.
+			const int32 X0 = FMath::Max(CellRect.Min.X, ChunkOrigin.X) - ChunkOrigin.X;
+			const int32 X1 = FMath::Min(CellRect.Max.X, ChunkOrigin.X + ChunkSize) - ChunkOrigin.X;
+			const int32 Y0 = FMath::Max(CellRect.Min.Y, ChunkOrigin.Y) - ChunkOrigin.Y;
+			const int32 Y1 = FMath::Min(CellRect.Max.Y, ChunkOrigin.Y + ChunkSize) - ChunkOrigin.Y;
+
+			if (!Function(FIntPoint(ChunkX, ChunkY), X0, X1, Y0, Y1)) return;
+		}
+	}
+}
+
+uint64 UBuildGridSubsystem::RowMask(int32 X0, int32 X1)
+{
+	const uint64 Width = X1 - X0;
+	return (Width >= 64 ? ~0ull : ((1ull << Width) - 1)) << X0;
+}
+
+int32 UBuildGridSubsystem::LayerIndex(EBuildGridLayer Layer)
+{
+	return FMath::CountTrailingZeros(static_cast<uint32>(Layer));
+}
+
+template <typename FunctionType>
+void UBuildGridSubsystem::ForEachStampAt(const FChunk& Chunk, const FIntPoint& Cell, FunctionType&& Function) const
+{
+	for (const uint32 StampID : Chunk.StampIDs)
+	{
+		const FStamp* CellStamp = Stamps.Find(StampID);
+		if (!CellStamp) continue;
+
+		for (const FIntRect& CellRect : CellStamp->Rects)
+		{
+			if (Cell.X < CellRect.Min.X || Cell.X >= CellRect.Max.X || Cell.Y < CellRect.Min.Y || Cell.Y >= CellRect.Max.Y) continue;
+
+			Function(StampID, *CellStamp);
+			break;
+		}
+	}
+}
+
+uint32 UBuildGridSubsystem::ResolveOwner(const FChunk& Chunk, const FIntPoint& Cell) const
+{
+	uint32 Owner = 0;
+	ForEachStampAt(Chunk, Cell, [&](uint32 StampID, const FStamp&)
+	{
+		Owner = Owner == 0 ? StampID : SharedCell;
+	});
+	return Owner;
+}
+
+float UBuildGridSubsystem::GetCellSize()
+{
+	if (CellSize <= 0.0f)
+	{
+		AStrategyGameModeBase* GameMode = GetWorld()->GetAuthGameMode<AStrategyGameModeBase>();
+		CellSize = GameMode ? GameMode->GetSnappingSize() : 500.0f;
+	}
+
+	return CellSize;
+}
+
+FIntPoint UBuildGridSubsystem::WorldToCell(const FVector& WorldLocation)
+{
+	return FIntPoint(FMath::FloorToInt32(WorldLocation.X / GetCellSize()), FMath::FloorToInt32(WorldLocation.Y / GetCellSize()));
+}
+
+FIntRect UBuildGridSubsystem::WorldBoxToCellRect(const FBox& WorldBox, float Inset)
+{
+	const FVector Min = WorldBox.Min + FVector(Inset, Inset, 0.0f);
+	const FVector Max = WorldBox.Max - FVector(Inset, Inset, 0.0f);
+
+	const FIntPoint MinCell = WorldToCell(Min);
+	const FIntPoint MaxCell = WorldToCell(FVector::Max(Min, Max));
+	return FIntRect(MinCell, MaxCell + FIntPoint(1, 1));
+}
+
+void UBuildGridSubsystem::RasterizeLine(FIntPoint From, FIntPoint To, TArray<FIntPoint>& OutCells)
+{
+	const int32 DeltaX = FMath::Abs(To.X - From.X);
+	const int32 DeltaY = -FMath::Abs(To.Y - From.Y);
+	const int32 StepX = From.X < To.X ? 1 : -1;
+	const int32 StepY = From.Y < To.Y ? 1 : -1;
+	int32 Error = DeltaX + DeltaY;
+
+	FIntPoint Cell = From;
+	while (true)
+	{
+		OutCells.Add(Cell);
+		if (Cell == To) break;
+
+		const int32 DoubleError = Error * 2;
+		if (DoubleError >= DeltaY)
+		{
+			Error += DeltaY;
+			Cell.X += StepX;
+		}
+		if (DoubleError <= DeltaX)
+		{
+			Error += DeltaX;
+			Cell.Y += StepY;
+		}
+	}
+}
+
+void UBuildGridSubsystem::SetCells(const FIntRect& CellRect, EBuildGridLayer Layer, uint32 Owner)
+{
+	const int32 LayerSlot = LayerIndex(Layer);
+
+	ForEachChunkSpan(CellRect, [&](FIntPoint ChunkCoord, int32 X0, int32 X1, int32 Y0, int32 Y1)
+	{
+		TUniquePtr<FChunk>& Chunk = Chunks.FindOrAdd(ChunkCoord);
+		if (!Chunk) Chunk = MakeUnique<FChunk>();
+
+		Chunk->StampIDs.AddUnique(Owner);
+
+		const uint64 Mask = RowMask(X0, X1);
+		for (int32 Y = Y0; Y < Y1; Y++)
+		{
+			Chunk->NumOccupied += FMath::CountBits(Mask & ~Chunk->Occupied[Y]);
+			Chunk->Occupied[Y] |= Mask;
+			Chunk->Layers[LayerSlot][Y] |= Mask;
+
+			for (int32 X = X0; X < X1; X++)
+			{
+				Chunk->Counts[LayerSlot][Y * ChunkSize + X]++;
+
+				uint32& CellOwner = Chunk->Owners[Y * ChunkSize + X];
+				if (CellOwner == 0) CellOwner = Owner;
+				else if (CellOwner != Owner) CellOwner = SharedCell;
+			}
+		}
+		return true;
+	});
+}
+
+void UBuildGridSubsystem::ClearCells(const FIntRect& CellRect, EBuildGridLayer Layer, uint32 Owner)
+{
+	const int32 LayerSlot = LayerIndex(Layer);
+
+	ForEachChunkSpan(CellRect, [&](FIntPoint ChunkCoord, int32 X0, int32 X1, int32 Y0, int32 Y1)
+	{
+		TUniquePtr<FChunk>* Chunk = Chunks.Find(ChunkCoord);
+		if (!Chunk) return true;
+
+		// The owner's stamp is already gone from Stamps, so it's left out when the owners are worked out again below.
+		FChunk& ChunkRef = **Chunk;
+		ChunkRef.StampIDs.RemoveSwap(Owner);
+
+		const FIntPoint ChunkOrigin = ChunkCoord * ChunkSize;
+		for (int32 Y = Y0; Y < Y1; Y++)
+		{
+			for (int32 X = X0; X < X1; X++)
+			{
+				uint16& Count = ChunkRef.Counts[LayerSlot][Y * ChunkSize + X];
+				if (Count > 0 && --Count == 0) ChunkRef.Layers[LayerSlot][Y] &= ~(1ull << X);
+			}
+
+			uint64 StillOccupied = 0;
+			for (int32 Index = 0; Index < NumLayers; Index++) StillOccupied |= ChunkRef.Layers[Index][Y];
+
+			ChunkRef.NumOccupied -= FMath::CountBits(ChunkRef.Occupied[Y] & ~StillOccupied);
+			ChunkRef.Occupied[Y] = StillOccupied;
+
+			// Cells other stamps still cover go to whoever is left, only looked up where the owner being cleared had a share.
+			for (int32 X = X0; X < X1; X++)
+			{
+				uint32& CellOwner = ChunkRef.Owners[Y * ChunkSize + X];
+				if (!(StillOccupied & (1ull << X))) CellOwner = 0;
+				else if (CellOwner == Owner || CellOwner == SharedCell) CellOwner = ResolveOwner(ChunkRef, ChunkOrigin + FIntPoint(X, Y));
+			}
+		}
+
+		if (ChunkRef.NumOccupied <= 0) Chunks.Remove(ChunkCoord);
+		return true;
+	});
+}
+
+void UBuildGridSubsystem::Stamp(AActor* Owner, EBuildGridLayer Layer, const TArray<FIntRect>& CellRects)
+{
+	if (!Owner || Layer == EBuildGridLayer::None) return;
+
+	Unstamp(Owner);
+
+	FStamp& NewStamp = Stamps.Add(Owner->GetUniqueID());
+	NewStamp.Actor = Owner;
+	NewStamp.Layer = Layer;
+	NewStamp.Rects = CellRects;
+
+	for (const FIntRect& CellRect : CellRects)
+	{
+		SetCells(CellRect, Layer, Owner->GetUniqueID());
+	}
+}
+
+void UBuildGridSubsystem::Unstamp(AActor* Owner)
+{
+	if (!Owner) return;
+
+	FStamp OldStamp;
+	if (!Stamps.RemoveAndCopyValue(Owner->GetUniqueID(), OldStamp)) return;
+
+	for (const FIntRect& CellRect : OldStamp.Rects)
+	{
+		ClearCells(CellRect, OldStamp.Layer, Owner->GetUniqueID());
+	}
+}
+
+bool UBuildGridSubsystem::IsAreaFree(const FIntRect& CellRect, EBuildGridLayer LayerMask, const AActor* IgnoredOwner) const
+{
+	const uint32 IgnoredID = IgnoredOwner ? IgnoredOwner->GetUniqueID() : 0;
+	bool bFree = true;
+
+	ForEachChunkSpan(CellRect, [&](FIntPoint ChunkCoord, int32 X0, int32 X1, int32 Y0, int32 Y1)
+	{
+		const TUniquePtr<FChunk>* Chunk = Chunks.Find(ChunkCoord);
+		if (!Chunk) return true;
+
+		const FChunk& ChunkRef = **Chunk;
+		const FIntPoint ChunkOrigin = ChunkCoord * ChunkSize;
+		const uint64 Mask = RowMask(X0, X1);
+		for (int32 Y = Y0; Y < Y1 && bFree; Y++)
+		{
+			uint64 Blocked = 0;
+			for (int32 Index = 0; Index < NumLayers; Index++)
+			{
+				if (EnumHasAnyFlags(LayerMask, static_cast<EBuildGridLayer>(1 << Index))) Blocked |= ChunkRef.Layers[Index][Y];
+			}
+			Blocked &= Mask;
+
+			// Only walk the individual cells when there's an owner to ignore.
+			while (Blocked && bFree)
+			{
+				const int32 X = FMath::CountTrailingZeros64(Blocked);
+				Blocked &= Blocked - 1;
+				const uint32 CellOwner = ChunkRef.Owners[Y * ChunkSize + X];
+				if (IgnoredID == 0 || (CellOwner != IgnoredID && CellOwner != SharedCell))
+				{
+					bFree = false;
+					continue;
+				}
+
+				// Shared cells are only free if every other stamp on them is on a layer that isn't checked.
+				if (CellOwner == SharedCell)
+				{
+					ForEachStampAt(ChunkRef, ChunkOrigin + FIntPoint(X, Y), [&](uint32 StampID, const FStamp& CellStamp)
+					{
+						if (StampID != IgnoredID && EnumHasAnyFlags(LayerMask, CellStamp.Layer)) bFree = false;
+					});
+				}
+			}
+		}
+		return bFree;
+	});
+
+	return bFree;
+}
+
+void UBuildGridSubsystem::GetOwnersInArea(const FIntRect& CellRect, EBuildGridLayer LayerMask, TArray<AActor*>& OutOwners) const
+{
+	TSet<uint32> OwnerIDs;
+
+	ForEachChunkSpan(CellRect, [&](FIntPoint ChunkCoord, int32 X0, int32 X1, int32 Y0, int32 Y1)
+	{
+		const TUniquePtr<FChunk>* Chunk = Chunks.Find(ChunkCoord);
+		if (!Chunk) return true;
+
+		const FChunk& ChunkRef = **Chunk;
+		const FIntPoint ChunkOrigin = ChunkCoord * ChunkSize;
+		const uint64 Mask = RowMask(X0, X1);
+		for (int32 Y = Y0; Y < Y1; Y++)
+		{
+			uint64 Blocked = 0;
+			for (int32 Index = 0; Index < NumLayers; Index++)
+			{
+				if (EnumHasAnyFlags(LayerMask, static_cast<EBuildGridLayer>(1 << Index))) Blocked |= ChunkRef.Layers[Index][Y];
+			}
+			Blocked &= Mask;
+
+			while (Blocked)
+			{
+				const int32 X = FMath::CountTrailingZeros64(Blocked);
+				Blocked &= Blocked - 1;
+				const uint32 CellOwner = ChunkRef.Owners[Y * ChunkSize + X];
+				if (CellOwner != SharedCell)
+				{
+					if (CellOwner != 0) OwnerIDs.Add(CellOwner);
+					continue;
+				}
+
+				ForEachStampAt(ChunkRef, ChunkOrigin + FIntPoint(X, Y), [&](uint32 StampID, const FStamp& CellStamp)
+				{
+					if (EnumHasAnyFlags(LayerMask, CellStamp.Layer)) OwnerIDs.Add(StampID);
+				});
+			}
+		}
+		return true;
+	});
+
+	for (const uint32 OwnerID : OwnerIDs)
+	{
+		const FStamp* OwnerStamp = Stamps.Find(OwnerID);
+		if (OwnerStamp && OwnerStamp->Actor.IsValid()) OutOwners.Add(OwnerStamp->Actor.Get());
+	}
+}
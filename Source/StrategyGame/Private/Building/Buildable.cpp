@@ -1,11 +1,11 @@
-// Fill out your copyright notice in the Description page of Project Settings.
+﻿// Fill out your copyright notice in the Description page of Project Settings.
 
 
 #include "Building/Buildable.h"
 
-#include "Building/BuildExclusionZone.h"
 #include "ResourceNode.h"
 #include "Building/Road.h"
+#include "Building/RoadNetworkSubsystem.h"
 #include "Building/Structure.h"
 #include "Components/ArrowComponent.h"
 #include "Kismet/KismetSystemLibrary.h"
@@ -15,7 +15,7 @@
 ABuildable::ABuildable()
 {
  	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bCanEverTick = false;
 
 	SceneComponent = CreateDefaultSubobject<USceneComponent>("Root");
 	SetRootComponent(SceneComponent);
@@ -27,8 +27,9 @@ ABuildable::ABuildable()
 	
 	BuildingBounds = CreateDefaultSubobject<UBoxComponent>("Building Bounds");
     BuildingBounds->SetupAttachment(StaticMeshComponent);
-    BuildingBounds->SetCollisionProfileName("OverlapAll");
-    BuildingBounds->SetGenerateOverlapEvents(true);
+	// Only used for its size, everything it used to overlap is found through the build grid or the resource field.
+	BuildingBounds->SetCollisionProfileName("NoCollision");
+	BuildingBounds->SetGenerateOverlapEvents(false);
 	BuildingBounds->SetLineThickness(20.0f);
 
 	BuildableStateChangedDelegate.AddUniqueDynamic(this, &ThisClass::OnBuildableStateChanged);
@@ -56,8 +57,6 @@ void ABuildable::BeginPlay()
 	}
 
 	BuildingBounds->SetBoxExtent(FVector(BuildingBounds->GetScaledBoxExtent().X - 5, BuildingBounds->GetScaledBoxExtent().Y - 5, BuildingBounds->GetScaledBoxExtent().Z - 5));
-	BuildingBounds->OnComponentBeginOverlap.AddDynamic(this, &ThisClass::OnOverlapBegin);
-	BuildingBounds->OnComponentEndOverlap.AddDynamic(this, &ThisClass::OnOverlapEnd);
 
 	GetStrategyGameState()->OnTimeScaleChanged.AddUniqueDynamic(this, &ThisClass::OnTimeScaleChanged);
 }
@@ -93,27 +92,16 @@ void ABuildable::OnConstruction(const FTransform& Transform)
 	}
 }
 
-void ABuildable::BeginDestroy()
-{
-	Super::BeginDestroy();
-}
-
-void ABuildable::OnOverlapBegin(UPrimitiveComponent* OverlappedComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
+void ABuildable::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	if (OtherActor->IsA(ABuildExclusionZone::StaticClass()) ||
-		OtherActor->IsA(ABuildable::StaticClass()))
-	{
-		OverlappingExclusionZones.AddUnique(OtherActor);
-	}
+	RemoveFromBuildGrid();
 	
-	UpdateBuildMaterials();
+	Super::EndPlay(EndPlayReason);
 }
 
-void ABuildable::OnOverlapEnd(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex)
+void ABuildable::BeginDestroy()
 {
-	OverlappingExclusionZones.Remove(OtherActor);
-
-	UpdateBuildMaterials();
+	Super::BeginDestroy();
 }
 
 void ABuildable::OnBuildableStateChanged(ABuildable* Buildable, EBuildableState NewBuildableState)
@@ -136,6 +124,15 @@ void ABuildable::OnBuildableStateChanged(ABuildable* Buildable, EBuildableState
 
 void ABuildable::OnTimeScaleChanged(const ETimeScale NewTimeScale)
 {
+	// Construction runs on simulation time, so keep the remaining simulated time the same at the new speed.
+	const float NewSpeed = AStrategyGameState::GetTimeScaleMultiplier(NewTimeScale);
+	if (GetWorldTimerManager().IsTimerActive(ConstructionTimer))
+	{
+		const float RemainingSimulationTime = GetWorldTimerManager().GetTimerRemaining(ConstructionTimer) * ConstructionTimerSpeed;
+		GetWorldTimerManager().SetTimer(ConstructionTimer, this, &ABuildable::CompleteConstruction, RemainingSimulationTime / NewSpeed);
+	}
+	ConstructionTimerSpeed = NewSpeed;
+
 	BP_OnTimeScaleChanged(NewTimeScale);
 }
 
@@ -150,22 +147,67 @@ bool ABuildable::Recycle_Implementation(ARTSCamera* RecycleInstigator)
 	return true;
 }
 
+void ABuildable::OnAcquiredFromPool_Implementation()
+{
+	Super::OnAcquiredFromPool_Implementation();
+
+	LastBuildGridFootprint.Reset();
+	UpdateBuildMaterials();
+}
+
+void ABuildable::OnReturnedToPool_Implementation()
+{
+	Super::OnReturnedToPool_Implementation();
+
+	GetWorldTimerManager().ClearTimer(ConstructionTimer);
+	RemoveFromBuildGrid();
+	BuildingBounds->SetHiddenInGame(true);
+}
+
 void ABuildable::MoveBuilding(FVector NewLocation)
 {
 	SetActorLocation(NewLocation);
+
+	// The ghost can only become blocked or unblocked when it moves onto different cells.
+	TArray<FIntRect> Footprint;
+	GetBuildGridFootprint(Footprint);
+	if (Footprint != LastBuildGridFootprint)
+	{
+		LastBuildGridFootprint = MoveTemp(Footprint);
+		UpdateBuildMaterials();
+	}
 }
 
 void ABuildable::PlaceBuilding()
 {
 	if (!IsBuildingPermitted()) return;
+
+	// Checked before spawning, so clicking without enough materials doesn't spawn and destroy an actor each time.
+	if (!CanAffordConstruction())
+	{
+		GEngine->AddOnScreenDebugMessage(801, 3.0f, FColor::Red, "Not enough materials to build " + GetDisplayName());
+		return;
+	}
 	
 	ABuildable* NewStructure = GetWorld()->SpawnActor<ABuildable>(GetClass(), GetActorTransform());
-	NewStructure->BeginConstruction();
+	if (!NewStructure->BeginConstruction()) NewStructure->Destroy();
 }
 
-void ABuildable::BeginConstruction()
+bool ABuildable::BeginConstruction()
 {
-	ConsumeConstructionResources();
+	if (!ConsumeConstructionResources())
+	{
+		GEngine->AddOnScreenDebugMessage(801, 3.0f, FColor::Red, "Not enough materials to build " + GetDisplayName());
+		return false;
+	}
+
+	StartConstruction();
+	return true;
+}
+
+void ABuildable::StartConstruction()
+{
+	AddToBuildGrid();
 	
 	if (TimeToCompleteConstruction == 0)
 	{
@@ -173,12 +215,42 @@ void ABuildable::BeginConstruction()
 		return;
 	}
 
-	GetWorldTimerManager().SetTimer(ConstructionTimer, this, &ABuildable::CompleteConstruction, TimeToCompleteConstruction);
+	ConstructionTimerSpeed = GetStrategyGameState()->GetSimulationSpeed();
+	GetWorldTimerManager().SetTimer(ConstructionTimer, this, &ABuildable::CompleteConstruction, TimeToCompleteConstruction / ConstructionTimerSpeed);
 	
 	SetBuildableState(EBuildableState::UnderConstruction);
 	UpdateBuildMaterials();
 }
 
+bool ABuildable::PlaceBuildables(const TArray<ABuildable*>& Buildables)
+{
+	FResourceTransaction Costs;
+	ABuildable* FirstBuildable = nullptr;
+
+	for (ABuildable* Buildable : Buildables)
+	{
+		if (!IsValid(Buildable)) continue;
+
+		if (!FirstBuildable) FirstBuildable = Buildable;
+		Costs.AddCosts(Buildable->ConstructionCost, Buildable->GetConstructionCostCount());
+	}
+
+	if (!FirstBuildable) return false;
+
+	if (!FirstBuildable->GetStrategyGameState()->CommitResourceTransaction(Costs))
+	{
+		GEngine->AddOnScreenDebugMessage(801, 3.0f, FColor::Red, "Not enough materials to build " + FirstBuildable->GetDisplayName());
+		return false;
+	}
+
+	for (ABuildable* Buildable : Buildables)
+	{
+		if (IsValid(Buildable)) Buildable->StartConstruction();
+	}
+
+	return true;
+}
+
 void ABuildable::CancelConstruction()
 {
 	GetWorldTimerManager().ClearTimer(ConstructionTimer);
@@ -187,26 +259,28 @@ void ABuildable::CancelConstruction()
 	Destroy();
 }
 
-void ABuildable::ConsumeConstructionResources()
+bool ABuildable::ConsumeConstructionResources()
 {
-	for (auto Resource : ConstructionCost)
-	{
-		EResourceType ResourceType = Resource.Key;
-		int32 ResourceAmount = Resource.Value;
-		
-		GetStrategyGameState()->ConsumeResources(ResourceType, ResourceAmount);
-	}
+	FResourceTransaction Transaction;
+	Transaction.AddCosts(ConstructionCost, GetConstructionCostCount());
+	
+	return GetStrategyGameState()->CommitResourceTransaction(Transaction);
+}
+
+bool ABuildable::CanAffordConstruction()
+{
+	FResourceTransaction Transaction;
+	Transaction.AddCosts(ConstructionCost, GetConstructionCostCount());
+
+	return GetStrategyGameState()->CanAfford(Transaction);
 }
 
 void ABuildable::RefundConstructionMaterials()
 {
-	for (auto Resource : ConstructionCost)
-	{
-		EResourceType ResourceType = Resource.Key;
-		int32 ResourceAmount = Resource.Value;
-		
-		GetStrategyGameState()->AddResources(ResourceType, ResourceAmount);
-	}
+	FResourceTransaction Transaction;
+	Transaction.AddRefunds(ConstructionCost, GetConstructionCostCount());
+	
+	GetStrategyGameState()->CommitResourceTransaction(Transaction);
 }
 
 void ABuildable::CompleteConstruction()
@@ -217,11 +291,37 @@ void ABuildable::CompleteConstruction()
 
 void ABuildable::Recycle()
 {
-	RefundConstructionMaterials();
+	AStrategyGameState* StrategyGameState = GetStrategyGameState();
+
+	FResourceTransaction Refunds;
+	RecycleInto(Refunds);
+
+	StrategyGameState->CommitResourceTransaction(Refunds);
+}
+
+void ABuildable::RecycleInto(FResourceTransaction& Refunds)
+{
+	Refunds.AddRefunds(ConstructionCost, GetConstructionCostCount());
 	
 	Destroy();
 }
 
+void ABuildable::RecycleBuildables(const TArray<ABuildable*>& Buildables)
+{
+	FResourceTransaction Refunds;
+	AStrategyGameState* StrategyGameState = nullptr;
+
+	for (ABuildable* Buildable : Buildables)
+	{
+		if (!IsValid(Buildable)) continue;
+
+		if (!StrategyGameState) StrategyGameState = Buildable->GetStrategyGameState();
+		Buildable->RecycleInto(Refunds);
+	}
+
+	if (StrategyGameState) StrategyGameState->CommitResourceTransaction(Refunds);
+}
+
 void ABuildable::UpdateBuildMaterials()
 {
 	ensureMsgf(CanBuildMaterial, TEXT("%s ABuildable::UpdateBuildMaterials CanBuildMaterial is not set"), *GetName());
@@ -272,6 +372,69 @@ void ABuildable::UpdateBuildMaterials()
 	}
 }
 
+void ABuildable::GetBuildGridFootprint(TArray<FIntRect>& OutCellRects)
+{
+	UBuildGridSubsystem* BuildGrid = GetBuildGrid();
+	if (!BuildGrid) return;
+
+	// The bounds are snapped to whole cells, insetting them keeps a building from also claiming the cells around its edges.
+	OutCellRects.Add(BuildGrid->WorldBoxToCellRect(BuildingBounds->Bounds.GetBox(), BuildGrid->GetCellSize() * 0.25f));
+}
+
+void ABuildable::AddToBuildGrid()
+{
+	UBuildGridSubsystem* BuildGrid = GetBuildGrid();
+	if (!BuildGrid) return;
+
+	TArray<FIntRect> Footprint;
+	GetBuildGridFootprint(Footprint);
+	BuildGrid->Stamp(this, GetBuildGridLayer(), Footprint);
+}
+
+void ABuildable::RemoveFromBuildGrid()
+{
+	if (UBuildGridSubsystem* BuildGrid = GetBuildGrid()) BuildGrid->Unstamp(this);
+}
+
+bool ABuildable::IsOverlappingBuildExclusionZone()
+{
+	UBuildGridSubsystem* BuildGrid = GetBuildGrid();
+	if (!BuildGrid) return false;
+
+	TArray<FIntRect> Footprint;
+	GetBuildGridFootprint(Footprint);
+	for (const FIntRect& CellRect : Footprint)
+	{
+		if (!BuildGrid->IsAreaFree(CellRect, GetBuildGridBlockingLayers(), this)) return true;
+	}
+
+	return false;
+}
+
+bool ABuildable::IsConnectedToRoad()
+{
+	URoadNetworkSubsystem* RoadNetwork = GetWorld()->GetSubsystem<URoadNetworkSubsystem>();
+	return RoadNetwork && RoadNetwork->IsBuildingConnectedToRoad(this);
+}
+
+TArray<AActor*> ABuildable::GetOverlappingBuildExclusionZones()
+{
+	TArray<AActor*> OverlappingActors;
+
+	UBuildGridSubsystem* BuildGrid = GetBuildGrid();
+	if (!BuildGrid) return OverlappingActors;
+
+	TArray<FIntRect> Footprint;
+	GetBuildGridFootprint(Footprint);
+	for (const FIntRect& CellRect : Footprint)
+	{
+		BuildGrid->GetOwnersInArea(CellRect, GetBuildGridBlockingLayers(), OverlappingActors);
+	}
+
+	OverlappingActors.Remove(this);
+	return TSet<AActor*>(OverlappingActors).Array();
+}
+
 bool ABuildable::IsBuildingPermitted()
 {
 	if (!HaveEnoughResourcesToBuild() && IsBeingCreated())
@@ -291,17 +454,9 @@ bool ABuildable::IsBuildingPermitted()
 
 bool ABuildable::HaveEnoughResourcesToBuild()
 {
-	for (TPair ResourceCost : ConstructionCost)
-	{
-		EResourceType ResourceType = ResourceCost.Key;
-		int32 AmountNeeded = ResourceCost.Value;
-		
-		if (GetStrategyGameState()->GetResourceAmount(ResourceType) < AmountNeeded)
-		{
-			return false;
-		}
-	}
+	FResourceTransaction Transaction;
+	Transaction.AddCosts(ConstructionCost, GetConstructionCostCount());
 
-	return true;
+	return GetStrategyGameState()->CanAfford(Transaction);
 }
 
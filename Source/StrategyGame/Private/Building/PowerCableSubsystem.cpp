@@ -0,0 +1,203 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Building/PowerCableSubsystem.h"
+
+#include "StrategyGame.h"
+#include "Building/PowerLine.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Rendering/InstancedRenderActor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Power Cable Upload"), STAT_PowerCableUpload, STATGROUP_StrategyGame);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Power Cables"), STAT_PowerCables, STATGROUP_StrategyGame);
+
+bool UPowerCableSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UPowerCableSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UPowerCableSubsystem, STATGROUP_Tickables);
+}
+
+void UPowerCableSubsystem::Deinitialize()
+{
+	Cables.Empty();
+	PowerLineCables.Empty();
+	SegmentTransforms.Empty();
+	RenderActor = nullptr;
+	InstancedMesh = nullptr;
+
+	Super::Deinitialize();
+}
+
+UInstancedStaticMeshComponent* UPowerCableSubsystem::GetInstancedMesh(const APowerLine* PowerLine)
+{
+	if (InstancedMesh || !PowerLine->GetCableMesh()) return InstancedMesh;
+
+	if (!RenderActor)
+	{
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.ObjectFlags |= RF_Transient;
+		RenderActor = GetWorld()->SpawnActor<AInstancedRenderActor>(SpawnParameters);
+	}
+	if (!RenderActor) return nullptr;
+
+	InstancedMesh = RenderActor->GetInstancedMesh(PowerLine->GetCableMesh());
+	InstancedMesh->SetNumCustomDataFloats(1);
+	if (PowerLine->GetCableMaterial()) InstancedMesh->SetMaterial(0, PowerLine->GetCableMaterial());
+
+	return InstancedMesh;
+}
+
+void UPowerCableSubsystem::BuildCableSegments(int32 CableIndex)
+{
+	const FPowerCable& Cable = Cables[CableIndex];
+	const FVector Start = Cable.PowerLineA->GetCableAttachLocation();
+	const FVector End = Cable.PowerLineB->GetCableAttachLocation();
+
+	// A parabola is close enough to a hanging cable at these spans.
+	const float Sag = FVector::Dist(Start, End) * Cable.PowerLineA->GetCableSag();
+	const float ThicknessScale = Cable.PowerLineA->GetCableThickness() / APowerLine::CableMeshSize;
+
+	auto PointOnCable = [&](float Alpha)
+	{
+		return FMath::Lerp(Start, End, Alpha) - FVector(0.0f, 0.0f, 4.0f * Sag * Alpha * (1.0f - Alpha));
+	};
+
+	FVector SegmentStart = Start;
+	for (int32 Segment = 0; Segment < CableSegments; Segment++)
+	{
+		const FVector SegmentEnd = PointOnCable(static_cast<float>(Segment + 1) / CableSegments);
+		const FVector Delta = SegmentEnd - SegmentStart;
+
+		SegmentTransforms[CableIndex * CableSegments + Segment] = FTransform(Delta.Rotation(), (SegmentStart + SegmentEnd) * 0.5f,
+			FVector(Delta.Size() / APowerLine::CableMeshSize, ThicknessScale, ThicknessScale));
+
+		SegmentStart = SegmentEnd;
+	}
+
+	bGeometryDirty = true;
+}
+
+void UPowerCableSubsystem::AddCable(APowerLine* PowerLineA, APowerLine* PowerLineB)
+{
+	if (!PowerLineA || !PowerLineB || PowerLineA == PowerLineB) return;
+
+	if (const TArray<int32>* Existing = PowerLineCables.Find(PowerLineA))
+	{
+		for (const int32 CableIndex : *Existing)
+		{
+			const FPowerCable& Cable = Cables[CableIndex];
+			if (Cable.PowerLineA == PowerLineB || Cable.PowerLineB == PowerLineB) return;
+		}
+	}
+
+	if (!GetInstancedMesh(PowerLineA)) return;
+
+	FPowerCable Cable;
+	Cable.PowerLineA = PowerLineA;
+	Cable.PowerLineB = PowerLineB;
+	Cable.bPowered = PowerLineA->IsConnectedToPower();
+
+	const int32 CableIndex = Cables.Add(Cable);
+	PowerLineCables.FindOrAdd(PowerLineA).Add(CableIndex);
+	PowerLineCables.FindOrAdd(PowerLineB).Add(CableIndex);
+
+	SegmentTransforms.AddDefaulted(CableSegments);
+	BuildCableSegments(CableIndex);
+}
+
+void UPowerCableSubsystem::RemoveCableAt(int32 CableIndex)
+{
+	auto RemoveFromPowerLine = [this](APowerLine* PowerLine, int32 Index)
+	{
+		TArray<int32>* Indices = PowerLineCables.Find(PowerLine);
+		if (!Indices) return;
+
+		Indices->RemoveSingleSwap(Index, EAllowShrinking::No);
+		if (Indices->IsEmpty()) PowerLineCables.Remove(PowerLine);
+	};
+
+	RemoveFromPowerLine(Cables[CableIndex].PowerLineA, CableIndex);
+	RemoveFromPowerLine(Cables[CableIndex].PowerLineB, CableIndex);
+
+	const int32 LastIndex = Cables.Num() - 1;
+	if (CableIndex != LastIndex)
+	{
+		for (APowerLine* PowerLine : { Cables[LastIndex].PowerLineA, Cables[LastIndex].PowerLineB })
+		{
+			if (TArray<int32>* Indices = PowerLineCables.Find(PowerLine))
+			{
+				Indices->Remove(LastIndex);
+				Indices->Add(CableIndex);
+			}
+		}
+
+		Cables[CableIndex] = Cables[LastIndex];
+		for (int32 Segment = 0; Segment < CableSegments; Segment++)
+		{
+			SegmentTransforms[CableIndex * CableSegments + Segment] = SegmentTransforms[LastIndex * CableSegments + Segment];
+		}
+	}
+
+	Cables.RemoveAt(LastIndex, 1, EAllowShrinking::No);
+	SegmentTransforms.SetNum(Cables.Num() * CableSegments, EAllowShrinking::No);
+
+	bGeometryDirty = true;
+}
+
+void UPowerCableSubsystem::RemoveCables(APowerLine* PowerLine)
+{
+	while (const TArray<int32>* Indices = PowerLineCables.Find(PowerLine))
+	{
+		RemoveCableAt(Indices->Last());
+	}
+}
+
+void UPowerCableSubsystem::UpdateCableColours(APowerLine* PowerLine)
+{
+	const TArray<int32>* Indices = PowerLineCables.Find(PowerLine);
+	if (!Indices) return;
+
+	// Both ends of a cable are always in the same network.
+	const bool bPowered = PowerLine->IsConnectedToPower();
+	for (const int32 CableIndex : *Indices)
+	{
+		if (Cables[CableIndex].bPowered == bPowered) continue;
+
+		Cables[CableIndex].bPowered = bPowered;
+		bColoursDirty = true;
+	}
+}
+
+void UPowerCableSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (bGeometryDirty || bColoursDirty) UploadInstances();
+}
+
+void UPowerCableSubsystem::UploadInstances()
+{
+	SCOPE_CYCLE_COUNTER(STAT_PowerCableUpload);
+	SET_DWORD_STAT(STAT_PowerCables, Cables.Num());
+
+	if (!InstancedMesh) return;
+
+	if (bGeometryDirty) AInstancedRenderActor::UpdateInstances(InstancedMesh, SegmentTransforms);
+
+	for (int32 CableIndex = 0; CableIndex < Cables.Num(); CableIndex++)
+	{
+		const float Powered = Cables[CableIndex].bPowered ? 1.0f : 0.0f;
+		for (int32 Segment = 0; Segment < CableSegments; Segment++)
+		{
+			InstancedMesh->SetCustomDataValue(CableIndex * CableSegments + Segment, 0, Powered, false);
+		}
+	}
+	InstancedMesh->MarkRenderStateDirty();
+
+	bGeometryDirty = false;
+	bColoursDirty = false;
+}
@@ -3,69 +3,123 @@
 
 #include "Building/PowerLine.h"
 
+#include "Building/PowerCableSubsystem.h"
 #include "Components/ArrowComponent.h"
+#include "Game/PowerNetworkSubsystem.h"
 
 
 // Sets default values
 APowerLine::APowerLine()
 {
 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bCanEverTick = false;
 
 	Sphere = CreateDefaultSubobject<USphereComponent>("Sphere");
 	Sphere->SetupAttachment(StaticMeshComponent);
 	Sphere->SetHiddenInGame(false);
 	Sphere->SetCollisionProfileName("PowerTrigger");
-	Sphere->OnComponentBeginOverlap.AddUniqueDynamic(this, &ThisClass::OnPowerOverlapBegin);
-	Sphere->OnComponentEndOverlap.AddUniqueDynamic(this, &ThisClass::OnPowerOverlapEnd);
+	Sphere->SetGenerateOverlapEvents(false);
 
 	PowerLineArrow = CreateDefaultSubobject<UArrowComponent>("Power Line Pos");
 	PowerLineArrow->SetupAttachment(StaticMeshComponent);
+
+	static ConstructorHelpers::FObjectFinder<UStaticMesh> CableMeshFinder(TEXT("/Engine/BasicShapes/Cube.Cube"));
+	if (CableMeshFinder.Succeeded()) CableMesh = CableMeshFinder.Object;
 }
 
 // Called when the game starts or when spawned
 void APowerLine::BeginPlay()
 {
 	Super::BeginPlay();
-	
+
+	GetRootComponent()->TransformUpdated.AddUObject(this, &ThisClass::OnPowerLineMoved);
 }
 
-void APowerLine::OnOverlapBegin(UPrimitiveComponent* OverlappedComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
+void APowerLine::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	
+	LeavePowerNetwork();
+
+	Super::EndPlay(EndPlayReason);
 }
 
-void APowerLine::OnOverlapEnd(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex)
+void APowerLine::OnReturnedToPool_Implementation()
 {
-	
+	LeavePowerNetwork();
+
+	Super::OnReturnedToPool_Implementation();
+}
+
+void APowerLine::CompleteConstruction()
+{
+	Super::CompleteConstruction();
+
+	JoinPowerNetwork();
 }
 
-void APowerLine::OnPowerOverlapBegin(UPrimitiveComponent* OverlappedComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
+void APowerLine::JoinPowerNetwork()
 {
-	if (OtherActor && OtherActor->Implements<UPowerInterface>())
+	UPowerNetworkSubsystem* PowerNetwork = GetWorld()->GetSubsystem<UPowerNetworkSubsystem>();
+	if (!PowerNetwork) return;
+
+	PowerNetwork->RegisterNode(this);
+
+	UPowerCableSubsystem* PowerCables = GetWorld()->GetSubsystem<UPowerCableSubsystem>();
+	if (!PowerCables) return;
+
+	TArray<AActor*> LinkedNodes;
+	PowerNetwork->GetLinkedNodes(this, LinkedNodes);
+	for (AActor* LinkedNode : LinkedNodes)
 	{
-		Execute_ConnectPower(OtherActor, this);
+		if (APowerLine* LinkedPowerLine = Cast<APowerLine>(LinkedNode)) PowerCables->AddCable(this, LinkedPowerLine);
 	}
 }
 
-void APowerLine::OnPowerOverlapEnd(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex)
+void APowerLine::LeavePowerNetwork()
 {
-	if (OtherActor && OtherActor->Implements<UPowerInterface>())
+	if (UPowerNetworkSubsystem* PowerNetwork = GetWorld()->GetSubsystem<UPowerNetworkSubsystem>())
+	{
+		PowerNetwork->UnregisterNode(this);
+	}
+	if (UPowerCableSubsystem* PowerCables = GetWorld()->GetSubsystem<UPowerCableSubsystem>())
 	{
-		Execute_DisconnectPower(OtherActor, this);
+		PowerCables->RemoveCables(this);
 	}
+	ConnectedToPower = false;
 }
 
-bool APowerLine::ConnectPower_Implementation(APowerLine* PowerLine)
+void APowerLine::OnPowerLineMoved(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	const UPowerNetworkSubsystem* PowerNetwork = GetWorld()->GetSubsystem<UPowerNetworkSubsystem>();
+	if (!PowerNetwork || !PowerNetwork->IsRegistered(this)) return;
+
+	// Leaving and joining again picks up the links in range of the new location, and rebuilds the cables with them.
+	LeavePowerNetwork();
+	JoinPowerNetwork();
+}
+
+void APowerLine::OnOverlapBegin(UPrimitiveComponent* OverlappedComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
+{
+	
+}
+
+void APowerLine::OnOverlapEnd(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex)
 {
-	SetPowerFeeder(PowerLine);
 	
-	return true;
+}
+
+// Links come from the power network's range check, so connecting only makes sure this power line is in the graph.
+bool APowerLine::ConnectPower_Implementation(APowerLine* PowerLine)
+{
+	UPowerNetworkSubsystem* PowerNetwork = GetWorld()->GetSubsystem<UPowerNetworkSubsystem>();
+	if (!PowerNetwork || !IsConstructionComplete()) return false;
+
+	if (!PowerNetwork->IsRegistered(this)) JoinPowerNetwork();
+	return PowerNetwork->AreConnected(this, PowerLine);
 }
 
 bool APowerLine::DisconnectPower_Implementation(APowerLine* PowerLine)
 {
-	ClearPowerFeeder();
+	LeavePowerNetwork();
 	
 	return true;
 }
@@ -75,24 +129,17 @@ bool APowerLine::GetIsConnectedToPowerSource_Implementation()
 	return IsConnectedToPower();
 }
 
-// Called every frame
-void APowerLine::Tick(float DeltaTime)
+float APowerLine::GetPowerConnectionRadius_Implementation()
 {
-	Super::Tick(DeltaTime);
+	return Sphere->GetScaledSphereRadius();
+}
+
+void APowerLine::OnPowerNetworkChanged_Implementation(bool bConnectedToPowerSource, float Satisfaction)
+{
+	ConnectedToPower = bConnectedToPowerSource;
 
-	if (PowerTarget)
+	if (UPowerCableSubsystem* PowerCables = GetWorld()->GetSubsystem<UPowerCableSubsystem>())
 	{
-		FVector StartPos = PowerLineArrow->GetComponentLocation();
-		FVector EndPos = PowerTarget->PowerLineArrow->GetComponentLocation();
-
-		if (IsConnectedToPower())
-		{
-			DrawDebugLine(GetWorld(), StartPos, EndPos, FColor::Yellow, false, -1, 0, 50.0f);
-		}
-		else
-		{
-			DrawDebugLine(GetWorld(), StartPos, EndPos, FColor::White, false, -1, 0, 50.0f);
-		}		
+		PowerCables->UpdateCableColours(this);
 	}
 }
-
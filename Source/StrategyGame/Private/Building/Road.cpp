@@ -3,6 +3,8 @@
 
 #include "Building/Road.h"
 
+#include "Building/RoadNetworkSubsystem.h"
+
 
 // Sets default values
 ARoad::ARoad()
@@ -18,38 +20,202 @@ ARoad::ARoad()
 void ARoad::BeginPlay()
 {
 	Super::BeginPlay();
+
+	SegmentCollision = SplineMesh->GetCollisionEnabled();
+	UpdateSegmentMeshes();
 }
 
-void ARoad::MoveBuilding(FVector NewLocation)
+void ARoad::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	if (RoadStartPos != FVector::ZeroVector)
+	if (URoadNetworkSubsystem* RoadNetwork = GetWorld()->GetSubsystem<URoadNetworkSubsystem>())
 	{
-		RoadEndPos = NewLocation;
-		
-		SplineMesh->SetStartPosition(RoadStartPos);
-		SplineMesh->SetEndPosition(RoadEndPos);
+		RoadNetwork->UnregisterRoad(this);
 	}
-	else
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ARoad::MoveBuilding(FVector NewLocation)
+{
+	if (RoadPoints.IsEmpty())
 	{
 		SetActorLocation(NewLocation);
+		return;
 	}
+
+	if (NewLocation == RoadEndPos) return;
+	RoadEndPos = NewLocation;
+
+	// Only the segment following the cursor changes.
+	UpdateSegmentMeshes(RoadPoints.Num() - 1);
 }
 
 void ARoad::PlaceBuilding()
 {
-	if (RoadStartPos == FVector::ZeroVector)
+	if (RoadPoints.IsEmpty())
 	{
-		RoadStartPos = GetActorLocation();
+		RoadPoints.Add(GetActorLocation());
+		RoadEndPos = GetActorLocation();
 		StaticMeshComponent->SetHiddenInGame(true);
-		SplineMesh->SetHiddenInGame(false);
+		return;
+	}
+
+	if (RoadEndPos == RoadPoints.Last())
+	{
+		FinishRoad();
+		return;
 	}
-	else if (RoadEndPos != FVector::ZeroVector)
+
+	if (!IsBuildingPermitted()) return;
+
+	AddRoadPoint(RoadEndPos);
+	UpdateSegmentMeshes(FMath::Max(RoadPoints.Num() - 2, 0));
+}
+
+void ARoad::AddRoadPoint(const FVector& Point)
+{
+	const int32 NumPoints = RoadPoints.Num();
+	if (NumPoints >= 2)
 	{
-		FActorSpawnParameters SpawnParameters;
-		SpawnParameters.Template = this;
-		ARoad* NewRoad = GetWorld()->SpawnActor<ARoad>(GetClass(), GetActorTransform(), SpawnParameters);
-		NewRoad->BeginConstruction();
+		const FVector LastDirection = (RoadPoints[NumPoints - 1] - RoadPoints[NumPoints - 2]).GetSafeNormal();
+		const FVector NewDirection = (Point - RoadPoints[NumPoints - 1]).GetSafeNormal();
+
+		if (FVector::DotProduct(LastDirection, NewDirection) > 0.9999f)
+		{
+			RoadPoints.Last() = Point;
+			return;
+		}
 	}
+
+	RoadPoints.Add(Point);
+}
+
+void ARoad::FinishRoad()
+{
+	// The segment following the cursor isn't part of the road until it's clicked.
+	if (!RoadPoints.IsEmpty()) RoadEndPos = RoadPoints.Last();
+	if (RoadPoints.Num() < 2) return;
+
+	// Checked before spawning, so a road that can't be afforded doesn't spawn its chunks only to destroy them again.
+	if (!CanAffordConstruction())
+	{
+		GEngine->AddOnScreenDebugMessage(801, 3.0f, FColor::Red, "Not enough materials to build " + GetDisplayName());
+		return;
+	}
+
+	// Chunks share their end points, so they meet on the same cell and join up in the road network.
+	const int32 NumSegments = RoadPoints.Num() - 1;
+	TArray<ABuildable*> Chunks;
+	for (int32 FirstSegment = 0; FirstSegment < NumSegments; FirstSegment += MaxSegmentsPerRoad)
+	{
+		const int32 ChunkSegments = FMath::Min(MaxSegmentsPerRoad, NumSegments - FirstSegment);
+		TArrayView<const FVector> ChunkPoints(RoadPoints.GetData() + FirstSegment, ChunkSegments + 1);
+
+		ARoad* NewRoad = GetWorld()->SpawnActor<ARoad>(GetClass(), FTransform(GetActorRotation(), ChunkPoints[0]));
+		if (!NewRoad) continue;
+
+		NewRoad->SetRoadPoints(ChunkPoints);
+		Chunks.Add(NewRoad);
+	}
+
+	// The whole road is paid for in one transaction, so it's either built in full or not at all.
+	if (!PlaceBuildables(Chunks))
+	{
+		for (ABuildable* Chunk : Chunks) Chunk->Destroy();
+	}
+
+	RoadPoints.Reset();
+	StaticMeshComponent->SetHiddenInGame(false);
+	UpdateSegmentMeshes();
+}
+
+void ARoad::SetRoadPoints(TArrayView<const FVector> NewPoints)
+{
+	RoadPoints.Reset();
+	RoadPoints.Append(NewPoints.GetData(), NewPoints.Num());
+	if (RoadPoints.IsEmpty()) return;
+
+	RoadEndPos = RoadPoints.Last();
+	SetActorLocation(RoadPoints[0]);
+	StaticMeshComponent->SetHiddenInGame(true);
+	UpdateSegmentMeshes();
+}
+
+void ARoad::GetRoadPolyline(TArray<FVector>& OutPoints)
+{
+	OutPoints = RoadPoints;
+
+	if (IsBeingCreated() && !RoadPoints.IsEmpty() && RoadEndPos != RoadPoints.Last())
+	{
+		OutPoints.Add(RoadEndPos);
+	}
+}
+
+USplineMeshComponent* ARoad::GetSegmentMesh(int32 SegmentIndex)
+{
+	if (SegmentMeshes.IsEmpty()) SegmentMeshes.Add(SplineMesh);
+
+	while (SegmentMeshes.Num() <= SegmentIndex)
+	{
+		USplineMeshComponent* Segment = NewObject<USplineMeshComponent>(this, NAME_None, RF_Transient);
+		Segment->SetMobility(SplineMesh->Mobility);
+		Segment->SetForwardAxis(SplineMesh->ForwardAxis, false);
+		Segment->SetStaticMesh(SplineMesh->GetStaticMesh());
+		for (int32 MaterialIndex = 0; MaterialIndex < SplineMesh->GetNumMaterials(); MaterialIndex++)
+		{
+			Segment->SetMaterial(MaterialIndex, SplineMesh->GetMaterial(MaterialIndex));
+		}
+		Segment->SetCollisionProfileName(SplineMesh->GetCollisionProfileName());
+		Segment->SetupAttachment(SceneComponent);
+		Segment->RegisterComponent();
+		AddInstanceComponent(Segment);
+
+		SegmentMeshes.Add(Segment);
+	}
+
+	return SegmentMeshes[SegmentIndex];
+}
+
+void ARoad::UpdateSegmentMeshes(int32 FirstSegment)
+{
+	TArray<FVector> Points;
+	GetRoadPolyline(Points);
+
+	const int32 NumSegments = FMath::Max(Points.Num() - 1, 0);
+	const FTransform& ActorTransform = GetActorTransform();
+
+	for (int32 SegmentIndex = FirstSegment; SegmentIndex < NumSegments; SegmentIndex++)
+	{
+		const FVector Start = ActorTransform.InverseTransformPosition(Points[SegmentIndex]);
+		const FVector End = ActorTransform.InverseTransformPosition(Points[SegmentIndex + 1]);
+
+		USplineMeshComponent* Segment = GetSegmentMesh(SegmentIndex);
+		Segment->SetStartAndEnd(Start, End - Start, End, End - Start);
+		Segment->SetHiddenInGame(false);
+		Segment->SetCollisionEnabled(SegmentCollision);
+	}
+
+	// Unused segments are kept for when the road is drawn again from the pool.
+	for (int32 SegmentIndex = FMath::Max(FirstSegment, NumSegments); SegmentIndex < SegmentMeshes.Num(); SegmentIndex++)
+	{
+		SegmentMeshes[SegmentIndex]->SetHiddenInGame(true);
+		SegmentMeshes[SegmentIndex]->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	}
+}
+
+void ARoad::OnReturnedToPool_Implementation()
+{
+	if (URoadNetworkSubsystem* RoadNetwork = GetWorld()->GetSubsystem<URoadNetworkSubsystem>())
+	{
+		RoadNetwork->UnregisterRoad(this);
+	}
+
+	Super::OnReturnedToPool_Implementation();
+
+	RoadPoints.Reset();
+	RoadEndPos = FVector::ZeroVector;
+	StaticMeshComponent->SetHiddenInGame(false);
+	UpdateSegmentMeshes();
 }
 
 void ARoad::UpdateBuildMaterials()
@@ -57,14 +223,58 @@ void ARoad::UpdateBuildMaterials()
 	
 }
 
-// Called every frame
-void ARoad::Tick(float DeltaTime)
+void ARoad::CompleteConstruction()
 {
-	Super::Tick(DeltaTime);
+	Super::CompleteConstruction();
 
-	if (IsBeingCreated() && RoadStartPos != FVector::ZeroVector)
+	if (URoadNetworkSubsystem* RoadNetwork = GetWorld()->GetSubsystem<URoadNetworkSubsystem>())
 	{
-		RoadEndPos = GetActorLocation();
+		RoadNetwork->RegisterRoad(this);
 	}
 }
 
+int32 ARoad::GetConstructionCostCount()
+{
+	TArray<FVector> Points;
+	GetRoadPolyline(Points);
+
+	return FMath::Max(Points.Num() - 1, 1);
+}
+
+void ARoad::GetRoadCells(TArray<FIntPoint>& OutCells)
+{
+	UBuildGridSubsystem* BuildGrid = GetBuildGrid();
+	if (!BuildGrid) return;
+
+	TArray<FVector> Points;
+	GetRoadPolyline(Points);
+
+	if (Points.Num() < 2)
+	{
+		OutCells.Add(BuildGrid->WorldToCell(GetActorLocation()));
+		return;
+	}
+
+	// The points are already snapped to the grid, so they land on the same cells as the roads they meet.
+	TArray<FIntPoint> SegmentCells;
+	for (int32 PointIndex = 1; PointIndex < Points.Num(); PointIndex++)
+	{
+		SegmentCells.Reset();
+		UBuildGridSubsystem::RasterizeLine(BuildGrid->WorldToCell(Points[PointIndex - 1]), BuildGrid->WorldToCell(Points[PointIndex]), SegmentCells);
+
+		// Each segment starts on the cell the last one ended on.
+		const int32 FirstCell = OutCells.IsEmpty() || SegmentCells.IsEmpty() || SegmentCells[0] != OutCells.Last() ? 0 : 1;
+		OutCells.Append(SegmentCells.GetData() + FirstCell, SegmentCells.Num() - FirstCell);
+	}
+}
+
+void ARoad::GetBuildGridFootprint(TArray<FIntRect>& OutCellRects)
+{
+	TArray<FIntPoint> Cells;
+	GetRoadCells(Cells);
+
+	for (const FIntPoint& Cell : Cells)
+	{
+		OutCellRects.Add(FIntRect(Cell, Cell + FIntPoint(1, 1)));
+	}
+}
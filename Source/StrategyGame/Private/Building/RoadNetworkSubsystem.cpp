@@ -0,0 +1,354 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Building/RoadNetworkSubsystem.h"
+
+#include "EngineUtils.h"
+#include "StrategyGame.h"
+#include "Algo/Reverse.h"
+#include "Building/BuildGridSubsystem.h"
+#include "Building/Road.h"
+
+DECLARE_CYCLE_STAT(TEXT("Road Relabel Components"), STAT_RoadRelabelComponents, STATGROUP_StrategyGame);
+DECLARE_CYCLE_STAT(TEXT("Road Path Search"), STAT_RoadPathSearch, STATGROUP_StrategyGame);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Road Path Cache Hits"), STAT_RoadPathCacheHits, STATGROUP_StrategyGame);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Road Path Cache Misses"), STAT_RoadPathCacheMisses, STATGROUP_StrategyGame);
+
+bool URoadNetworkSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void URoadNetworkSubsystem::Deinitialize()
+{
+	Nodes.Empty();
+	NodeIndices.Empty();
+	FreeNodes.Empty();
+	RoadCells.Empty();
+	PathCache.Empty();
+	CityCore = nullptr;
+
+	Super::Deinitialize();
+}
+
+void URoadNetworkSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	for (TActorIterator<ARoad> It(&InWorld); It; ++It)
+	{
+		if (It->IsConstructionComplete()) RegisterRoad(*It);
+	}
+}
+
+int32 URoadNetworkSubsystem::AddRoadToCell(const FIntPoint& Cell)
+{
+	if (const int32* Existing = NodeIndices.Find(Cell))
+	{
+		Nodes[*Existing].RoadCount++;
+		return *Existing;
+	}
+
+	const int32 NodeIndex = FreeNodes.IsEmpty() ? Nodes.AddDefaulted() : FreeNodes.Pop(EAllowShrinking::No);
+
+	FRoadNode& Node = Nodes[NodeIndex];
+	Node = FRoadNode();
+	Node.Cell = Cell;
+	Node.RoadCount = 1;
+	Node.Parent = NodeIndex;
+	Node.Epoch = ++EpochCounter;
+
+	NodeIndices.Add(Cell, NodeIndex);
+	return NodeIndex;
+}
+
+int32 URoadNetworkSubsystem::FindRoot(int32 NodeIndex) const
+{
+	// Path halving, every other node on the way up is pointed at its grandparent.
+	while (Nodes[NodeIndex].Parent != NodeIndex)
+	{
+		const int32 Parent = Nodes[NodeIndex].Parent;
+		Nodes[NodeIndex].Parent = Nodes[Parent].Parent;
+		NodeIndex = Parent;
+	}
+	return NodeIndex;
+}
+
+void URoadNetworkSubsystem::Union(int32 NodeA, int32 NodeB)
+{
+	int32 RootA = FindRoot(NodeA);
+	int32 RootB = FindRoot(NodeB);
+	if (RootA == RootB) return;
+
+	if (Nodes[RootA].Size < Nodes[RootB].Size) Swap(RootA, RootB);
+
+	Nodes[RootB].Parent = RootA;
+	Nodes[RootA].Size += Nodes[RootB].Size;
+	Nodes[RootA].Epoch = ++EpochCounter;
+}
+
+void URoadNetworkSubsystem::RegisterRoad(ARoad* Road)
+{
+	if (!Road || RoadCells.Contains(Road)) return;
+
+	TArray<FIntPoint>& Cells = RoadCells.Add(Road);
+	Road->GetRoadCells(Cells);
+
+	int32 PreviousNode = INDEX_NONE;
+	for (const FIntPoint& Cell : Cells)
+	{
+		const int32 NodeIndex = AddRoadToCell(Cell);
+		if (PreviousNode != INDEX_NONE && PreviousNode != NodeIndex)
+		{
+			Nodes[PreviousNode].Links.Add(NodeIndex);
+			Nodes[NodeIndex].Links.Add(PreviousNode);
+			Union(PreviousNode, NodeIndex);
+		}
+		PreviousNode = NodeIndex;
+	}
+
+	// A road inside a single component can still make its paths shorter.
+	if (PreviousNode != INDEX_NONE) Nodes[FindRoot(PreviousNode)].Epoch = ++EpochCounter;
+}
+
+void URoadNetworkSubsystem::UnregisterRoad(ARoad* Road)
+{
+	TArray<FIntPoint> Cells;
+	if (!RoadCells.RemoveAndCopyValue(Road, Cells)) return;
+
+	int32 PreviousNode = INDEX_NONE;
+	for (const FIntPoint& Cell : Cells)
+	{
+		const int32* NodeIndex = NodeIndices.Find(Cell);
+		if (!NodeIndex) continue;
+
+		if (PreviousNode != INDEX_NONE && PreviousNode != *NodeIndex)
+		{
+			Nodes[PreviousNode].Links.RemoveSingleSwap(*NodeIndex, EAllowShrinking::No);
+			Nodes[*NodeIndex].Links.RemoveSingleSwap(PreviousNode, EAllowShrinking::No);
+		}
+		PreviousNode = *NodeIndex;
+	}
+
+	// Any path from the rest of the component into this road has to come through a cell another road also covers,
+	// so the cells that are left are enough to reach every node the old component had.
+	TArray<int32> Seeds;
+	for (const FIntPoint& Cell : Cells)
+	{
+		const int32 NodeIndex = NodeIndices.FindChecked(Cell);
+		if (--Nodes[NodeIndex].RoadCount > 0)
+		{
+			Seeds.Add(NodeIndex);
+			continue;
+		}
+
+		NodeIndices.Remove(Cell);
+		Nodes[NodeIndex].Links.Reset();
+		FreeNodes.Add(NodeIndex);
+	}
+
+	RelabelComponents(Seeds);
+}
+
+void URoadNetworkSubsystem::RelabelComponents(const TArray<int32>& Seeds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_RoadRelabelComponents);
+
+	SearchStamp++;
+	for (const int32 Seed : Seeds)
+	{
+		if (Nodes[Seed].SearchStamp == SearchStamp) continue;
+
+		Nodes[Seed].SearchStamp = SearchStamp;
+		SearchQueue.Reset();
+		SearchQueue.Add(Seed);
+
+		for (int32 Head = 0; Head < SearchQueue.Num(); Head++)
+		{
+			FRoadNode& Node = Nodes[SearchQueue[Head]];
+			Node.Parent = Seed;
+
+			for (const int32 Link : Node.Links)
+			{
+				if (Nodes[Link].SearchStamp == SearchStamp) continue;
+
+				Nodes[Link].SearchStamp = SearchStamp;
+				SearchQueue.Add(Link);
+			}
+		}
+
+		Nodes[Seed].Size = SearchQueue.Num();
+		Nodes[Seed].Epoch = ++EpochCounter;
+	}
+}
+
+bool URoadNetworkSubsystem::FindPath(const FIntPoint& StartCell, const FIntPoint& GoalCell, TArray<FIntPoint>& OutCells)
+{
+	OutCells.Reset();
+
+	const int32* StartNode = NodeIndices.Find(StartCell);
+	const int32* GoalNode = NodeIndices.Find(GoalCell);
+	if (!StartNode || !GoalNode) return false;
+
+	// Roads that aren't connected are ruled out without searching.
+	const int32 Root = FindRoot(*StartNode);
+	if (Root != FindRoot(*GoalNode)) return false;
+
+	const TPair<FIntPoint, FIntPoint> Key(StartCell, GoalCell);
+	const uint32 Epoch = Nodes[Root].Epoch;
+	if (const FCachedRoadPath* Cached = PathCache.Find(Key))
+	{
+		if (Cached->Epoch == Epoch)
+		{
+			INC_DWORD_STAT(STAT_RoadPathCacheHits);
+			OutCells = Cached->Cells;
+			return true;
+		}
+	}
+
+	INC_DWORD_STAT(STAT_RoadPathCacheMisses);
+	if (!SearchPath(*StartNode, *GoalNode, OutCells)) return false;
+
+	if (PathCache.Num() >= MaxCachedPaths) PathCache.Reset();
+
+	FCachedRoadPath& Cached = PathCache.FindOrAdd(Key);
+	Cached.Cells = OutCells;
+	Cached.Epoch = Epoch;
+	return true;
+}
+
+bool URoadNetworkSubsystem::SearchPath(int32 StartNode, int32 GoalNode, TArray<FIntPoint>& OutCells)
+{
+	SCOPE_CYCLE_COUNTER(STAT_RoadPathSearch);
+
+	const FIntPoint GoalCell = Nodes[GoalNode].Cell;
+	auto Heuristic = [&GoalCell](const FIntPoint& Cell)
+	{
+		const FIntPoint Delta = Cell - GoalCell;
+		return FVector2f(Delta.X, Delta.Y).Size();
+	};
+	auto Predicate = [](const FOpenNode& A, const FOpenNode& B)
+	{
+		return A.Estimate < B.Estimate;
+	};
+
+	SearchStamp++;
+	OpenSet.Reset();
+
+	FRoadNode& Start = Nodes[StartNode];
+	Start.SearchStamp = SearchStamp;
+	Start.PathCost = 0.0f;
+	Start.CameFrom = INDEX_NONE;
+	Start.bClosed = false;
+	OpenSet.HeapPush({ Heuristic(Start.Cell), StartNode }, Predicate);
+
+	bool bFound = false;
+	while (!OpenSet.IsEmpty())
+	{
+		FOpenNode Current;
+		OpenSet.HeapPop(Current, Predicate, EAllowShrinking::No);
+
+		FRoadNode& Node = Nodes[Current.Node];
+		if (Node.bClosed) continue;
+		Node.bClosed = true;
+
+		if (Current.Node == GoalNode)
+		{
+			bFound = true;
+			break;
+		}
+
+		for (const int32 Link : Node.Links)
+		{
+			FRoadNode& Next = Nodes[Link];
+			const FIntPoint Step = Next.Cell - Node.Cell;
+			const float PathCost = Node.PathCost + FVector2f(Step.X, Step.Y).Size();
+
+			if (Next.SearchStamp == SearchStamp && (Next.bClosed || PathCost >= Next.PathCost)) continue;
+
+			Next.SearchStamp = SearchStamp;
+			Next.PathCost = PathCost;
+			Next.CameFrom = Current.Node;
+			Next.bClosed = false;
+			OpenSet.HeapPush({ PathCost + Heuristic(Next.Cell), Link }, Predicate);
+		}
+	}
+
+	if (!bFound) return false;
+
+	for (int32 NodeIndex = GoalNode; NodeIndex != INDEX_NONE; NodeIndex = Nodes[NodeIndex].CameFrom)
+	{
+		OutCells.Add(Nodes[NodeIndex].Cell);
+	}
+	Algo::Reverse(OutCells);
+
+	return true;
+}
+
+bool URoadNetworkSubsystem::FindRoadPath(FVector Start, FVector End, TArray<FVector>& OutPath)
+{
+	OutPath.Reset();
+
+	UBuildGridSubsystem* BuildGrid = GetWorld()->GetSubsystem<UBuildGridSubsystem>();
+	if (!BuildGrid) return false;
+
+	TArray<FIntPoint> Cells;
+	if (!FindPath(BuildGrid->WorldToCell(Start), BuildGrid->WorldToCell(End), Cells)) return false;
+
+	const float CellSize = BuildGrid->GetCellSize();
+	for (const FIntPoint& Cell : Cells)
+	{
+		OutPath.Add(FVector((Cell.X + 0.5f) * CellSize, (Cell.Y + 0.5f) * CellSize, Start.Z));
+	}
+
+	return true;
+}
+
+bool URoadNetworkSubsystem::AreCellsConnected(FIntPoint CellA, FIntPoint CellB) const
+{
+	const int32* NodeA = NodeIndices.Find(CellA);
+	const int32* NodeB = NodeIndices.Find(CellB);
+	return NodeA && NodeB && FindRoot(*NodeA) == FindRoot(*NodeB);
+}
+
+void URoadNetworkSubsystem::GetAdjacentRoots(ABuildable* Building, TArray<int32>& OutRoots)
+{
+	OutRoots.Reset();
+	if (!Building || NodeIndices.IsEmpty()) return;
+
+	TArray<FIntRect> Footprint;
+	Building->GetBuildGridFootprint(Footprint);
+
+	// Roads on the ring of cells around the footprint, or running through it, count as touching it.
+	for (const FIntRect& Rect : Footprint)
+	{
+		for (int32 Y = Rect.Min.Y - 1; Y <= Rect.Max.Y; Y++)
+		{
+			for (int32 X = Rect.Min.X - 1; X <= Rect.Max.X; X++)
+			{
+				if (const int32* NodeIndex = NodeIndices.Find(FIntPoint(X, Y))) OutRoots.AddUnique(FindRoot(*NodeIndex));
+			}
+		}
+	}
+}
+
+bool URoadNetworkSubsystem::IsBuildingConnectedToRoad(ABuildable* Building)
+{
+	TArray<int32> Roots;
+	GetAdjacentRoots(Building, Roots);
+	return !Roots.IsEmpty();
+}
+
+bool URoadNetworkSubsystem::AreBuildingsConnected(ABuildable* BuildingA, ABuildable* BuildingB)
+{
+	TArray<int32> RootsA;
+	TArray<int32> RootsB;
+	GetAdjacentRoots(BuildingA, RootsA);
+	GetAdjacentRoots(BuildingB, RootsB);
+
+	for (const int32 Root : RootsA)
+	{
+		if (RootsB.Contains(Root)) return true;
+	}
+	return false;
+}
@@ -3,6 +3,7 @@
 
 #include "Building/Skyscraper.h"
 
+#include "Game/StructureRegistrySubsystem.h"
 #include "Player/RTSCamera.h"
 
 
@@ -10,7 +11,7 @@
 ASkyscraper::ASkyscraper()
 {
 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bCanEverTick = false;
 }
 
 // Called when the game starts or when spawned
@@ -58,17 +59,19 @@ void ASkyscraper::AddModule(TSubclassOf<ASkyscraperModule> ModuleToAdd)
 
 	NewModule->AttachToComponent(StaticMeshComponent, FAttachmentTransformRules::KeepWorldTransform);
 
+	GetWorld()->GetSubsystem<UStructureRegistrySubsystem>()->RegisterStructure(NewModule);
 	GetStrategyGameState()->OnSkyscraperModuleAdded.Broadcast(this, NewModule);
 }
 
-void ASkyscraper::Recycle()
+void ASkyscraper::RecycleInto(FResourceTransaction& Refunds)
 {
+	// Modules are refunded together with the skyscraper.
 	for (ASkyscraperModule* Module : Modules)
 	{
-		Module->Recycle();
+		Module->RecycleInto(Refunds);
 	}
 	
-	Super::Recycle();
+	Super::RecycleInto(Refunds);
 }
 
 bool ASkyscraper::Select_Implementation(ARTSCamera* SelectInstigator)
@@ -77,10 +80,3 @@ bool ASkyscraper::Select_Implementation(ARTSCamera* SelectInstigator)
 	
 	return true;
 }
-
-// Called every frame
-void ASkyscraper::Tick(float DeltaTime)
-{
-	Super::Tick(DeltaTime);
-}
-
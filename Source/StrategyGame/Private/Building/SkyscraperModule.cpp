@@ -10,8 +10,6 @@
 // Sets default values
 ASkyscraperModule::ASkyscraperModule()
 {
-	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
 }
 
 // Called when the game starts or when spawned
@@ -62,10 +60,3 @@ void ASkyscraperModule::SwitchToDefaultMesh()
 		StaticMeshComponent->SetStaticMesh(DefaultMesh.LoadSynchronous());
 	}
 }
-
-// Called every frame
-void ASkyscraperModule::Tick(float DeltaTime)
-{
-	Super::Tick(DeltaTime);
-}
-
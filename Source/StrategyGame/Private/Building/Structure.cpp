@@ -4,16 +4,20 @@
 #include "Building/Structure.h"
 
 #include "Building/PowerLine.h"
+#include "Building/StructureLabelSubsystem.h"
+#include "Game/EconomySubsystem.h"
+#include "Game/PowerNetworkSubsystem.h"
+#include "Game/ResourceFieldSubsystem.h"
+#include "Game/StructureRegistrySubsystem.h"
 #include "GameFramework/GameSession.h"
-#include "Kismet/KismetMathLibrary.h"
 #include "Player/RTSCamera.h"
 
 
 // Sets default values
 AStructure::AStructure()
 {
-	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	// Labels are turned towards the camera by the structure label subsystem, so structures don't need to tick.
+	PrimaryActorTick.bCanEverTick = false;
 
 	StaticMeshComponent->SetCollisionProfileName("Selectable");
 
@@ -29,35 +33,108 @@ AStructure::AStructure()
 void AStructure::BeginPlay()
 {
 	Super::BeginPlay();
+
+	// The label subsystem keeps the label facing the camera.
+	if (UStructureLabelSubsystem* LabelSubsystem = GetWorld()->GetSubsystem<UStructureLabelSubsystem>())
+	{
+		LabelSubsystem->RegisterLabel(StructureText);
+	}
 }
 
-void AStructure::OnConstruction(const FTransform& Transform)
+void AStructure::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	Super::OnConstruction(Transform);
+	// The game state goes away with the level, so there's only something to give back when the structure alone is destroyed.
+	if (EndPlayReason == EEndPlayReason::Destroyed) DeactivateStructureEffects();
 
-	StructureText->SetText(FText::FromString(DisplayName));
-	StructureText->SetRelativeLocation(FVector(0.0f, 0.0f, BuildingBounds->GetScaledBoxExtent().Z * 2 + 50.0f));
+	RemoveFromWorldSystems();
+
+	Super::EndPlay(EndPlayReason);
 }
 
-void AStructure::OnOverlapBegin(UPrimitiveComponent* OverlappedComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
+void AStructure::RemoveFromWorldSystems()
 {
-	if (OtherActor->IsA(AResourceNode::StaticClass()) &&
-		GetConsumesResourcesFromNearbyNode())
+	ReleaseResourceNode();
+	if (UEconomySubsystem* Economy = GetWorld()->GetSubsystem<UEconomySubsystem>())
 	{
-		AResourceNode* Resource = Cast<AResourceNode>(OtherActor);
-		if (GetResourcesToConsumePerSecond().Contains(Resource->GetResourceType()))
-		{
-			OverlappingResourceNodes.Add(Resource);
-		}
+		Economy->UnregisterStructure(this);
+	}
+	if (UStructureRegistrySubsystem* Registry = GetWorld()->GetSubsystem<UStructureRegistrySubsystem>())
+	{
+		Registry->UnregisterStructure(this);
+	}
+	if (UPowerNetworkSubsystem* PowerNetwork = GetWorld()->GetSubsystem<UPowerNetworkSubsystem>())
+	{
+		PowerNetwork->UnregisterNode(this);
+	}
+	if (UStructureLabelSubsystem* LabelSubsystem = GetWorld()->GetSubsystem<UStructureLabelSubsystem>())
+	{
+		LabelSubsystem->UnregisterLabel(StructureText);
 	}
-	
-	Super::OnOverlapBegin(OverlappedComp, OtherActor, OtherComp, OtherBodyIndex, bFromSweep, SweepResult);
 }
 
-void AStructure::OnOverlapEnd(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex)
+void AStructure::OnAcquiredFromPool_Implementation()
 {
-	Super::OnOverlapEnd(OverlappedComponent, OtherActor, OtherComp, OtherBodyIndex);
-	OverlappingResourceNodes.Remove(OtherActor);
+	Super::OnAcquiredFromPool_Implementation();
+
+	if (UStructureLabelSubsystem* LabelSubsystem = GetWorld()->GetSubsystem<UStructureLabelSubsystem>())
+	{
+		LabelSubsystem->RegisterLabel(StructureText);
+	}
+}
+
+void AStructure::OnReturnedToPool_Implementation()
+{
+	DeactivateStructureEffects();
+
+	RemoveFromWorldSystems();
+
+	Super::OnReturnedToPool_Implementation();
+}
+
+// Links come from the power network's range check, so connecting only makes sure this structure is in the graph.
+bool AStructure::ConnectPower_Implementation(APowerLine* PowerLine)
+{
+	UPowerNetworkSubsystem* PowerNetwork = GetWorld()->GetSubsystem<UPowerNetworkSubsystem>();
+	if (!PowerNetwork || !IsConstructionComplete()) return false;
+
+	PowerNetwork->RegisterNode(this);
+	return PowerNetwork->AreConnected(this, PowerLine);
+}
+
+bool AStructure::DisconnectPower_Implementation(APowerLine* PowerLine)
+{
+	if (UPowerNetworkSubsystem* PowerNetwork = GetWorld()->GetSubsystem<UPowerNetworkSubsystem>())
+	{
+		PowerNetwork->UnregisterNode(this);
+	}
+
+	return true;
+}
+
+bool AStructure::GetIsConnectedToPowerSource_Implementation()
+{
+	const UPowerNetworkSubsystem* PowerNetwork = GetWorld()->GetSubsystem<UPowerNetworkSubsystem>();
+	return PowerNetwork && PowerNetwork->IsConnectedToPowerSource(this);
+}
+
+float AStructure::GetPowerConnectionRadius_Implementation()
+{
+	const FVector Extent = BuildingBounds->GetScaledBoxExtent();
+	return FMath::Max(Extent.X, Extent.Y);
+}
+
+void AStructure::OnConstruction(const FTransform& Transform)
+{
+	Super::OnConstruction(Transform);
+
+	StructureText->SetText(FText::FromString(DisplayName));
+	StructureText->SetRelativeLocation(FVector(0.0f, 0.0f, BuildingBounds->GetScaledBoxExtent().Z * 2 + 50.0f));
+}
+
+void AStructure::ReleaseResourceNode()
+{
+	if (IsValid(TargetResourceNode)) TargetResourceNode->ClearAssignedExtractor(this);
+	TargetResourceNode = nullptr;
 }
 
 bool AStructure::Select_Implementation(ARTSCamera* SelectInstigator)
@@ -69,17 +146,21 @@ bool AStructure::Select_Implementation(ARTSCamera* SelectInstigator)
 
 void AStructure::ActivateStructureEffects()
 {
+	if (bStructureEffectsActive) return;
+	bStructureEffectsActive = true;
+
 	if (GetGeneratesResources()) BeginGeneratingResources();
 	if (GetConsumesResources() && !GetConsumesResourcesFromNearbyNode()) BeginConsumingResources();
 	if (GetConsumesResources() && GetConsumesResourcesFromNearbyNode()) BeginDrainingResourceFromNode();
 	if (GetIncreasesStorageCapacity())
 	{
-		for (auto Resource : GetResourcesToIncreaseStorage())
+		const FStructureDescriptor& Descriptor = GetStructureDescriptor();
+		for (EResourceType ResourceType : TEnumRange<EResourceType>())
 		{
-			EResourceType ResourceType = Resource.Key;
-			int32 Amount = Resource.Value;
-
-			GetStrategyGameState()->IncreaseResourceStorage(ResourceType, Amount);
+			if (Descriptor.StorageResourceMask & (1u << static_cast<uint32>(ResourceType)))
+			{
+				GetStrategyGameState()->IncreaseResourceStorage(ResourceType, Descriptor.GetStorageIncrease(ResourceType));
+			}
 		}
 	}
 
@@ -89,31 +170,39 @@ void AStructure::ActivateStructureEffects()
 	}
 }
 
-AResourceNode* AStructure::FindClosestResourceNode()
+void AStructure::DeactivateStructureEffects()
 {
-	if (OverlappingResourceNodes.IsEmpty()) return nullptr;
-	
-	float ClosestDistance = 0.0f;
-	AActor* ClosestActor = nullptr;
-	for (AActor* Node : OverlappingResourceNodes)
+	if (!bStructureEffectsActive) return;
+	bStructureEffectsActive = false;
+
+	if (UEconomySubsystem* Economy = GetWorld()->GetSubsystem<UEconomySubsystem>())
 	{
-		if (ClosestDistance <= 0.0f)
-		{
-			ClosestActor = Node;
-			ClosestDistance = GetDistanceTo(Node);
-		}
-		else if (GetDistanceTo(Node) < ClosestDistance)
-		{
-			ClosestActor = Node;
-		}
+		Economy->UnregisterStructure(this);
 	}
 
-	return Cast<AResourceNode>(ClosestActor);
+	RemoveAllWorkers(ECitizenType::Worker);
+	RemoveAllWorkers(ECitizenType::Scientist);
+	RevertStorageCapacity();
+
+	if (DoesIncreasePopulationCapacity())
+	{
+		GetStrategyGameState()->DecreasePopulationCapacity(GetAdditionalPopulationCapacity());
+	}
+}
+
+AResourceNode* AStructure::FindClosestResourceNode(bool bUnassignedOnly)
+{
+	const UResourceFieldSubsystem* ResourceField = GetWorld()->GetSubsystem<UResourceFieldSubsystem>();
+	if (!ResourceField) return nullptr;
+
+	// Nodes reach the edge of the building rather than its centre.
+	const FVector Extent = BuildingBounds->GetScaledBoxExtent();
+	return ResourceField->FindNearestNode(GetStructureDescriptor().ConsumedResourceMask, GetActorLocation(), FMath::Max(Extent.X, Extent.Y), bUnassignedOnly);
 }
 
-void AStructure::BeginConstruction()
+void AStructure::StartConstruction()
 {
-	Super::BeginConstruction();
+	Super::StartConstruction();
 
 	if (GetConsumesResourcesFromNearbyNode())
 	{
@@ -126,96 +215,62 @@ void AStructure::CompleteConstruction()
 {
 	Super::CompleteConstruction();
 	ActivateStructureEffects();
+	GetWorld()->GetSubsystem<UStructureRegistrySubsystem>()->RegisterStructure(this);
+	if (UPowerNetworkSubsystem* PowerNetwork = GetWorld()->GetSubsystem<UPowerNetworkSubsystem>())
+	{
+		PowerNetwork->RegisterNode(this);
+	}
 	GetStrategyGameState()->StructureBuiltDelegate.Broadcast(this);
 }
 
-void AStructure::Recycle()
+void AStructure::RecycleInto(FResourceTransaction& Refunds)
 {
-	RevertStorageCapacity();
+	DeactivateStructureEffects();
 	GetStrategyGameState()->StructureDestroyedDelegate.Broadcast(this);
 	
-	Super::Recycle();
+	Super::RecycleInto(Refunds);
 }
 
 void AStructure::RevertStorageCapacity()
 {
-	for (auto Resource : GetResourcesToIncreaseStorage())
+	const FStructureDescriptor& Descriptor = GetStructureDescriptor();
+	for (EResourceType ResourceType : TEnumRange<EResourceType>())
 	{
-		EResourceType ResourceType = Resource.Key;
-		int32 ResourceAmount = Resource.Value;
-		
-		GetStrategyGameState()->DecreaseResourceStorage(ResourceType, ResourceAmount);
+		if (Descriptor.StorageResourceMask & (1u << static_cast<uint32>(ResourceType)))
+		{
+			GetStrategyGameState()->DecreaseResourceStorage(ResourceType, Descriptor.GetStorageIncrease(ResourceType));
+		}
 	}
 }
 
 void AStructure::BeginGeneratingResources()
 {
-	GetWorldTimerManager().SetTimer(ResourceGenerationTimer, this, &AStructure::GenerateResources, 1.0f, true);
-}
-
-void AStructure::GenerateResources()
-{
-	for (auto Resource : GetResourcesToGeneratePerSecond())
-	{
-		EResourceType ResourceType = Resource.Key;
-		float ResourceAmount = Resource.Value * GetWorkerEfficiency();
-		
-		GetStrategyGameState()->AddResources(ResourceType, ResourceAmount);
-	}
+	GetWorld()->GetSubsystem<UEconomySubsystem>()->RegisterProducer(this);
 }
 
 void AStructure::BeginConsumingResources()
 {
-	GetWorldTimerManager().SetTimer(ResourceConsumptionTimer, this, &AStructure::ConsumeResources, 1.0f, true);
-}
-
-void AStructure::ConsumeResources()
-{
-	for (auto Resource : GetResourcesToConsumePerSecond())
-	{
-		EResourceType ResourceType = Resource.Key;
-		float ResourceAmount = Resource.Value * GetWorkerEfficiency();
-		
-		GetStrategyGameState()->ConsumeResources(ResourceType, ResourceAmount);
-	}
+	GetWorld()->GetSubsystem<UEconomySubsystem>()->RegisterConsumer(this);
 }
 
 void AStructure::BeginDrainingResourceFromNode()
 {
-	GetWorldTimerManager().SetTimer(ResourceDrainingTimer, this, &AStructure::DrainResourceFromNode, 1.0f, true);
+	GetWorld()->GetSubsystem<UEconomySubsystem>()->RegisterExtractor(this);
 }
 
-void AStructure::DrainResourceFromNode()
+bool AStructure::AcquireResourceNode()
 {
-	if (TargetResourceNode)
+	ReleaseResourceNode();
+
+	TargetResourceNode = FindClosestResourceNode();
+	if (!TargetResourceNode)
 	{
-		int32 ResourceStorageCapacity = GetStrategyGameState()->GetResourceCapacity(TargetResourceNode->GetResourceType());
-		float ResourceStorageAmount = GetStrategyGameState()->GetResourceAmount(TargetResourceNode->GetResourceType());
-		if (ResourceStorageCapacity >= ResourceStorageAmount + GetResourcesToConsumePerSecond().FindRef(TargetResourceNode->GetResourceType()))
-		{
-			float AmountToDrain = GetResourcesToConsumePerSecond().FindRef(TargetResourceNode->GetResourceType());
-			AmountToDrain *= GetWorkerEfficiency();
-			TargetResourceNode->DrainResource(AmountToDrain);
-		}
-		else
-		{
-			GEngine->AddOnScreenDebugMessage(950, 3.0f, FColor::Red, GetDisplayName() + " Can't extract resources, storage is full.");
-		}
+		GEngine->AddOnScreenDebugMessage(951, 3.0f, FColor::Red, GetDisplayName() + ": No Nearby Ore Nodes.");
+		return false;
 	}
-	else
-	{
-		OverlappingResourceNodes.Remove(TargetResourceNode);
 
-		if (IsOverlappingResourceNode())
-		{
-			TargetResourceNode = FindClosestResourceNode();
-			if (TargetResourceNode) TargetResourceNode->SetAssignedExtractor(this);
-		}
-		else
-		{
-			GEngine->AddOnScreenDebugMessage(951, 3.0f, FColor::Red, GetDisplayName() + ": No Nearby Ore Nodes.");
-		}
-	}
+	TargetResourceNode->SetAssignedExtractor(this);
+	return true;
 }
 
 void AStructure::AssignWorkers(ECitizenType WorkerType, int32 Amount)
@@ -239,14 +294,11 @@ void AStructure::AssignWorkers(ECitizenType WorkerType, int32 Amount)
 		return;
 	}
 
-	if (GetStrategyGameState()->GetUnemployedPopulation(WorkerType) >= Amount)
-	{
-		AssignedWorkers.Add(WorkerType, GetWorkerCount(WorkerType) + Amount);
-	}
-	else
-	{
-		AssignedWorkers.Add(WorkerType, GetWorkerCount(WorkerType) + GetStrategyGameState()->GetUnemployedPopulation(WorkerType));
-	}
+	const int32 AmountToAssign = FMath::Min(Amount, GetStrategyGameState()->GetUnemployedPopulation(WorkerType));
+	if (AmountToAssign <= 0) return;
+
+	AssignedWorkers[static_cast<int32>(WorkerType)] += AmountToAssign;
+	GetStrategyGameState()->ChangeEmployedPopulation(WorkerType, AmountToAssign);
 }
 
 void AStructure::AddMaxWorkers(ECitizenType WorkerType)
@@ -256,16 +308,11 @@ void AStructure::AddMaxWorkers(ECitizenType WorkerType)
 
 void AStructure::RemoveWorkers(ECitizenType WorkerType, int32 Amount)
 {
-	if (Amount <= 0) return;
+	const int32 AmountToRemove = FMath::Min(Amount, GetWorkerCount(WorkerType));
+	if (AmountToRemove <= 0) return;
 	
-	if (GetWorkerCount(WorkerType) >= Amount)
-	{
-		AssignedWorkers.Add(WorkerType, GetWorkerCount(WorkerType) - Amount);
-	}
-	else
-	{
-		AssignedWorkers.Add(WorkerType, 0);
-	}
+	AssignedWorkers[static_cast<int32>(WorkerType)] -= AmountToRemove;
+	GetStrategyGameState()->ChangeEmployedPopulation(WorkerType, -AmountToRemove);
 }
 
 void AStructure::RemoveAllWorkers(ECitizenType WorkerType)
@@ -277,6 +324,8 @@ void AStructure::RemoveAllWorkers(ECitizenType WorkerType)
 	case ECitizenType::Scientist:
 		RemoveWorkers(ECitizenType::Scientist, GetWorkerCount(ECitizenType::Scientist));
 		break;
+	default:
+		break;
 	}
 }
 
@@ -285,39 +334,37 @@ void AStructure::UpdateBuildMaterials()
 	Super::UpdateBuildMaterials();
 }
 
-// Called every frame
-void AStructure::Tick(float DeltaTime)
-{
-	Super::Tick(DeltaTime);
-
-	FVector CameraLocation = GEngine->GetFirstLocalPlayerController(GetWorld())->PlayerCameraManager->GetCameraLocation();
-	FRotator LookAtRotation = UKismetMathLibrary::FindLookAtRotation(StructureText->GetComponentLocation(), CameraLocation);
-	StructureText->SetWorldRotation(LookAtRotation);
-}
-
 bool AStructure::IsBuildingPermitted()
 {
-	if (GetConsumesResourcesFromNearbyNode() && !IsOverlappingResourceNode())
+	if (GetConsumesResourcesFromNearbyNode() && !FindClosestResourceNode())
 	{
-		GEngine->AddOnScreenDebugMessage(800, 3.0f, FColor::Red, GetDisplayName() + " needs to be near the correct resource.");
+		if (IsOverlappingResourceNode())
+		{
+			GEngine->AddOnScreenDebugMessage(801, 3.0f, FColor::Red, "The Resource node already has an assigned extractor.");
+		}
+		else
+		{
+			GEngine->AddOnScreenDebugMessage(800, 3.0f, FColor::Red, GetDisplayName() + " needs to be near the correct resource.");
+		}
 		return false;
 	}
-	if (IsOverlappingResourceNode() && GetConsumesResourcesFromNearbyNode() && FindClosestResourceNode()->GetAssignedExtractor())
-	{
-		GEngine->AddOnScreenDebugMessage(801, 3.0f, FColor::Red, "The Resource node already has an assigned extractor.");
-		return false;
-	}	
 	
 	return Super::IsBuildingPermitted();
 }
 
 const FStructureData* AStructure::GetStructureData()
 {
-	FStructureData* Data = StructureDataTableRow.GetRow<FStructureData>("");
-
-	FString DebugName = GetDebugName(this);
-	verifyf(Data, TEXT("AStructure::GetStructureData failed to get FStructureData pointer %s."), *DebugName);
+	const FStructureData* Data = StructureDataTableRow.GetRow<FStructureData>(TEXT("AStructure::GetStructureData"));
+	verifyf(Data, TEXT("AStructure::GetStructureData failed to get FStructureData row %s."), *GetDebugName(this));
 
 	return Data;
 }
 
+const FStructureDescriptor& AStructure::ResolveStructureDescriptor()
+{
+	StructureDescriptor = FStructureDescriptor::Resolve(StructureDataTableRow);
+	verifyf(StructureDescriptor.IsValid(), TEXT("AStructure::ResolveStructureDescriptor failed to get FStructureData row %s."), *GetDebugName(this));
+
+	return *StructureDescriptor;
+}
+
@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Building/StructureLabelSubsystem.h"
+
+#include "StrategyGame.h"
+#include "Components/TextRenderComponent.h"
+
+DECLARE_CYCLE_STAT(TEXT("Structure Labels Update"), STAT_StructureLabelsUpdate, STATGROUP_StrategyGame);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Structure Labels Visible"), STAT_StructureLabelsVisible, STATGROUP_StrategyGame);
+
+bool UStructureLabelSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UStructureLabelSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (Labels.IsEmpty()) return;
+
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	if (!PlayerController || !PlayerController->PlayerCameraManager) return;
+
+	const FVector CameraLocation = PlayerController->PlayerCameraManager->GetCameraLocation();
+	const FRotator CameraRotation = PlayerController->PlayerCameraManager->GetCameraRotation();
+	const float CameraFOV = PlayerController->PlayerCameraManager->GetFOVAngle();
+
+	const bool bCameraMoved = !CameraLocation.Equals(LastCameraLocation, 1.0f) || !CameraRotation.Equals(LastCameraRotation, 0.1f) || CameraFOV != LastCameraFOV;
+	if (!bCameraMoved && !bLabelsDirty) return;
+
+	LastCameraLocation = CameraLocation;
+	LastCameraRotation = CameraRotation;
+	LastCameraFOV = CameraFOV;
+	bLabelsDirty = false;
+
+	UpdateLabels(CameraLocation, CameraRotation, CameraFOV);
+}
+
+TStatId UStructureLabelSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UStructureLabelSubsystem, STATGROUP_Tickables);
+}
+
+void UStructureLabelSubsystem::Deinitialize()
+{
+	Labels.Empty();
+	LabelIndices.Empty();
+
+	Super::Deinitialize();
+}
+
+void UStructureLabelSubsystem::RegisterLabel(UTextRenderComponent* Label)
+{
+	if (!Label || LabelIndices.Contains(Label)) return;
+
+	LabelIndices.Add(Label, Labels.Add(Label));
+	Label->TransformUpdated.AddUObject(this, &ThisClass::OnLabelMoved);
+	bLabelsDirty = true;
+}
+
+void UStructureLabelSubsystem::UnregisterLabel(UTextRenderComponent* Label)
+{
+	int32 Index;
+	if (!LabelIndices.RemoveAndCopyValue(Label, Index)) return;
+
+	Label->TransformUpdated.RemoveAll(this);
+
+	Labels.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	if (Labels.IsValidIndex(Index)) LabelIndices[Labels[Index]] = Index;
+}
+
+void UStructureLabelSubsystem::OnLabelMoved(USceneComponent* Label, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport)
+{
+	if (!bUpdatingLabels) bLabelsDirty = true;
+}
+
+void UStructureLabelSubsystem::UpdateLabels(const FVector& CameraLocation, const FRotator& CameraRotation, float CameraFOV)
+{
+	SCOPE_CYCLE_COUNTER(STAT_StructureLabelsUpdate);
+
+	TGuardValue<bool> UpdatingLabels(bUpdatingLabels, true);
+
+	const FVector CameraForward = CameraRotation.Vector();
+	const float MaxDistanceSquared = FMath::Square(MaxLabelDistance);
+
+	// A cone around the horizontal field of view, which is the wider one on a landscape screen.
+	const float MinViewDot = FMath::Cos(FMath::DegreesToRadians(FMath::Min(CameraFOV * 0.5f * ViewAngleMargin, 89.0f)));
+
+	int32 NumVisible = 0;
+	for (UTextRenderComponent* Label : Labels)
+	{
+		const FVector LabelLocation = Label->GetComponentLocation();
+		const FVector ToLabel = LabelLocation - CameraLocation;
+		const float DistanceSquared = ToLabel.SizeSquared();
+
+		const bool bVisible = DistanceSquared <= MaxDistanceSquared &&
+			(DistanceSquared < KINDA_SMALL_NUMBER || FVector::DotProduct(ToLabel, CameraForward) >= MinViewDot * FMath::Sqrt(DistanceSquared));
+
+		if (Label->IsVisible() != bVisible) Label->SetVisibility(bVisible);
+		if (!bVisible) continue;
+
+		// Text faces along its X axis.
+		Label->SetWorldRotation(FRotationMatrix::MakeFromX(-ToLabel).Rotator());
+		NumVisible++;
+	}
+
+	SET_DWORD_STAT(STAT_StructureLabelsVisible, NumVisible);
+}
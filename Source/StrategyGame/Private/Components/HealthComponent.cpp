@@ -3,14 +3,14 @@
 
 #include "Components/HealthComponent.h"
 
+#include "Game/HealthSubsystem.h"
+
 // Sets default values for this component's properties
 UHealthComponent::UHealthComponent()
 {
 	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
 	// off to improve performance if you don't need them.
-	PrimaryComponentTick.bCanEverTick = true;
-
-	// ...
+	PrimaryComponentTick.bCanEverTick = false;
 }
 
 
@@ -19,16 +19,53 @@ void UHealthComponent::BeginPlay()
 {
 	Super::BeginPlay();
 
-	// ...
-	
+	if (UHealthSubsystem* HealthSubsystem = GetWorld()->GetSubsystem<UHealthSubsystem>())
+	{
+		HealthSubsystem->RegisterHealth(this);
+	}
+
+	GetOwner()->OnTakeAnyDamage.AddDynamic(this, &ThisClass::OnOwnerTakeAnyDamage);
+}
+
+void UHealthComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UHealthSubsystem* HealthSubsystem = GetWorld()->GetSubsystem<UHealthSubsystem>())
+	{
+		HealthSubsystem->UnregisterHealth(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UHealthComponent::OnOwnerTakeAnyDamage(AActor* DamagedActor, float Damage, const UDamageType* DamageType, AController* InstigatedBy, AActor* DamageCauser)
+{
+	ApplyDamage(Damage, DamageCauser);
 }
 
+void UHealthComponent::ApplyDamage(float Damage, AActor* DamageCauser)
+{
+	if (UHealthSubsystem* HealthSubsystem = GetWorld()->GetSubsystem<UHealthSubsystem>())
+	{
+		HealthSubsystem->QueueDamage(GetOwner(), Damage, DamageCauser);
+	}
+}
 
-// Called every frame
-void UHealthComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+void UHealthComponent::ResetHealth()
 {
-	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+	if (UHealthSubsystem* HealthSubsystem = GetWorld()->GetSubsystem<UHealthSubsystem>())
+	{
+		HealthSubsystem->ResetHealth(PoolIndex);
+	}
+}
 
-	// ...
+float UHealthComponent::GetHealth() const
+{
+	const UHealthSubsystem* HealthSubsystem = GetWorld() ? GetWorld()->GetSubsystem<UHealthSubsystem>() : nullptr;
+	return HealthSubsystem && PoolIndex != INDEX_NONE ? HealthSubsystem->GetHealth(PoolIndex) : MaxHealth;
 }
 
+bool UHealthComponent::IsDead() const
+{
+	const UHealthSubsystem* HealthSubsystem = GetWorld() ? GetWorld()->GetSubsystem<UHealthSubsystem>() : nullptr;
+	return HealthSubsystem && PoolIndex != INDEX_NONE && HealthSubsystem->IsDead(PoolIndex);
+}
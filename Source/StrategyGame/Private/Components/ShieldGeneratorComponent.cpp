@@ -9,7 +9,7 @@ UShieldGeneratorComponent::UShieldGeneratorComponent()
 {
 	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
 	// off to improve performance if you don't need them.
-	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bCanEverTick = false;
 	
 	Sphere = CreateDefaultSubobject<USphereComponent>("Shield");
 }
@@ -23,13 +23,3 @@ void UShieldGeneratorComponent::BeginPlay()
 	
 	
 }
-
-
-// Called every frame
-void UShieldGeneratorComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
-{
-	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
-
-	
-}
-
@@ -4,6 +4,10 @@
 #include "Components/ShootingComponent.h"
 
 #include "Projectile.h"
+#include "Enemies/EnemyShip.h"
+#include "Enemies/EnemySwarmSubsystem.h"
+#include "Game/HealthSubsystem.h"
+#include "Game/ProjectileSubsystem.h"
 
 
 // Sets default values for this component's properties
@@ -11,7 +15,7 @@ UShootingComponent::UShootingComponent()
 {
 	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
 	// off to improve performance if you don't need them.
-	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bCanEverTick = false;
 }
 
 
@@ -28,18 +32,16 @@ void UShootingComponent::ShootProjectile(FVector ShotStart, FVector ShotTarget)
 	ensureAlwaysMsgf(Projectile, TEXT("%s UShootingComponent::ShootProjectile failed due to Projectile being Null"), *GetOwner()->GetName());
 	if (!Projectile) return;
 
+	UProjectileSubsystem* ProjectileSubsystem = GetWorld()->GetSubsystem<UProjectileSubsystem>();
+	if (!ProjectileSubsystem) return;
+
 	FVector TargetDirection = ShotTarget - ShotStart;
 	TargetDirection.Normalize();
 
 	if (ProjectileCount < 1) ProjectileCount = 1;
 	for (int32 i = 0; i < ProjectileCount; i++)
 	{
-		AProjectile* SpawnedProjectile = GetWorld()->SpawnActor<AProjectile>(Projectile);
-		
-		SpawnedProjectile->SetActorLocation(ShotStart);
-		SpawnedProjectile->GetProjectileMovement()->Velocity = TargetDirection * ProjectileSpeed;
-		SpawnedProjectile->SetDamage(Damage);
-		SpawnedProjectile->SetKnockbackForceMultiplier(KnockbackForceMultiplier);
+		ProjectileSubsystem->SpawnProjectile(Projectile, ShotStart, TargetDirection * ProjectileSpeed, Damage, KnockbackForceMultiplier, GetOwner());
 	}
 }
 
@@ -47,11 +49,29 @@ void UShootingComponent::ShootHitscan(FVector ShotStart, FVector ShotTarget)
 {
 	FHitResult Hit;
 	GetWorld()->LineTraceSingleByChannel(Hit, ShotStart, ShotTarget, ECC_Visibility);
+
+	// Swarm ships have no collision until they're actors, a closer one is promoted and takes the hit instead.
+	if (UEnemySwarmSubsystem* Swarm = GetWorld()->GetSubsystem<UEnemySwarmSubsystem>())
+	{
+		Swarm->UpdateSpatialHash();
+
+		float SwarmTime;
+		const int32 Ship = Swarm->TraceShips(ShotStart, ShotTarget, 0.0f, SwarmTime);
+		if (Ship != INDEX_NONE && (!Hit.bBlockingHit || SwarmTime < Hit.Time))
+		{
+			if (AEnemyShip* SwarmShip = Swarm->PromoteShip(Ship))
+			{
+				Hit = FHitResult(SwarmShip, nullptr, FMath::Lerp(ShotStart, ShotTarget, SwarmTime), (ShotStart - ShotTarget).GetSafeNormal());
+			}
+		}
+	}
+
 	DrawDebugLine(GetWorld(), ShotStart, Hit.bBlockingHit ? Hit.ImpactPoint : Hit.TraceEnd, FColor::Red);
 
-	if (Hit.GetActor())
+	UHealthSubsystem* HealthSubsystem = GetWorld()->GetSubsystem<UHealthSubsystem>();
+	if (Hit.GetActor() && HealthSubsystem)
 	{
-		Hit.GetActor()->TakeDamage(Damage, FDamageEvent(), nullptr, GetOwner());
+		HealthSubsystem->QueueDamage(Hit.GetActor(), Damage, GetOwner());
 	}
 }
 
@@ -96,13 +116,3 @@ void UShootingComponent::CompleteReload()
 {
 	AmmoInMagazine = MagazineCapacity;
 }
-
-// Called every frame
-void UShootingComponent::TickComponent(float DeltaTime, ELevelTick TickType,
-                                       FActorComponentTickFunction* ThisTickFunction)
-{
-	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
-
-	// ...
-}
-
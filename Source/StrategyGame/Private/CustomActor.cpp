@@ -3,6 +3,9 @@
 
 #include "CustomActor.h"
 
+#include "Debug/TickCensus.h"
+#include "Game/TickPolicySubsystem.h"
+
 
 // Sets default values
 ACustomActor::ACustomActor()
@@ -11,6 +14,60 @@ ACustomActor::ACustomActor()
 	PrimaryActorTick.bCanEverTick = false;
 }
 
+void ACustomActor::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (UTickPolicySubsystem* TickPolicySubsystem = GetWorld()->GetSubsystem<UTickPolicySubsystem>())
+	{
+		TickPolicySubsystem->RegisterActor(this);
+	}
+}
+
+void ACustomActor::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UTickPolicySubsystem* TickPolicySubsystem = GetWorld()->GetSubsystem<UTickPolicySubsystem>())
+	{
+		TickPolicySubsystem->UnregisterActor(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ACustomActor::TickActor(float DeltaTime, ELevelTick TickType, FActorTickFunction& ThisTickFunction)
+{
+	FTickCensusScope CensusScope(this);
+	Super::TickActor(DeltaTime, TickType, ThisTickFunction);
+}
+
+void ACustomActor::OnAcquiredFromPool_Implementation()
+{
+	SetActorTickEnabled(PrimaryActorTick.bStartWithTickEnabled);
+
+	if (UTickPolicySubsystem* TickPolicySubsystem = GetWorld()->GetSubsystem<UTickPolicySubsystem>())
+	{
+		TickPolicySubsystem->RegisterActor(this);
+	}
+}
+
+void ACustomActor::OnReturnedToPool_Implementation()
+{
+	if (UTickPolicySubsystem* TickPolicySubsystem = GetWorld()->GetSubsystem<UTickPolicySubsystem>())
+	{
+		TickPolicySubsystem->UnregisterActor(this);
+	}
+}
+
+void ACustomActor::WakeTick()
+{
+	if (TickPolicy.Policy == EGameplayTickPolicy::OnDemand && !IsActorTickEnabled()) SetActorTickEnabled(true);
+}
+
+void ACustomActor::SleepTick()
+{
+	if (TickPolicy.Policy == EGameplayTickPolicy::OnDemand && IsActorTickEnabled()) SetActorTickEnabled(false);
+}
+
 AStrategyGameState* ACustomActor::GetStrategyGameState()
 {
 	if (StrategyGameState == nullptr)
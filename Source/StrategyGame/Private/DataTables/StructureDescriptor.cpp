@@ -0,0 +1,109 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DataTables/StructureDescriptor.h"
+
+namespace StructureDescriptorCache
+{
+	using FKey = TPair<TObjectKey<UDataTable>, FName>;
+
+	TMap<FKey, TSharedPtr<const FStructureDescriptor>> Descriptors;
+
+	void RemoveTable(TObjectKey<UDataTable> Table)
+	{
+		for (auto It = Descriptors.CreateIterator(); It; ++It)
+		{
+			if (It.Key().Key == Table) It.RemoveCurrent();
+		}
+	}
+
+#if WITH_EDITOR
+	TSet<TObjectKey<UDataTable>> WatchedTables;
+
+	// Rows edited in the editor need rebuilding, so drop every descriptor built from the changed table.
+	void OnDataTableChanged(TObjectKey<UDataTable> Table)
+	{
+		RemoveTable(Table);
+	}
+#endif
+
+	void CopyRates(float* OutRates, uint32& OutMask, const TMap<EResourceType, float>& RateMap)
+	{
+		for (auto Rate : RateMap)
+		{
+			if (Rate.Key == EResourceType::MAX || Rate.Value == 0.0f) continue;
+
+			OutRates[static_cast<int32>(Rate.Key)] = Rate.Value;
+			OutMask |= 1u << static_cast<uint32>(Rate.Key);
+		}
+	}
+
+	TSharedPtr<const FStructureDescriptor> Build(const FStructureData* Row)
+	{
+		TSharedPtr<FStructureDescriptor> Descriptor = MakeShared<FStructureDescriptor>();
+		Descriptor->MaxWorkerCapacity = Row->MaxWorkerCapacity;
+		Descriptor->AdditionalPopulationCapacity = Row->AdditionalPopulationCapacity;
+
+		if (Row->bGeneratesResources) Descriptor->Flags |= EStructureFlags::GeneratesResources;
+		if (Row->bConsumesResources) Descriptor->Flags |= EStructureFlags::ConsumesResources;
+		if (Row->bConsumesResources && Row->bConsumesResourceFromNearbyNode) Descriptor->Flags |= EStructureFlags::ConsumesResourceFromNearbyNode;
+		if (Row->bIncreasesStorageCapacity) Descriptor->Flags |= EStructureFlags::IncreasesStorageCapacity;
+		if (Row->AdditionalPopulationCapacity > 0) Descriptor->Flags |= EStructureFlags::IncreasesPopulationCapacity;
+		if (Row->bAllowWorkerEmployment) Descriptor->Flags |= EStructureFlags::AllowWorkerEmployment;
+		if (Row->bAllowScientistEmployment) Descriptor->Flags |= EStructureFlags::AllowScientistEmployment;
+
+		// Only copy the rates that the row's flags enable, matching what the data table editor shows.
+		if (Row->bGeneratesResources) CopyRates(Descriptor->GenerationRates, Descriptor->GeneratedResourceMask, Row->ResourcesToGeneratePerSecond);
+		if (Row->bConsumesResources) CopyRates(Descriptor->ConsumptionRates, Descriptor->ConsumedResourceMask, Row->ResourcesToConsumePerSecond);
+
+		if (Row->bIncreasesStorageCapacity)
+		{
+			for (auto Storage : Row->ResourcesToIncreaseStorage)
+			{
+				if (Storage.Key == EResourceType::MAX || Storage.Value == 0) continue;
+
+				Descriptor->StorageIncrease[static_cast<int32>(Storage.Key)] = Storage.Value;
+				Descriptor->StorageResourceMask |= 1u << static_cast<uint32>(Storage.Key);
+			}
+		}
+
+		return Descriptor;
+	}
+}
+
+TSharedPtr<const FStructureDescriptor> FStructureDescriptor::Resolve(const FDataTableRowHandle& RowHandle)
+{
+	check(IsInGameThread());
+	using namespace StructureDescriptorCache;
+
+	if (!RowHandle.DataTable) return nullptr;
+
+	const FKey Key(TObjectKey<UDataTable>(RowHandle.DataTable), RowHandle.RowName);
+	if (const TSharedPtr<const FStructureDescriptor>* Found = Descriptors.Find(Key))
+	{
+		return *Found;
+	}
+
+	const FStructureData* Row = RowHandle.GetRow<FStructureData>(TEXT("FStructureDescriptor::Resolve"));
+	if (!Row) return nullptr;
+
+#if WITH_EDITOR
+	if (!WatchedTables.Contains(Key.Key))
+	{
+		WatchedTables.Add(Key.Key);
+		const_cast<UDataTable*>(RowHandle.DataTable.Get())->OnDataTableChanged().AddStatic(&OnDataTableChanged, Key.Key);
+	}
+#endif
+
+	return Descriptors.Add(Key, Build(Row));
+}
+
+void FStructureDescriptor::ClearCache()
+{
+	StructureDescriptorCache::Descriptors.Empty();
+}
+
+void FStructureDescriptor::ClearCache(const UDataTable* Table)
+{
+	StructureDescriptorCache::RemoveTable(TObjectKey<UDataTable>(Table));
+}
@@ -0,0 +1,169 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+// Tick census.
+//
+// Lists every actor and component class with an enabled tick in the current world, how many of each are ticking or
+// asleep, and what their ticks cost over the next few frames. Costs are measured for the module's own actors; engine
+// classes are counted but show n/a.
+//
+// Example:
+//   StrategyGame.TickCensus Frames=120
+
+#include "Debug/TickCensus.h"
+
+#include "StrategyGame.h"
+#include "EngineUtils.h"
+#include "Misc/CoreDelegates.h"
+
+namespace TickCensus
+{
+	struct FClassCensus
+	{
+		int32 TickingActors = 0;
+		int32 TickingComponents = 0;
+
+		// Can tick, but its tick is currently turned off.
+		int32 Sleeping = 0;
+
+		int64 MeasuredTicks = 0;
+		double MeasuredSeconds = 0.0;
+	};
+
+	struct FCapture
+	{
+		TMap<const UClass*, FClassCensus> Classes;
+		int32 Frames = 0;
+		int32 FramesLeft = 0;
+		FDelegateHandle EndFrameHandle;
+	};
+
+	static FCapture Capture;
+	static bool bCapturing = false;
+
+	bool IsCapturing()
+	{
+		return bCapturing;
+	}
+
+	void RecordTick(const UClass* Class, double Seconds)
+	{
+		FClassCensus& Census = Capture.Classes.FindOrAdd(Class);
+		Census.MeasuredTicks++;
+		Census.MeasuredSeconds += Seconds;
+	}
+
+	template <typename TickFunctionType>
+	void CountTickFunction(const UClass* Class, const TickFunctionType& TickFunction, bool bComponent)
+	{
+		if (!TickFunction.bCanEverTick || !TickFunction.IsTickFunctionRegistered()) return;
+
+		FClassCensus& Census = Capture.Classes.FindOrAdd(Class);
+		if (!TickFunction.IsTickFunctionEnabled()) Census.Sleeping++;
+		else if (bComponent) Census.TickingComponents++;
+		else Census.TickingActors++;
+	}
+
+	void PrintReport()
+	{
+		TArray<TPair<const UClass*, FClassCensus>> Rows;
+		for (const TPair<const UClass*, FClassCensus>& Pair : Capture.Classes)
+		{
+			Rows.Add(Pair);
+		}
+
+		// Most expensive first, then the most ticking instances for classes without a measured cost.
+		Rows.Sort([](const TPair<const UClass*, FClassCensus>& A, const TPair<const UClass*, FClassCensus>& B)
+		{
+			if (A.Value.MeasuredSeconds != B.Value.MeasuredSeconds) return A.Value.MeasuredSeconds > B.Value.MeasuredSeconds;
+			return A.Value.TickingActors + A.Value.TickingComponents > B.Value.TickingActors + B.Value.TickingComponents;
+		});
+
+		int32 TotalTicking = 0;
+		int32 TotalSleeping = 0;
+		double TotalMilliseconds = 0.0;
+
+		UE_LOG(LogStrategyGame, Display, TEXT("Tick census over %d frames:"), Capture.Frames);
+		UE_LOG(LogStrategyGame, Display, TEXT("%-48s %8s %10s %8s %12s %12s"), TEXT("Class"), TEXT("Actors"), TEXT("Components"), TEXT("Asleep"), TEXT("Ticks/frame"), TEXT("ms/frame"));
+
+		for (const TPair<const UClass*, FClassCensus>& Row : Rows)
+		{
+			const FClassCensus& Census = Row.Value;
+			const FString ClassName = Row.Key ? Row.Key->GetName() : TEXT("None");
+
+			TotalTicking += Census.TickingActors + Census.TickingComponents;
+			TotalSleeping += Census.Sleeping;
+
+			if (Census.MeasuredTicks > 0)
+			{
+				const double MillisecondsPerFrame = Census.MeasuredSeconds * 1000.0 / Capture.Frames;
+				TotalMilliseconds += MillisecondsPerFrame;
+
+				UE_LOG(LogStrategyGame, Display, TEXT("%-48s %8d %10d %8d %12.1f %12.4f"), *ClassName, Census.TickingActors, Census.TickingComponents, Census.Sleeping,
+					static_cast<double>(Census.MeasuredTicks) / Capture.Frames, MillisecondsPerFrame);
+			}
+			else
+			{
+				UE_LOG(LogStrategyGame, Display, TEXT("%-48s %8d %10d %8d %12s %12s"), *ClassName, Census.TickingActors, Census.TickingComponents, Census.Sleeping, TEXT("n/a"), TEXT("n/a"));
+			}
+		}
+
+		UE_LOG(LogStrategyGame, Display, TEXT("Tick census: %d ticking, %d asleep, %.4f ms/frame measured"), TotalTicking, TotalSleeping, TotalMilliseconds);
+	}
+
+	void OnEndFrame()
+	{
+		if (--Capture.FramesLeft > 0) return;
+
+		bCapturing = false;
+		FCoreDelegates::OnEndFrame.Remove(Capture.EndFrameHandle);
+		Capture.EndFrameHandle.Reset();
+
+		PrintReport();
+		Capture.Classes.Empty();
+	}
+
+	void Run(const TArray<FString>& Args, UWorld* World)
+	{
+		if (!World)
+		{
+			UE_LOG(LogStrategyGame, Error, TEXT("Tick census needs a running world."));
+			return;
+		}
+
+		if (bCapturing)
+		{
+			UE_LOG(LogStrategyGame, Warning, TEXT("Tick census is already running."));
+			return;
+		}
+
+		int32 Frames = 120;
+		for (const FString& Arg : Args)
+		{
+			FString Key, Value;
+			if (Arg.Split(TEXT("="), &Key, &Value) && Key == TEXT("Frames")) Frames = FMath::Max(FCString::Atoi(*Value), 1);
+		}
+
+		Capture.Classes.Empty();
+		for (TActorIterator<AActor> It(World); It; ++It)
+		{
+			CountTickFunction(It->GetClass(), It->PrimaryActorTick, false);
+
+			for (const UActorComponent* Component : It->GetComponents())
+			{
+				if (Component) CountTickFunction(Component->GetClass(), Component->PrimaryComponentTick, true);
+			}
+		}
+
+		Capture.Frames = Frames;
+		Capture.FramesLeft = Frames;
+		Capture.EndFrameHandle = FCoreDelegates::OnEndFrame.AddStatic(&OnEndFrame);
+		bCapturing = true;
+
+		UE_LOG(LogStrategyGame, Display, TEXT("Tick census started, measuring the next %d frames."), Frames);
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs TickCensusCommand(
+	TEXT("StrategyGame.TickCensus"),
+	TEXT("Lists every ticking actor and component class with counts and measured tick cost. Usage: StrategyGame.TickCensus [Frames=120]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&TickCensus::Run));
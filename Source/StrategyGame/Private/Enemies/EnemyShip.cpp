@@ -3,25 +3,68 @@
 
 #include "Enemies/EnemyShip.h"
 
+#include "Components/HealthComponent.h"
+#include "Enemies/EnemySwarmSubsystem.h"
+#include "Turrets/TargetingSubsystem.h"
+
 
 // Sets default values
 AEnemyShip::AEnemyShip()
 {
 	// Set this pawn to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bCanEverTick = false;
+
+	HealthComponent = CreateDefaultSubobject<UHealthComponent>("Health");
+	HealthComponent->SetDestroyOwnerOnDeath(true);
 }
 
 // Called when the game starts or when spawned
 void AEnemyShip::BeginPlay()
 {
 	Super::BeginPlay();
-	
+
+	if (UTargetingSubsystem* TargetingSubsystem = GetWorld()->GetSubsystem<UTargetingSubsystem>())
+	{
+		TargetingSubsystem->RegisterEnemy(this);
+	}
+}
+
+void AEnemyShip::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	RemoveFromWorldSystems();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AEnemyShip::OnAcquiredFromPool_Implementation()
+{
+	HealthComponent->ResetHealth();
+
+	if (UTargetingSubsystem* TargetingSubsystem = GetWorld()->GetSubsystem<UTargetingSubsystem>())
+	{
+		TargetingSubsystem->RegisterEnemy(this);
+	}
+}
+
+void AEnemyShip::OnReturnedToPool_Implementation()
+{
+	RemoveFromWorldSystems();
 }
 
-// Called every frame
-void AEnemyShip::Tick(float DeltaTime)
+void AEnemyShip::RemoveFromWorldSystems()
 {
-	Super::Tick(DeltaTime);
+	if (UTargetingSubsystem* TargetingSubsystem = GetWorld()->GetSubsystem<UTargetingSubsystem>())
+	{
+		TargetingSubsystem->UnregisterEnemy(this);
+	}
+
+	// A promoted ship dies with its actor.
+	UEnemySwarmSubsystem* Swarm = GetWorld()->GetSubsystem<UEnemySwarmSubsystem>();
+	if (Swarm && SwarmIndex != INDEX_NONE && Swarm->GetShipActor(SwarmIndex) == this)
+	{
+		Swarm->RemoveShip(SwarmIndex);
+	}
+	SwarmIndex = INDEX_NONE;
 }
 
 // Called to bind functionality to input
@@ -29,4 +72,3 @@ void AEnemyShip::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent
 {
 	Super::SetupPlayerInputComponent(PlayerInputComponent);
 }
-
@@ -0,0 +1,515 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Enemies/EnemySwarmSubsystem.h"
+
+#include "StrategyGame.h"
+#include "Async/ParallelFor.h"
+#include "Building/Structure.h"
+#include "Enemies/EnemyShip.h"
+#include "Game/ActorPoolSubsystem.h"
+#include "Game/StructureRegistrySubsystem.h"
+#include "Rendering/InstancedRenderActor.h"
+#include "Turrets/TargetingSubsystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Swarm Retarget"), STAT_SwarmRetarget, STATGROUP_StrategyGame);
+DECLARE_CYCLE_STAT(TEXT("Swarm Steer"), STAT_SwarmSteer, STATGROUP_StrategyGame);
+DECLARE_CYCLE_STAT(TEXT("Swarm Hash Build"), STAT_SwarmHashBuild, STATGROUP_StrategyGame);
+DECLARE_CYCLE_STAT(TEXT("Swarm Sync Actors"), STAT_SwarmSyncActors, STATGROUP_StrategyGame);
+DECLARE_CYCLE_STAT(TEXT("Swarm Render"), STAT_SwarmRender, STATGROUP_StrategyGame);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Swarm Ships"), STAT_SwarmShips, STATGROUP_StrategyGame);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Swarm Promoted Ships"), STAT_SwarmPromotedShips, STATGROUP_StrategyGame);
+
+bool UEnemySwarmSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UEnemySwarmSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UEnemySwarmSubsystem, STATGROUP_Tickables);
+}
+
+void UEnemySwarmSubsystem::Deinitialize()
+{
+	ShipClasses.Empty();
+	ShipClassIndices.Empty();
+	Positions.Empty();
+	Velocities.Empty();
+	TargetLocations.Empty();
+	ClassIndices.Empty();
+	Actors.Empty();
+	CellEntries.Empty();
+	CellRanges.Empty();
+	PromotionSources.Empty();
+	RenderActor = nullptr;
+
+	Super::Deinitialize();
+}
+
+int32 UEnemySwarmSubsystem::FindOrAddShipClass(TSubclassOf<AEnemyShip> ShipClass)
+{
+	if (const int32* Existing = ShipClassIndices.Find(ShipClass)) return *Existing;
+
+	const AEnemyShip* ShipDefaults = ShipClass.GetDefaultObject();
+
+	FEnemySwarmClass SwarmClass;
+	SwarmClass.ShipClass = ShipClass;
+	SwarmClass.MeshTransform = ShipDefaults->GetSwarmMeshTransform();
+	SwarmClass.Radius = ShipDefaults->GetSwarmRadius();
+	SwarmClass.MaxSpeed = ShipDefaults->GetMaxSpeed();
+	SwarmClass.MaxAcceleration = ShipDefaults->GetMaxAcceleration();
+	SwarmClass.AttackRange = ShipDefaults->GetAttackRange();
+
+	if (ShipDefaults->GetSwarmMesh())
+	{
+		if (!RenderActor)
+		{
+			FActorSpawnParameters SpawnParameters;
+			SpawnParameters.ObjectFlags |= RF_Transient;
+			RenderActor = GetWorld()->SpawnActor<AInstancedRenderActor>(SpawnParameters);
+		}
+		if (RenderActor) SwarmClass.InstancedMesh = RenderActor->GetInstancedMesh(ShipDefaults->GetSwarmMesh(), true);
+	}
+
+	MaxShipRadius = FMath::Max(MaxShipRadius, SwarmClass.Radius);
+
+	const int32 Index = ShipClasses.Add(SwarmClass);
+	ShipClassIndices.Add(ShipClass, Index);
+	return Index;
+}
+
+int32 UEnemySwarmSubsystem::SpawnShip(TSubclassOf<AEnemyShip> ShipClass, const FVector& Location, const FVector& Velocity)
+{
+	if (!ShipClass) return INDEX_NONE;
+
+	const int32 ClassIndex = FindOrAddShipClass(ShipClass);
+
+	// Ships hold position until the next retarget pass finds them something to attack.
+	Positions.Add(Location);
+	Velocities.Add(Velocity);
+	TargetLocations.Add(Location);
+	ClassIndices.Add(ClassIndex);
+	Actors.Add(nullptr);
+
+	bHashDirty = true;
+	return Positions.Num() - 1;
+}
+
+void UEnemySwarmSubsystem::SpawnFleet(TSubclassOf<AEnemyShip> ShipClass, FVector Center, int32 Count, float Radius)
+{
+	for (int32 i = 0; i < Count; i++)
+	{
+		SpawnShip(ShipClass, Center + FMath::VRand() * FMath::FRandRange(0.0f, Radius));
+	}
+
+	// Gives the whole fleet targets straight away instead of one slice at a time.
+	RefreshTargetPoints();
+	for (int32 i = 0; i < RetargetSlices; i++)
+	{
+		RetargetShips();
+	}
+}
+
+void UEnemySwarmSubsystem::RemoveShip(int32 Index)
+{
+	if (!Positions.IsValidIndex(Index)) return;
+
+	const int32 LastIndex = Positions.Num() - 1;
+
+	Positions.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Velocities.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	TargetLocations.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	ClassIndices.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Actors.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+
+	if (Actors.IsValidIndex(Index) && Actors[Index]) Actors[Index]->SwarmIndex = Index;
+
+	// Ship indices changed, so anything that hashed them has to rebuild.
+	bHashDirty = true;
+	if (UTargetingSubsystem* TargetingSubsystem = GetWorld()->GetSubsystem<UTargetingSubsystem>())
+	{
+		TargetingSubsystem->InvalidateSpatialHash();
+		TargetingSubsystem->RemapSwarmShip(Index, INDEX_NONE);
+		if (LastIndex != Index) TargetingSubsystem->RemapSwarmShip(LastIndex, Index);
+	}
+}
+
+AEnemyShip* UEnemySwarmSubsystem::PromoteShip(int32 Index)
+{
+	if (!Positions.IsValidIndex(Index)) return nullptr;
+	if (Actors[Index]) return Actors[Index];
+
+	// Ships die and get promoted constantly in a fight, so their actors are pooled.
+	UActorPoolSubsystem* ActorPool = GetWorld()->GetSubsystem<UActorPoolSubsystem>();
+	if (!ActorPool) return nullptr;
+
+	const FTransform Transform(Velocities[Index].ToOrientationRotator(), Positions[Index]);
+	AEnemyShip* Ship = ActorPool->AcquireActor<AEnemyShip>(ShipClasses[ClassIndices[Index]].ShipClass, Transform);
+	if (!Ship) return nullptr;
+
+	Ship->SwarmIndex = Index;
+	Actors[Index] = Ship;
+	return Ship;
+}
+
+void UEnemySwarmSubsystem::AddPromotionSource(AActor* Source)
+{
+	if (Source) PromotionSources.AddUnique(Source);
+}
+
+void UEnemySwarmSubsystem::RemovePromotionSource(AActor* Source)
+{
+	PromotionSources.Remove(Source);
+}
+
+FIntVector UEnemySwarmSubsystem::WorldToCell(const FVector& Location) const
+{
+	return FIntVector(FMath::FloorToInt32(Location.X / SeparationRadius), FMath::FloorToInt32(Location.Y / SeparationRadius), FMath::FloorToInt32(Location.Z / SeparationRadius));
+}
+
+uint64 UEnemySwarmSubsystem::PackCell(const FIntVector& Cell)
+{
+	constexpr uint64 Mask = (1ull << 21) - 1;
+	return (static_cast<uint64>(Cell.X) & Mask) | ((static_cast<uint64>(Cell.Y) & Mask) << 21) | ((static_cast<uint64>(Cell.Z) & Mask) << 42);
+}
+
+void UEnemySwarmSubsystem::UpdateSpatialHash()
+{
+	if (!bHashDirty) return;
+	bHashDirty = false;
+
+	SCOPE_CYCLE_COUNTER(STAT_SwarmHashBuild);
+
+	const int32 NumShips = Positions.Num();
+	CellEntries.SetNum(NumShips, EAllowShrinking::No);
+	for (int32 i = 0; i < NumShips; i++)
+	{
+		CellEntries[i] = { PackCell(WorldToCell(Positions[i])), i };
+	}
+
+	CellEntries.Sort([](const FCellEntry& A, const FCellEntry& B) { return A.Cell < B.Cell; });
+
+	CellRanges.Reset();
+	for (int32 Start = 0; Start < NumShips;)
+	{
+		int32 End = Start + 1;
+		while (End < NumShips && CellEntries[End].Cell == CellEntries[Start].Cell) End++;
+
+		CellRanges.Add(CellEntries[Start].Cell, FIntPoint(Start, End - Start));
+		Start = End;
+	}
+}
+
+void UEnemySwarmSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	SET_DWORD_STAT(STAT_SwarmShips, Positions.Num());
+
+	// Still rendered once empty, to clear the last ships' instances.
+	if (Positions.IsEmpty())
+	{
+		RenderShips();
+		return;
+	}
+
+	TargetRefreshAccumulator += DeltaTime;
+	if (TargetRefreshAccumulator >= TargetRefreshInterval)
+	{
+		TargetRefreshAccumulator = 0.0f;
+		RefreshTargetPoints();
+	}
+	RetargetShips();
+
+	SteerShips(DeltaTime);
+	MoveShips(DeltaTime);
+
+	PromotionAccumulator += DeltaTime;
+	if (PromotionAccumulator >= PromotionInterval)
+	{
+		PromotionAccumulator = 0.0f;
+		PromoteShipsNearSources();
+	}
+
+	SyncActors();
+	RenderShips();
+}
+
+void UEnemySwarmSubsystem::RefreshTargetPoints()
+{
+	TargetPoints.Reset();
+
+	const UStructureRegistrySubsystem* StructureRegistry = GetWorld()->GetSubsystem<UStructureRegistrySubsystem>();
+	if (!StructureRegistry) return;
+
+	for (const AStructure* Structure : StructureRegistry->GetAllStructures())
+	{
+		if (IsValid(Structure)) TargetPoints.Add(Structure->GetActorLocation());
+	}
+}
+
+void UEnemySwarmSubsystem::RetargetShips()
+{
+	if (TargetPoints.IsEmpty()) return;
+
+	SCOPE_CYCLE_COUNTER(STAT_SwarmRetarget);
+
+	const int32 Slice = RetargetCursor;
+	const int32 NumSlices = FMath::Max(RetargetSlices, 1);
+	RetargetCursor = (RetargetCursor + 1) % NumSlices;
+
+	const int32 NumInSlice = FMath::DivideAndRoundUp(FMath::Max(Positions.Num() - Slice, 0), NumSlices);
+	ParallelFor(NumInSlice, [this, Slice, NumSlices](int32 i)
+	{
+		const int32 Ship = Slice + i * NumSlices;
+
+		double ClosestDistanceSquared = TNumericLimits<double>::Max();
+		for (const FVector& TargetPoint : TargetPoints)
+		{
+			const double DistanceSquared = FVector::DistSquared(Positions[Ship], TargetPoint);
+			if (DistanceSquared < ClosestDistanceSquared)
+			{
+				ClosestDistanceSquared = DistanceSquared;
+				TargetLocations[Ship] = TargetPoint;
+			}
+		}
+	}, NumInSlice < MinParallelShips ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+}
+
+void UEnemySwarmSubsystem::SteerShips(float DeltaTime)
+{
+	UpdateSpatialHash();
+
+	SCOPE_CYCLE_COUNTER(STAT_SwarmSteer);
+
+	const int32 NumShips = Positions.Num();
+	NewVelocities.SetNum(NumShips, EAllowShrinking::No);
+
+	ParallelFor(NumShips, [this, DeltaTime](int32 Ship)
+	{
+		const FEnemySwarmClass& SwarmClass = ShipClasses[ClassIndices[Ship]];
+		const FVector Position = Positions[Ship];
+		const FVector Velocity = Velocities[Ship];
+
+		// Fly at the target until in range, then circle it.
+		FVector Desired = FVector::ZeroVector;
+		const FVector ToTarget = TargetLocations[Ship] - Position;
+		const double TargetDistance = ToTarget.Size();
+		if (TargetDistance > SwarmClass.AttackRange)
+		{
+			Desired = ToTarget / TargetDistance * SwarmClass.MaxSpeed;
+		}
+		else if (TargetDistance > UE_KINDA_SMALL_NUMBER)
+		{
+			Desired = FVector::CrossProduct(ToTarget / TargetDistance, FVector::UpVector) * SwarmClass.MaxSpeed * 0.5f;
+		}
+
+		// Push away from neighbours, harder the closer they are.
+		FVector Separation = FVector::ZeroVector;
+		int32 NumNeighbors = 0;
+		const double SeparationRadiusSquared = FMath::Square(static_cast<double>(SeparationRadius));
+		const FIntVector Cell = WorldToCell(Position);
+		for (int32 Z = Cell.Z - 1; Z <= Cell.Z + 1 && NumNeighbors < MaxNeighbors; Z++)
+		{
+			for (int32 Y = Cell.Y - 1; Y <= Cell.Y + 1 && NumNeighbors < MaxNeighbors; Y++)
+			{
+				for (int32 X = Cell.X - 1; X <= Cell.X + 1 && NumNeighbors < MaxNeighbors; X++)
+				{
+					const FIntPoint* CellRange = CellRanges.Find(PackCell(FIntVector(X, Y, Z)));
+					if (!CellRange) continue;
+
+					for (int32 Entry = CellRange->X; Entry < CellRange->X + CellRange->Y && NumNeighbors < MaxNeighbors; Entry++)
+					{
+						const int32 Other = CellEntries[Entry].Ship;
+						if (Other == Ship) continue;
+
+						const FVector Away = Position - Positions[Other];
+						const double DistanceSquared = Away.SizeSquared();
+						if (DistanceSquared >= SeparationRadiusSquared || DistanceSquared < UE_KINDA_SMALL_NUMBER) continue;
+
+						Separation += Away / DistanceSquared;
+						NumNeighbors++;
+					}
+				}
+			}
+		}
+		Desired += Separation * SeparationRadius * SeparationWeight * SwarmClass.MaxSpeed;
+
+		const FVector Steering = (Desired - Velocity).GetClampedToMaxSize(SwarmClass.MaxAcceleration * DeltaTime);
+		NewVelocities[Ship] = (Velocity + Steering).GetClampedToMaxSize(SwarmClass.MaxSpeed);
+	}, NumShips < MinParallelShips ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+}
+
+void UEnemySwarmSubsystem::MoveShips(float DeltaTime)
+{
+	const int32 NumShips = Positions.Num();
+	FVector* RESTRICT ShipPositions = Positions.GetData();
+	FVector* RESTRICT ShipVelocities = Velocities.GetData();
+	const FVector* RESTRICT ShipNewVelocities = NewVelocities.GetData();
+
+	for (int32 i = 0; i < NumShips; i++)
+	{
+		ShipVelocities[i] = ShipNewVelocities[i];
+		ShipPositions[i] += ShipVelocities[i] * DeltaTime;
+	}
+
+	// Rebuilt right away, so traces made during the rest of the frame see where the ships are now.
+	bHashDirty = true;
+	UpdateSpatialHash();
+}
+
+void UEnemySwarmSubsystem::PromoteShipsNearSources()
+{
+	PromotionSources.RemoveAll([](const TWeakObjectPtr<AActor>& Source) { return !Source.IsValid(); });
+
+	const double PromotionRadiusSquared = FMath::Square(static_cast<double>(PromotionRadius));
+	for (const TWeakObjectPtr<AActor>& Source : PromotionSources)
+	{
+		const FVector SourceLocation = Source->GetActorLocation();
+		for (int32 i = 0; i < Positions.Num(); i++)
+		{
+			if (!Actors[i] && FVector::DistSquared(SourceLocation, Positions[i]) < PromotionRadiusSquared) PromoteShip(i);
+		}
+	}
+}
+
+void UEnemySwarmSubsystem::SyncActors()
+{
+	SCOPE_CYCLE_COUNTER(STAT_SwarmSyncActors);
+
+	int32 NumPromoted = 0;
+	for (int32 i = 0; i < Actors.Num(); i++)
+	{
+		if (!Actors[i]) continue;
+
+		Actors[i]->SetActorLocationAndRotation(Positions[i], Velocities[i].ToOrientationRotator());
+		NumPromoted++;
+	}
+
+	SET_DWORD_STAT(STAT_SwarmPromotedShips, NumPromoted);
+}
+
+void UEnemySwarmSubsystem::RenderShips()
+{
+	SCOPE_CYCLE_COUNTER(STAT_SwarmRender);
+
+	for (int32 ClassIndex = 0; ClassIndex < ShipClasses.Num(); ClassIndex++)
+	{
+		const FEnemySwarmClass& SwarmClass = ShipClasses[ClassIndex];
+		if (!SwarmClass.InstancedMesh) continue;
+
+		// Promoted ships are drawn by their actor.
+		InstanceTransforms.Reset();
+		for (int32 i = 0; i < Positions.Num(); i++)
+		{
+			if (ClassIndices[i] != ClassIndex || Actors[i]) continue;
+
+			InstanceTransforms.Add(SwarmClass.MeshTransform * FTransform(Velocities[i].ToOrientationQuat(), Positions[i]));
+		}
+
+		AInstancedRenderActor::UpdateInstances(SwarmClass.InstancedMesh, InstanceTransforms);
+	}
+}
+
+int32 UEnemySwarmSubsystem::TraceShips(const FVector& Start, const FVector& End, float Radius, float& OutTime) const
+{
+	OutTime = 1.0f;
+	if (CellEntries.IsEmpty()) return INDEX_NONE;
+
+	const FVector SearchExtent(Radius + MaxShipRadius);
+	const FIntVector MinCell = WorldToCell(Start.ComponentMin(End) - SearchExtent);
+	const FIntVector MaxCell = WorldToCell(Start.ComponentMax(End) + SearchExtent);
+
+	const FVector Direction = End - Start;
+	const double DirectionSizeSquared = FMath::Max(Direction.SizeSquared(), UE_SMALL_NUMBER);
+
+	int32 HitShip = INDEX_NONE;
+	auto TraceCell = [&](const FIntPoint& CellRange)
+	{
+		for (int32 Entry = CellRange.X; Entry < CellRange.X + CellRange.Y; Entry++)
+		{
+			const int32 Ship = CellEntries[Entry].Ship;
+			const double CombinedRadius = Radius + ShipClasses[ClassIndices[Ship]].Radius;
+
+			// Sphere against sphere, solved as a ray against a sphere of both radii.
+			const FVector FromShip = Start - Positions[Ship];
+			const double B = FVector::DotProduct(FromShip, Direction);
+			const double C = FromShip.SizeSquared() - CombinedRadius * CombinedRadius;
+			const double Discriminant = B * B - DirectionSizeSquared * C;
+			if (Discriminant < 0.0) continue;
+
+			const double Time = C <= 0.0 ? 0.0 : (-B - FMath::Sqrt(Discriminant)) / DirectionSizeSquared;
+			if (Time >= 0.0 && Time < OutTime)
+			{
+				OutTime = Time;
+				HitShip = Ship;
+			}
+		}
+	};
+
+	// Long traces through a sparse swarm are cheaper to test against every occupied cell.
+	const int64 NumCells = static_cast<int64>(MaxCell.X - MinCell.X + 1) * (MaxCell.Y - MinCell.Y + 1) * (MaxCell.Z - MinCell.Z + 1);
+	if (NumCells > CellRanges.Num())
+	{
+		for (const TPair<uint64, FIntPoint>& Pair : CellRanges)
+		{
+			TraceCell(Pair.Value);
+		}
+		return HitShip;
+	}
+
+	for (int32 Z = MinCell.Z; Z <= MaxCell.Z; Z++)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+		{
+			for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+			{
+				if (const FIntPoint* CellRange = CellRanges.Find(PackCell(FIntVector(X, Y, Z)))) TraceCell(*CellRange);
+			}
+		}
+	}
+
+	return HitShip;
+}
+
+static FAutoConsoleCommandWithWorldAndArgs SpawnSwarmCommand(
+	TEXT("StrategyGame.SpawnSwarm"),
+	TEXT("Spawns a fleet of swarm ships. Usage: StrategyGame.SpawnSwarm [Count=5000] [Radius=20000] [Distance=50000] [Class=ShipClassPath]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UEnemySwarmSubsystem* Swarm = World ? World->GetSubsystem<UEnemySwarmSubsystem>() : nullptr;
+		if (!Swarm) return;
+
+		int32 Count = 5000;
+		float Radius = 20000.0f;
+		float Distance = 50000.0f;
+		FString ShipClassPath;
+
+		for (const FString& Arg : Args)
+		{
+			FString Key, Value;
+			if (!Arg.Split(TEXT("="), &Key, &Value)) continue;
+
+			if (Key == TEXT("Count")) Count = FMath::Max(FCString::Atoi(*Value), 0);
+			else if (Key == TEXT("Radius")) Radius = FMath::Max(FCString::Atof(*Value), 0.0f);
+			else if (Key == TEXT("Distance")) Distance = FCString::Atof(*Value);
+			else if (Key == TEXT("Class")) ShipClassPath = Value;
+		}
+
+		TSubclassOf<AEnemyShip> ShipClass = AEnemyShip::StaticClass();
+		if (!ShipClassPath.IsEmpty())
+		{
+			ShipClass = LoadClass<AEnemyShip>(nullptr, *ShipClassPath);
+			if (!ShipClass)
+			{
+				UE_LOG(LogStrategyGame, Warning, TEXT("SpawnSwarm: couldn't load ship class %s"), *ShipClassPath);
+				return;
+			}
+		}
+
+		const FVector Center = FVector(FMath::VRand().GetSafeNormal2D() * Distance) + FVector(0.0f, 0.0f, Radius);
+		Swarm->SpawnFleet(ShipClass, Center, Count, Radius);
+
+		UE_LOG(LogStrategyGame, Log, TEXT("SpawnSwarm: spawned %d ships, %d in the swarm"), Count, Swarm->GetNumShips());
+	}));
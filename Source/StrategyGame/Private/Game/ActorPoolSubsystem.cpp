@@ -0,0 +1,144 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Game/ActorPoolSubsystem.h"
+
+#include "StrategyGame.h"
+#include "Interfaces/PoolableInterface.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Actor Pool Hits"), STAT_ActorPoolHits, STATGROUP_StrategyGame);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Actor Pool Misses"), STAT_ActorPoolMisses, STATGROUP_StrategyGame);
+
+bool UActorPoolSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UActorPoolSubsystem::Deinitialize()
+{
+	Pools.Empty();
+	PooledActors.Empty();
+
+	Super::Deinitialize();
+}
+
+void UActorPoolSubsystem::DeactivateActor(AActor* Actor)
+{
+	Actor->SetActorHiddenInGame(true);
+	Actor->SetActorEnableCollision(false);
+	Actor->SetActorTickEnabled(false);
+}
+
+AActor* UActorPoolSubsystem::AcquireActor(TSubclassOf<AActor> ActorClass, const FTransform& Transform)
+{
+	if (!ActorClass) return nullptr;
+
+	FActorPool& Pool = Pools.FindOrAdd(ActorClass);
+
+	// Pooled actors can still be destroyed from outside, like when their level unloads.
+	while (!Pool.FreeActors.IsEmpty())
+	{
+		AActor* Actor = Pool.FreeActors.Pop(EAllowShrinking::No);
+		PooledActors.Remove(Actor);
+		if (!IsValid(Actor)) continue;
+
+		Pool.Stats.Hits++;
+		Pool.Stats.Pooled = Pool.FreeActors.Num();
+		INC_DWORD_STAT(STAT_ActorPoolHits);
+
+		Actor->SetActorTransform(Transform, false, nullptr, ETeleportType::ResetPhysics);
+		Actor->SetActorHiddenInGame(false);
+		Actor->SetActorEnableCollision(true);
+		IPoolableInterface::Execute_OnAcquiredFromPool(Actor);
+		return Actor;
+	}
+
+	Pool.Stats.Misses++;
+	Pool.Stats.Pooled = 0;
+	INC_DWORD_STAT(STAT_ActorPoolMisses);
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	return GetWorld()->SpawnActor<AActor>(ActorClass, Transform, SpawnParameters);
+}
+
+void UActorPoolSubsystem::ReleaseActor(AActor* Actor)
+{
+	if (!IsValid(Actor) || PooledActors.Contains(Actor)) return;
+
+	FActorPool& Pool = Pools.FindOrAdd(Actor->GetClass());
+	Pool.Stats.Releases++;
+
+	if (!Actor->Implements<UPoolableInterface>() || Pool.FreeActors.Num() >= Pool.MaxSize)
+	{
+		Pool.Stats.Discards++;
+		Actor->Destroy();
+		return;
+	}
+
+	IPoolableInterface::Execute_OnReturnedToPool(Actor);
+	DeactivateActor(Actor);
+
+	Pool.FreeActors.Add(Actor);
+	Pool.Stats.Pooled = Pool.FreeActors.Num();
+	PooledActors.Add(Actor);
+}
+
+void UActorPoolSubsystem::PrewarmPool(TSubclassOf<AActor> ActorClass, int32 Count)
+{
+	if (!ActorClass || !ActorClass->ImplementsInterface(UPoolableInterface::StaticClass())) return;
+
+	FActorPool& Pool = Pools.FindOrAdd(ActorClass);
+	Pool.MaxSize = FMath::Max(Pool.MaxSize, Count);
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	while (Pool.FreeActors.Num() < Count)
+	{
+		AActor* Actor = GetWorld()->SpawnActor<AActor>(ActorClass, FTransform::Identity, SpawnParameters);
+		if (!Actor) break;
+
+		IPoolableInterface::Execute_OnReturnedToPool(Actor);
+		DeactivateActor(Actor);
+
+		Pool.FreeActors.Add(Actor);
+		PooledActors.Add(Actor);
+	}
+
+	Pool.Stats.Pooled = Pool.FreeActors.Num();
+}
+
+void UActorPoolSubsystem::SetMaxPoolSize(TSubclassOf<AActor> ActorClass, int32 MaxSize)
+{
+	if (ActorClass) Pools.FindOrAdd(ActorClass).MaxSize = FMath::Max(MaxSize, 0);
+}
+
+FActorPoolStats UActorPoolSubsystem::GetPoolStats(TSubclassOf<AActor> ActorClass) const
+{
+	const FActorPool* Pool = Pools.Find(ActorClass);
+	return Pool ? Pool->Stats : FActorPoolStats();
+}
+
+void UActorPoolSubsystem::LogPoolStats() const
+{
+	for (const TPair<UClass*, FActorPool>& Pair : Pools)
+	{
+		const FActorPoolStats& Stats = Pair.Value.Stats;
+		const int32 Acquires = Stats.Hits + Stats.Misses;
+		UE_LOG(LogStrategyGame, Log, TEXT("%-40s hits %6d  misses %6d  hit rate %5.1f%%  releases %6d  discards %6d  pooled %4d / %d"),
+			*GetNameSafe(Pair.Key), Stats.Hits, Stats.Misses, Acquires > 0 ? 100.0f * Stats.Hits / Acquires : 0.0f,
+			Stats.Releases, Stats.Discards, Stats.Pooled, Pair.Value.MaxSize);
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs PoolStatsCommand(
+	TEXT("StrategyGame.PoolStats"),
+	TEXT("Logs hit and miss counts for every actor pool."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (const UActorPoolSubsystem* ActorPool = World ? World->GetSubsystem<UActorPoolSubsystem>() : nullptr)
+		{
+			ActorPool->LogPoolStats();
+		}
+	}));
@@ -0,0 +1,290 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Game/EconomySubsystem.h"
+
+#include "StrategyGame.h"
+#include "Building/Structure.h"
+#include "Game/ResourceFieldSubsystem.h"
+#include "Game/StrategyGameModeBase.h"
+
+DECLARE_CYCLE_STAT(TEXT("Economy Step"), STAT_EconomyStep, STATGROUP_StrategyGame);
+DECLARE_CYCLE_STAT(TEXT("Economy Fast Forward"), STAT_EconomyFastForward, STATGROUP_StrategyGame);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Economy Structures"), STAT_EconomyStructures, STATGROUP_StrategyGame);
+
+static TAutoConsoleVariable<bool> CVarLogEconomyStepCost(
+	TEXT("StrategyGame.Economy.LogStepCost"),
+	false,
+	TEXT("Logs the cost of every economy step along with the number of registered structures."));
+
+bool UEconomySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UEconomySubsystem::RemoveEntry(TArray<AStructure*>& Structures, TArray<const FStructureDescriptor*>* Descriptors, AStructure* Structure)
+{
+	// Searched from the back, structures are usually removed in roughly the reverse order they were registered.
+	const int32 Index = Structures.FindLast(Structure);
+	if (Index == INDEX_NONE) return;
+
+	Structures.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	if (Descriptors) Descriptors->RemoveAtSwap(Index, 1, EAllowShrinking::No);
+}
+
+void UEconomySubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (StrategyGameState == nullptr)
+	{
+		StrategyGameState = GetWorld()->GetGameState<AStrategyGameState>();
+		if (StrategyGameState == nullptr) return;
+	}
+
+	StepAccumulator += DeltaTime * StrategyGameState->GetSimulationSpeed();
+
+	// Run whole steps until the frame's simulation budget is spent.
+	const double BudgetSeconds = StrategyGameState->GetStrategyGameMode() ? StrategyGameState->GetStrategyGameMode()->GetSimulationBudgetMilliseconds() / 1000.0 : 0.002;
+	const double StartTime = FPlatformTime::Seconds();
+	while (StepAccumulator >= StepSeconds)
+	{
+		StepAccumulator -= StepSeconds;
+		StepEconomy();
+
+		if (FPlatformTime::Seconds() - StartTime >= BudgetSeconds) break;
+	}
+
+	// Rather than letting the backlog grow every frame at high speeds, apply it in one closed form step.
+	if (StepAccumulator >= StepSeconds * MaxBacklogSteps)
+	{
+		const float Backlog = StepAccumulator;
+		StepAccumulator = 0.0f;
+		FastForward(Backlog);
+	}
+}
+
+TStatId UEconomySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UEconomySubsystem, STATGROUP_Tickables);
+}
+
+void UEconomySubsystem::RegisterProducer(AStructure* Structure)
+{
+	if (!Structure || Producers.Contains(Structure)) return;
+
+	Producers.Add(Structure);
+	ProducerDescriptors.Add(&Structure->GetStructureDescriptor());
+}
+
+void UEconomySubsystem::RegisterConsumer(AStructure* Structure)
+{
+	if (!Structure || Consumers.Contains(Structure)) return;
+
+	Consumers.Add(Structure);
+	ConsumerDescriptors.Add(&Structure->GetStructureDescriptor());
+}
+
+void UEconomySubsystem::RegisterExtractor(AStructure* Structure)
+{
+	if (!Structure) return;
+
+	Extractors.AddUnique(Structure);
+}
+
+void UEconomySubsystem::UnregisterStructure(AStructure* Structure)
+{
+	RemoveEntry(Producers, &ProducerDescriptors, Structure);
+	RemoveEntry(Consumers, &ConsumerDescriptors, Structure);
+	RemoveEntry(Extractors, nullptr, Structure);
+}
+
+void UEconomySubsystem::SumStepTotals(float* OutGenerated, float* OutConsumed) const
+{
+	FMemory::Memzero(OutGenerated, sizeof(float) * NumResourceTypes);
+	FMemory::Memzero(OutConsumed, sizeof(float) * NumResourceTypes);
+
+	for (int32 i = 0; i < Producers.Num(); i++)
+	{
+		const float Scale = Producers[i]->GetWorkerEfficiency() * StepSeconds;
+		const float* Rates = ProducerDescriptors[i]->GenerationRates;
+		for (int32 Resource = 0; Resource < NumResourceTypes; Resource++)
+		{
+			OutGenerated[Resource] += Rates[Resource] * Scale;
+		}
+	}
+
+	for (int32 i = 0; i < Consumers.Num(); i++)
+	{
+		const float Scale = Consumers[i]->GetWorkerEfficiency() * StepSeconds;
+		const float* Rates = ConsumerDescriptors[i]->ConsumptionRates;
+		for (int32 Resource = 0; Resource < NumResourceTypes; Resource++)
+		{
+			OutConsumed[Resource] += Rates[Resource] * Scale;
+		}
+	}
+}
+
+void UEconomySubsystem::StepEconomy()
+{
+	SCOPE_CYCLE_COUNTER(STAT_EconomyStep);
+	SET_DWORD_STAT(STAT_EconomyStructures, GetRegisteredStructureCount());
+
+	if (StrategyGameState == nullptr)
+	{
+		StrategyGameState = GetWorld()->GetGameState<AStrategyGameState>();
+		if (StrategyGameState == nullptr) return;
+	}
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	// Sum every producer and consumer into one total per resource, so the game state is only touched once per resource.
+	float Generated[NumResourceTypes];
+	float Consumed[NumResourceTypes];
+	SumStepTotals(Generated, Consumed);
+
+	for (EResourceType ResourceType : TEnumRange<EResourceType>())
+	{
+		const int32 Resource = static_cast<int32>(ResourceType);
+		if (Generated[Resource] > 0.0f)
+		{
+			StrategyGameState->AddResources(ResourceType, Generated[Resource]);
+		}
+		const float AmountToConsume = FMath::Min(Consumed[Resource], StrategyGameState->GetResourceAmount(ResourceType));
+		if (AmountToConsume > 0.0f)
+		{
+			StrategyGameState->ConsumeResources(ResourceType, AmountToConsume);
+		}
+	}
+
+	if (UResourceFieldSubsystem* ResourceField = GetWorld()->GetSubsystem<UResourceFieldSubsystem>())
+	{
+		ResourceField->StepExtraction(Extractors, StrategyGameState, StepSeconds);
+	}
+
+	LastStepMilliseconds = static_cast<float>(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles));
+	AverageStepMilliseconds = StepCount == 0 ? LastStepMilliseconds : FMath::Lerp(AverageStepMilliseconds, LastStepMilliseconds, 0.1f);
+	StepCount++;
+
+	UE_CLOG(CVarLogEconomyStepCost.GetValueOnGameThread(), LogStrategyGame, Log, TEXT("Economy step: %.3f ms for %d structures (%.3f us per structure)"),
+		LastStepMilliseconds, GetRegisteredStructureCount(), GetMicrosecondsPerStructure());
+}
+
+float UEconomySubsystem::StepAmount(float Amount, float Capacity, float Generated, float Consumed)
+{
+	// The same clamps AStrategyGameState::AddResources and ConsumeResources apply, so it matches StepEconomy exactly.
+	if (Generated > 0.0f && Amount < Capacity) Amount = FMath::Clamp(Amount + Generated, 0.0f, Capacity);
+
+	const float AmountToConsume = FMath::Min(Consumed, Amount);
+	if (AmountToConsume > 0.0f) Amount = FMath::Clamp(Amount - AmountToConsume, 0.0f, Capacity);
+
+	return Amount;
+}
+
+float UEconomySubsystem::AmountAfterSteps(float Amount, float Capacity, float Generated, float Consumed, int64 Steps)
+{
+	if (Steps <= 0) return Amount;
+
+	// A single step is Amount = Max(Min(Amount + Generated, Capacity) - Consumed, 0).
+	// That only ever moves in one direction, so after the first step it's a straight line that hits one clamp and stays there.
+	const float Net = Generated - Consumed;
+	if (Net >= 0.0f)
+	{
+		return FMath::Max(FMath::Min(Amount + Steps * Net, Capacity - Consumed), 0.0f);
+	}
+
+	return FMath::Max(FMath::Min(Amount, Capacity - Generated) + Steps * Net, 0.0f);
+}
+
+void UEconomySubsystem::FastForward(float Seconds)
+{
+	if (Seconds <= 0.0f) return;
+
+	StepAccumulator += Seconds;
+	const int64 NumSteps = FMath::FloorToInt64(StepAccumulator / StepSeconds);
+	StepAccumulator -= NumSteps * StepSeconds;
+
+	FastForwardSteps(NumSteps);
+}
+
+void UEconomySubsystem::FastForwardSteps(int64 NumSteps)
+{
+	SCOPE_CYCLE_COUNTER(STAT_EconomyFastForward);
+
+	if (NumSteps <= 0) return;
+
+	if (StrategyGameState == nullptr)
+	{
+		StrategyGameState = GetWorld()->GetGameState<AStrategyGameState>();
+		if (StrategyGameState == nullptr) return;
+	}
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	float Generated[NumResourceTypes];
+	float Consumed[NumResourceTypes];
+	SumStepTotals(Generated, Consumed);
+
+	float Amounts[NumResourceTypes];
+	float Capacities[NumResourceTypes];
+	for (EResourceType ResourceType : TEnumRange<EResourceType>())
+	{
+		const int32 Resource = static_cast<int32>(ResourceType);
+		Amounts[Resource] = StrategyGameState->GetResourceAmount(ResourceType);
+		Capacities[Resource] = StrategyGameState->GetResourceLedger().GetCapacity(ResourceType);
+	}
+
+	UResourceFieldSubsystem* ResourceField = GetWorld()->GetSubsystem<UResourceFieldSubsystem>();
+
+	// Extraction adds to the storage that decides whether extractors run, so resources with extractors are stepped.
+	TArray<UResourceFieldSubsystem::FExtractorStep> ExtractorSteps;
+	const uint32 ExtractedMask = ResourceField ? ResourceField->GatherExtractors(Extractors, StepSeconds, ExtractorSteps) : 0;
+
+	for (EResourceType ResourceType : TEnumRange<EResourceType>())
+	{
+		const int32 Resource = static_cast<int32>(ResourceType);
+		if (!(ExtractedMask & (1u << Resource))) Amounts[Resource] = AmountAfterSteps(Amounts[Resource], Capacities[Resource], Generated[Resource], Consumed[Resource], NumSteps);
+	}
+
+	// Stops as soon as a step changes nothing, since every step after it would be the same.
+	// That's usually once storage fills up or the nodes run dry, so a long skip only costs as many steps as it takes to settle.
+	int64 Step = 0;
+	while (ExtractedMask && Step < NumSteps)
+	{
+		Step++;
+
+		bool bAmountsChanged = false;
+		for (int32 Resource = 0; Resource < NumResourceTypes; Resource++)
+		{
+			if (!(ExtractedMask & (1u << Resource))) continue;
+
+			const float Amount = StepAmount(Amounts[Resource], Capacities[Resource], Generated[Resource], Consumed[Resource]);
+			bAmountsChanged |= Amount != Amounts[Resource];
+			Amounts[Resource] = Amount;
+		}
+
+		float AmountsBeforeExtraction[NumResourceTypes];
+		FMemory::Memcpy(AmountsBeforeExtraction, Amounts, sizeof(Amounts));
+
+		const bool bExtracted = ResourceField->ExtractStep(ExtractorSteps, Amounts, Capacities, StepSeconds);
+		ResourceField->AdvanceRegeneration(StepSeconds);
+
+		if (!bExtracted && !bAmountsChanged && FMemory::Memcmp(AmountsBeforeExtraction, Amounts, sizeof(Amounts)) == 0) break;
+	}
+
+	for (EResourceType ResourceType : TEnumRange<EResourceType>())
+	{
+		const int32 Resource = static_cast<int32>(ResourceType);
+		StrategyGameState->SetResourceAmount(ResourceType, Amounts[Resource]);
+	}
+
+	// Nodes nobody is extracting from only regenerate for the rest of the skip, in at most a few substeps.
+	const int64 StepsLeft = NumSteps - Step;
+	if (ResourceField && StepsLeft > 0)
+	{
+		ResourceField->AdvanceRegeneration(StepsLeft * StepSeconds, static_cast<int32>(FMath::Min<int64>(StepsLeft, 16)));
+	}
+
+	UE_CLOG(CVarLogEconomyStepCost.GetValueOnGameThread(), LogStrategyGame, Log, TEXT("Economy fast forward: %lld steps in %.3f ms for %d structures"),
+		NumSteps, FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles), GetRegisteredStructureCount());
+}
@@ -0,0 +1,177 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Game/HealthSubsystem.h"
+
+#include "StrategyGame.h"
+#include "Components/HealthComponent.h"
+#include "Engine/DamageEvents.h"
+#include "Game/ActorPoolSubsystem.h"
+
+DECLARE_CYCLE_STAT(TEXT("Health Resolve Damage"), STAT_HealthResolveDamage, STATGROUP_StrategyGame);
+DECLARE_CYCLE_STAT(TEXT("Health Events"), STAT_HealthEvents, STATGROUP_StrategyGame);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Health Queued Damage"), STAT_HealthQueuedDamage, STATGROUP_StrategyGame);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Health Damaged Components"), STAT_HealthDamagedComponents, STATGROUP_StrategyGame);
+
+bool UHealthSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UHealthSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHealthSubsystem, STATGROUP_Tickables);
+}
+
+void UHealthSubsystem::Deinitialize()
+{
+	Components.Empty();
+	Health.Empty();
+	Dead.Empty();
+	OwnerIndices.Empty();
+	DamageQueue.Empty();
+	HealthEvents.Empty();
+
+	Super::Deinitialize();
+}
+
+void UHealthSubsystem::RegisterHealth(UHealthComponent* HealthComponent)
+{
+	if (!HealthComponent || HealthComponent->PoolIndex != INDEX_NONE) return;
+
+	// A second component would take over every hit queued against the owner, leaving the first one unkillable.
+	if (!ensureMsgf(!OwnerIndices.Contains(HealthComponent->GetOwner()), TEXT("%s already has a health component, %s won't take damage."),
+		*GetNameSafe(HealthComponent->GetOwner()), *HealthComponent->GetName()))
+	{
+		return;
+	}
+
+	HealthComponent->PoolIndex = Components.Add(HealthComponent);
+	Health.Add(HealthComponent->MaxHealth);
+	Dead.Add(false);
+
+	OwnerIndices.Add(HealthComponent->GetOwner(), HealthComponent->PoolIndex);
+}
+
+void UHealthSubsystem::UnregisterHealth(UHealthComponent* HealthComponent)
+{
+	if (!HealthComponent || !Components.IsValidIndex(HealthComponent->PoolIndex)) return;
+
+	const int32 Index = HealthComponent->PoolIndex;
+	OwnerIndices.Remove(HealthComponent->GetOwner());
+	HealthComponent->PoolIndex = INDEX_NONE;
+
+	Components.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Health.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Dead.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+
+	if (Components.IsValidIndex(Index))
+	{
+		Components[Index]->PoolIndex = Index;
+		OwnerIndices.Add(Components[Index]->GetOwner(), Index);
+	}
+}
+
+void UHealthSubsystem::ResetHealth(int32 PoolIndex)
+{
+	if (!Components.IsValidIndex(PoolIndex)) return;
+
+	Health[PoolIndex] = Components[PoolIndex]->MaxHealth;
+	Dead[PoolIndex] = false;
+}
+
+void UHealthSubsystem::QueueDamage(AActor* Target, float Damage, AActor* DamageCauser)
+{
+	if (!Target || Damage == 0.0f) return;
+
+	DamageQueue.Add({ Target, DamageCauser, Damage });
+}
+
+void UHealthSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	ResolveDamage();
+}
+
+void UHealthSubsystem::ApplyUnpooledDamage(const FQueuedDamage& QueuedDamage)
+{
+	AActor* Target = QueuedDamage.Target.Get();
+	if (!IsValid(Target) || QueuedDamage.Damage <= 0.0f) return;
+
+	AActor* Causer = QueuedDamage.Causer.Get();
+	Target->TakeDamage(QueuedDamage.Damage, FDamageEvent(), Causer ? Causer->GetInstigatorController() : nullptr, Causer);
+}
+
+void UHealthSubsystem::ResolveDamage()
+{
+	SET_DWORD_STAT(STAT_HealthQueuedDamage, DamageQueue.Num());
+	if (DamageQueue.IsEmpty()) return;
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_HealthResolveDamage);
+
+		// Moved out first, so damage queued by the events below lands in the next pass.
+		TArray<FQueuedDamage> Queue = MoveTemp(DamageQueue);
+		DamageQueue.Reset();
+
+		PendingDamage.SetNumZeroed(Components.Num(), EAllowShrinking::No);
+		PendingCausers.SetNum(Components.Num(), EAllowShrinking::No);
+		DamagedIndices.Reset();
+
+		// Sums the damage per component, the last hit gets credit for the kill.
+		for (const FQueuedDamage& QueuedDamage : Queue)
+		{
+			const int32* Index = OwnerIndices.Find(QueuedDamage.Target.Get());
+			if (!Index)
+			{
+				ApplyUnpooledDamage(QueuedDamage);
+				continue;
+			}
+
+			if (PendingDamage[*Index] == 0.0f) DamagedIndices.Add(*Index);
+			PendingDamage[*Index] += QueuedDamage.Damage;
+			PendingCausers[*Index] = QueuedDamage.Causer;
+		}
+
+		SET_DWORD_STAT(STAT_HealthDamagedComponents, DamagedIndices.Num());
+
+		HealthEvents.Reset();
+		for (const int32 Index : DamagedIndices)
+		{
+			const float Damage = PendingDamage[Index];
+			PendingDamage[Index] = 0.0f;
+			if (Dead[Index] || Damage == 0.0f) continue;
+
+			Health[Index] = FMath::Clamp(Health[Index] - Damage, 0.0f, Components[Index]->MaxHealth);
+			const bool bDied = Health[Index] <= 0.0f;
+			Dead[Index] = bDied;
+
+			HealthEvents.Add({ Components[Index], PendingCausers[Index], Health[Index], Damage, bDied });
+			PendingCausers[Index] = nullptr;
+		}
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_HealthEvents);
+
+	UActorPoolSubsystem* ActorPool = GetWorld()->GetSubsystem<UActorPoolSubsystem>();
+
+	// The pool is settled by now, so handlers are free to destroy actors and spawn new ones.
+	for (const FHealthEvent& HealthEvent : HealthEvents)
+	{
+		UHealthComponent* HealthComponent = HealthEvent.Component.Get();
+		if (!IsValid(HealthComponent)) continue;
+
+		if (HealthComponent->OnHealthChanged.IsBound()) HealthComponent->OnHealthChanged.Broadcast(HealthComponent, HealthEvent.Health, HealthEvent.Damage);
+		if (!HealthEvent.bDied) continue;
+
+		if (HealthComponent->OnDeath.IsBound()) HealthComponent->OnDeath.Broadcast(HealthComponent, HealthEvent.Causer.Get());
+
+		// Poolable owners go back to the actor pool instead of being destroyed.
+		AActor* Owner = HealthComponent->GetOwner();
+		if (!HealthComponent->bDestroyOwnerOnDeath || !IsValid(Owner)) continue;
+
+		if (ActorPool) ActorPool->ReleaseActor(Owner);
+		else Owner->Destroy();
+	}
+}
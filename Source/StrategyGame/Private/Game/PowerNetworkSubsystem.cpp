@@ -0,0 +1,549 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Game/PowerNetworkSubsystem.h"
+
+#include "EngineUtils.h"
+#include "StrategyGame.h"
+#include "Building/Buildable.h"
+#include "Building/PowerLine.h"
+#include "Interfaces/PowerInterface.h"
+
+DECLARE_CYCLE_STAT(TEXT("Power Register Node"), STAT_PowerRegisterNode, STATGROUP_StrategyGame);
+DECLARE_CYCLE_STAT(TEXT("Power Unregister Node"), STAT_PowerUnregisterNode, STATGROUP_StrategyGame);
+DECLARE_CYCLE_STAT(TEXT("Power Split Network"), STAT_PowerSplitNetwork, STATGROUP_StrategyGame);
+DECLARE_CYCLE_STAT(TEXT("Power Solve"), STAT_PowerSolve, STATGROUP_StrategyGame);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Power Split Visited Nodes"), STAT_PowerSplitVisitedNodes, STATGROUP_StrategyGame);
+
+static bool HasGeneration(double Generation)
+{
+	return Generation > UE_KINDA_SMALL_NUMBER;
+}
+
+static float GetSatisfaction(double Generation, double Consumption)
+{
+	if (Consumption <= UE_KINDA_SMALL_NUMBER) return HasGeneration(Generation) ? 1.0f : 0.0f;
+	return FMath::Clamp(static_cast<float>(Generation / Consumption), 0.0f, 1.0f);
+}
+
+bool UPowerNetworkSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UPowerNetworkSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UPowerNetworkSubsystem, STATGROUP_Tickables);
+}
+
+void UPowerNetworkSubsystem::Deinitialize()
+{
+	Nodes.Empty();
+	NodeActors.Empty();
+	NodeIndices.Empty();
+	FreeNodes.Empty();
+	Networks.Empty();
+	FreeNetworks.Empty();
+	DirtyNetworks.Empty();
+	NodesToNotify.Empty();
+	CellNodes.Empty();
+	SearchQueues.Empty();
+
+	Super::Deinitialize();
+}
+
+void UPowerNetworkSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	for (TActorIterator<ABuildable> It(&InWorld); It; ++It)
+	{
+		if (It->Implements<UPowerInterface>() && It->IsConstructionComplete()) RegisterNode(*It);
+	}
+}
+
+FIntPoint UPowerNetworkSubsystem::WorldToCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt32(Location.X / CellSize), FMath::FloorToInt32(Location.Y / CellSize));
+}
+
+int32 UPowerNetworkSubsystem::AllocateNetwork()
+{
+	const int32 NetworkIndex = FreeNetworks.IsEmpty() ? Networks.AddDefaulted() : FreeNetworks.Pop(EAllowShrinking::No);
+
+	FPowerNetwork& Network = Networks[NetworkIndex];
+	Network.Members.Reset();
+	Network.Generation = 0.0;
+	Network.Consumption = 0.0;
+	Network.bConnected = false;
+	Network.Satisfaction = 0.0f;
+	Network.bDirty = false;
+
+	return NetworkIndex;
+}
+
+void UPowerNetworkSubsystem::FreeNetwork(int32 NetworkIndex)
+{
+	FPowerNetwork& Network = Networks[NetworkIndex];
+	Network.Members.Reset();
+	Network.bDirty = false;
+
+	FreeNetworks.Add(NetworkIndex);
+}
+
+void UPowerNetworkSubsystem::MarkNetworkDirty(int32 NetworkIndex)
+{
+	FPowerNetwork& Network = Networks[NetworkIndex];
+	if (Network.bDirty) return;
+
+	Network.bDirty = true;
+	DirtyNetworks.Add(NetworkIndex);
+}
+
+void UPowerNetworkSubsystem::AddToNetwork(int32 NodeIndex, int32 NetworkIndex)
+{
+	FPowerNode& Node = Nodes[NodeIndex];
+	FPowerNetwork& Network = Networks[NetworkIndex];
+
+	Node.Network = NetworkIndex;
+	Node.NetworkPosition = Network.Members.Add(NodeIndex);
+	Network.Generation += Node.Generation;
+	Network.Consumption += Node.Consumption;
+
+	MarkNetworkDirty(NetworkIndex);
+}
+
+void UPowerNetworkSubsystem::RemoveFromNetwork(int32 NodeIndex)
+{
+	FPowerNode& Node = Nodes[NodeIndex];
+	FPowerNetwork& Network = Networks[Node.Network];
+
+	Network.Members.RemoveAtSwap(Node.NetworkPosition, 1, EAllowShrinking::No);
+	if (Network.Members.IsValidIndex(Node.NetworkPosition))
+	{
+		Nodes[Network.Members[Node.NetworkPosition]].NetworkPosition = Node.NetworkPosition;
+	}
+
+	Network.Generation -= Node.Generation;
+	Network.Consumption -= Node.Consumption;
+	MarkNetworkDirty(Node.Network);
+
+	Node.Network = INDEX_NONE;
+	Node.NetworkPosition = INDEX_NONE;
+}
+
+int32 UPowerNetworkSubsystem::MergeNetworks(int32 NetworkA, int32 NetworkB)
+{
+	if (NetworkA == NetworkB) return NetworkA;
+
+	// Only the smaller network is relabeled, so a node can't be moved more than log(n) times.
+	const bool bKeepA = Networks[NetworkA].Members.Num() >= Networks[NetworkB].Members.Num();
+	const int32 Kept = bKeepA ? NetworkA : NetworkB;
+	const int32 Merged = bKeepA ? NetworkB : NetworkA;
+
+	FPowerNetwork& KeptNetwork = Networks[Kept];
+	FPowerNetwork& MergedNetwork = Networks[Merged];
+
+	for (const int32 Member : MergedNetwork.Members)
+	{
+		Nodes[Member].Network = Kept;
+		Nodes[Member].NetworkPosition = KeptNetwork.Members.Add(Member);
+		NodesToNotify.Add(Member);
+	}
+
+	KeptNetwork.Generation += MergedNetwork.Generation;
+	KeptNetwork.Consumption += MergedNetwork.Consumption;
+	MarkNetworkDirty(Kept);
+
+	FreeNetwork(Merged);
+	return Kept;
+}
+
+void UPowerNetworkSubsystem::RegisterNode(AActor* Actor)
+{
+	if (!IsValid(Actor) || !Actor->Implements<UPowerInterface>() || NodeIndices.Contains(Actor)) return;
+
+	SCOPE_CYCLE_COUNTER(STAT_PowerRegisterNode);
+
+	int32 NodeIndex;
+	if (FreeNodes.IsEmpty())
+	{
+		NodeIndex = Nodes.AddDefaulted();
+		NodeActors.Add(Actor);
+	}
+	else
+	{
+		NodeIndex = FreeNodes.Pop(EAllowShrinking::No);
+		Nodes[NodeIndex] = FPowerNode();
+		NodeActors[NodeIndex] = Actor;
+	}
+	NodeIndices.Add(Actor, NodeIndex);
+
+	FPowerNode& Node = Nodes[NodeIndex];
+	Node.Location = Actor->GetActorLocation();
+	Node.ConnectionRadius = FMath::Max(IPowerInterface::Execute_GetPowerConnectionRadius(Actor), 0.0f);
+	Node.Generation = FMath::Max(IPowerInterface::Execute_GetPowerGeneration(Actor), 0.0f);
+	Node.Consumption = FMath::Max(IPowerInterface::Execute_GetPowerConsumption(Actor), 0.0f);
+	Node.bPowerLine = Actor->IsA<APowerLine>();
+	MaxConnectionRadius = FMath::Max(MaxConnectionRadius, Node.ConnectionRadius);
+
+	// Links to every node in range. Two nodes are in range when their connection radii overlap.
+	const FIntPoint Cell = WorldToCell(Node.Location);
+	const int32 CellRadius = FMath::CeilToInt32((Node.ConnectionRadius + MaxConnectionRadius) / CellSize);
+	for (int32 Y = -CellRadius; Y <= CellRadius; Y++)
+	{
+		for (int32 X = -CellRadius; X <= CellRadius; X++)
+		{
+			const TArray<int32>* Candidates = CellNodes.Find(Cell + FIntPoint(X, Y));
+			if (!Candidates) continue;
+
+			for (const int32 Candidate : *Candidates)
+			{
+				FPowerNode& Other = Nodes[Candidate];
+				if (!Node.bPowerLine && !Other.bPowerLine) continue;
+
+				const float Reach = Node.ConnectionRadius + Other.ConnectionRadius;
+				if (FVector::DistSquared(Node.Location, Other.Location) > Reach * Reach) continue;
+
+				Node.Links.Add(Candidate);
+				Other.Links.Add(NodeIndex);
+			}
+		}
+	}
+
+	CellNodes.FindOrAdd(Cell).Add(NodeIndex);
+
+	int32 NetworkIndex = AllocateNetwork();
+	AddToNetwork(NodeIndex, NetworkIndex);
+	NodesToNotify.Add(NodeIndex);
+
+	for (const int32 Link : Nodes[NodeIndex].Links)
+	{
+		NetworkIndex = MergeNetworks(NetworkIndex, Nodes[Link].Network);
+	}
+}
+
+void UPowerNetworkSubsystem::UnregisterNode(AActor* Actor)
+{
+	int32 NodeIndex = INDEX_NONE;
+	if (!NodeIndices.RemoveAndCopyValue(Actor, NodeIndex)) return;
+
+	SCOPE_CYCLE_COUNTER(STAT_PowerUnregisterNode);
+
+	FPowerNode& Node = Nodes[NodeIndex];
+
+	const FIntPoint Cell = WorldToCell(Node.Location);
+	if (TArray<int32>* CellEntries = CellNodes.Find(Cell))
+	{
+		CellEntries->RemoveSingleSwap(NodeIndex, EAllowShrinking::No);
+		if (CellEntries->IsEmpty()) CellNodes.Remove(Cell);
+	}
+
+	for (const int32 Link : Node.Links)
+	{
+		Nodes[Link].Links.RemoveSingleSwap(NodeIndex, EAllowShrinking::No);
+	}
+
+	const int32 NetworkIndex = Node.Network;
+	RemoveFromNetwork(NodeIndex);
+
+	// Only a node that linked two or more others can have split its network.
+	if (Networks[NetworkIndex].Members.IsEmpty()) FreeNetwork(NetworkIndex);
+	else if (Node.Links.Num() > 1) SplitNetwork(NetworkIndex, Node.Links);
+
+	Nodes[NodeIndex].Links.Reset();
+	NodeActors[NodeIndex] = nullptr;
+	FreeNodes.Add(NodeIndex);
+}
+
+void UPowerNetworkSubsystem::RefreshNodeLoad(AActor* Actor)
+{
+	const int32* NodeIndex = NodeIndices.Find(Actor);
+	if (!NodeIndex) return;
+
+	FPowerNode& Node = Nodes[*NodeIndex];
+	FPowerNetwork& Network = Networks[Node.Network];
+	Network.Generation -= Node.Generation;
+	Network.Consumption -= Node.Consumption;
+
+	Node.Generation = FMath::Max(IPowerInterface::Execute_GetPowerGeneration(Actor), 0.0f);
+	Node.Consumption = FMath::Max(IPowerInterface::Execute_GetPowerConsumption(Actor), 0.0f);
+
+	Network.Generation += Node.Generation;
+	Network.Consumption += Node.Consumption;
+	MarkNetworkDirty(Node.Network);
+}
+
+int32 UPowerNetworkSubsystem::FindSearchGroup(int32 Search)
+{
+	while (SearchGroups[Search] != Search)
+	{
+		SearchGroups[Search] = SearchGroups[SearchGroups[Search]];
+		Search = SearchGroups[Search];
+	}
+	return Search;
+}
+
+void UPowerNetworkSubsystem::SplitNetwork(int32 NetworkIndex, const TArray<int32>& Seeds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_PowerSplitNetwork);
+
+	const int32 NumSearches = Seeds.Num();
+	SearchStamp++;
+
+	if (SearchQueues.Num() < NumSearches) SearchQueues.SetNum(NumSearches);
+	SearchHeads.SetNumUninitialized(NumSearches, EAllowShrinking::No);
+	SearchGroups.SetNumUninitialized(NumSearches, EAllowShrinking::No);
+
+	for (int32 Search = 0; Search < NumSearches; Search++)
+	{
+		FPowerNode& Seed = Nodes[Seeds[Search]];
+		Seed.SearchStamp = SearchStamp;
+		Seed.Search = Search;
+
+		SearchQueues[Search].Reset();
+		SearchQueues[Search].Add(Seeds[Search]);
+		SearchHeads[Search] = 0;
+		SearchGroups[Search] = Search;
+	}
+
+	int32 NumGroups = NumSearches;
+	int32 KeptGroup = INDEX_NONE;
+	int32 NumVisited = NumSearches;
+
+	while (true)
+	{
+		// Every search takes one step per round, so the searches on the small pieces run out first.
+		for (int32 Search = 0; Search < NumSearches; Search++)
+		{
+			TArray<int32>& Queue = SearchQueues[Search];
+			if (SearchHeads[Search] >= Queue.Num()) continue;
+
+			const int32 Current = Queue[SearchHeads[Search]++];
+			for (const int32 Link : Nodes[Current].Links)
+			{
+				FPowerNode& LinkNode = Nodes[Link];
+				if (LinkNode.SearchStamp != SearchStamp)
+				{
+					LinkNode.SearchStamp = SearchStamp;
+					LinkNode.Search = Search;
+					Queue.Add(Link);
+					NumVisited++;
+					continue;
+				}
+
+				const int32 GroupA = FindSearchGroup(Search);
+				const int32 GroupB = FindSearchGroup(LinkNode.Search);
+				if (GroupA == GroupB) continue;
+
+				SearchGroups[GroupB] = GroupA;
+				NumGroups--;
+			}
+		}
+
+		// Every search met up, so the network is still in one piece.
+		if (NumGroups == 1)
+		{
+			SET_DWORD_STAT(STAT_PowerSplitVisitedNodes, NumVisited);
+			return;
+		}
+
+		// Stops once at most one group is still searching. That one keeps the network, everything else split off.
+		int32 NumSearchingGroups = 0;
+		KeptGroup = INDEX_NONE;
+		for (int32 Search = 0; Search < NumSearches; Search++)
+		{
+			if (SearchHeads[Search] >= SearchQueues[Search].Num()) continue;
+
+			const int32 Group = FindSearchGroup(Search);
+			if (Group == KeptGroup) continue;
+
+			if (KeptGroup != INDEX_NONE)
+			{
+				NumSearchingGroups = 2;
+				break;
+			}
+
+			KeptGroup = Group;
+			NumSearchingGroups = 1;
+		}
+
+		if (NumSearchingGroups <= 1) break;
+	}
+
+	SET_DWORD_STAT(STAT_PowerSplitVisitedNodes, NumVisited);
+
+	// If every search ran out, the biggest piece keeps the network.
+	if (KeptGroup == INDEX_NONE)
+	{
+		int32 KeptSize = -1;
+		for (int32 Search = 0; Search < NumSearches; Search++)
+		{
+			const int32 Group = FindSearchGroup(Search);
+			int32 GroupSize = 0;
+			for (int32 Other = 0; Other < NumSearches; Other++)
+			{
+				if (FindSearchGroup(Other) == Group) GroupSize += SearchQueues[Other].Num();
+			}
+
+			if (GroupSize > KeptSize)
+			{
+				KeptSize = GroupSize;
+				KeptGroup = Group;
+			}
+		}
+	}
+
+	// Moves every piece that split off into a network of its own.
+	for (int32 Group = 0; Group < NumSearches; Group++)
+	{
+		if (FindSearchGroup(Group) != Group || Group == KeptGroup) continue;
+
+		const int32 NewNetwork = AllocateNetwork();
+		for (int32 Search = 0; Search < NumSearches; Search++)
+		{
+			if (FindSearchGroup(Search) != Group) continue;
+
+			for (const int32 Member : SearchQueues[Search])
+			{
+				RemoveFromNetwork(Member);
+				AddToNetwork(Member, NewNetwork);
+				NodesToNotify.Add(Member);
+			}
+		}
+	}
+
+	MarkNetworkDirty(NetworkIndex);
+}
+
+void UPowerNetworkSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (!DirtyNetworks.IsEmpty() || !NodesToNotify.IsEmpty()) SolveNetworks();
+}
+
+void UPowerNetworkSubsystem::SolveNetworks()
+{
+	{
+		SCOPE_CYCLE_COUNTER(STAT_PowerSolve);
+
+		for (const int32 NetworkIndex : DirtyNetworks)
+		{
+			FPowerNetwork& Network = Networks[NetworkIndex];
+			if (!Network.bDirty) continue;
+			Network.bDirty = false;
+
+			const bool bConnected = HasGeneration(Network.Generation);
+			const float Satisfaction = GetSatisfaction(Network.Generation, Network.Consumption);
+			if (bConnected == Network.bConnected && FMath::IsNearlyEqual(Satisfaction, Network.Satisfaction)) continue;
+
+			Network.bConnected = bConnected;
+			Network.Satisfaction = Satisfaction;
+			NodesToNotify.Append(Network.Members);
+		}
+		DirtyNetworks.Reset();
+	}
+
+	// Moved out first, since handlers are free to build or recycle power lines.
+	TArray<int32> Notifying = MoveTemp(NodesToNotify);
+	NodesToNotify.Reset();
+
+	for (const int32 NodeIndex : Notifying)
+	{
+		NotifyNode(NodeIndex);
+	}
+}
+
+void UPowerNetworkSubsystem::NotifyNode(int32 NodeIndex)
+{
+	AActor* Actor = NodeActors[NodeIndex];
+	FPowerNode& Node = Nodes[NodeIndex];
+	if (!IsValid(Actor) || Node.Network == INDEX_NONE) return;
+
+	const FPowerNetwork& Network = Networks[Node.Network];
+	if (Network.bConnected == Node.bNotifiedConnected && FMath::IsNearlyEqual(Network.Satisfaction, Node.NotifiedSatisfaction)) return;
+
+	Node.bNotifiedConnected = Network.bConnected;
+	Node.NotifiedSatisfaction = Network.Satisfaction;
+	IPowerInterface::Execute_OnPowerNetworkChanged(Actor, Network.bConnected, Network.Satisfaction);
+}
+
+bool UPowerNetworkSubsystem::IsConnectedToPowerSource(AActor* Actor) const
+{
+	const int32* NodeIndex = NodeIndices.Find(Actor);
+	return NodeIndex && HasGeneration(Networks[Nodes[*NodeIndex].Network].Generation);
+}
+
+float UPowerNetworkSubsystem::GetPowerSatisfaction(AActor* Actor) const
+{
+	const int32* NodeIndex = NodeIndices.Find(Actor);
+	if (!NodeIndex) return 0.0f;
+
+	const FPowerNetwork& Network = Networks[Nodes[*NodeIndex].Network];
+	return GetSatisfaction(Network.Generation, Network.Consumption);
+}
+
+bool UPowerNetworkSubsystem::AreConnected(AActor* ActorA, AActor* ActorB) const
+{
+	const int32* NodeA = NodeIndices.Find(ActorA);
+	const int32* NodeB = NodeIndices.Find(ActorB);
+	return NodeA && NodeB && Nodes[*NodeA].Network == Nodes[*NodeB].Network;
+}
+
+float UPowerNetworkSubsystem::GetNetworkGeneration(AActor* Actor) const
+{
+	const int32* NodeIndex = NodeIndices.Find(Actor);
+	return NodeIndex ? static_cast<float>(Networks[Nodes[*NodeIndex].Network].Generation) : 0.0f;
+}
+
+float UPowerNetworkSubsystem::GetNetworkConsumption(AActor* Actor) const
+{
+	const int32* NodeIndex = NodeIndices.Find(Actor);
+	return NodeIndex ? static_cast<float>(Networks[Nodes[*NodeIndex].Network].Consumption) : 0.0f;
+}
+
+int32 UPowerNetworkSubsystem::GetNetworkSize(AActor* Actor) const
+{
+	const int32* NodeIndex = NodeIndices.Find(Actor);
+	return NodeIndex ? Networks[Nodes[*NodeIndex].Network].Members.Num() : 0;
+}
+
+void UPowerNetworkSubsystem::GetLinkedNodes(AActor* Actor, TArray<AActor*>& OutActors) const
+{
+	OutActors.Reset();
+
+	const int32* NodeIndex = NodeIndices.Find(Actor);
+	if (!NodeIndex) return;
+
+	for (const int32 Link : Nodes[*NodeIndex].Links)
+	{
+		OutActors.Add(NodeActors[Link]);
+	}
+}
+
+void UPowerNetworkSubsystem::LogNetworks() const
+{
+	UE_LOG(LogStrategyGame, Log, TEXT("%d power nodes in %d networks"), GetNumNodes(), GetNumNetworks());
+
+	for (int32 NetworkIndex = 0; NetworkIndex < Networks.Num(); NetworkIndex++)
+	{
+		const FPowerNetwork& Network = Networks[NetworkIndex];
+		if (Network.Members.IsEmpty()) continue;
+
+		UE_LOG(LogStrategyGame, Log, TEXT("Network %4d  nodes %6d  generation %8.2f  consumption %8.2f  satisfaction %5.1f%%"),
+			NetworkIndex, Network.Members.Num(), Network.Generation, Network.Consumption,
+			100.0f * GetSatisfaction(Network.Generation, Network.Consumption));
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs PowerNetworksCommand(
+	TEXT("StrategyGame.PowerNetworks"),
+	TEXT("Logs the size and balance of every power network."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (const UPowerNetworkSubsystem* PowerNetwork = World ? World->GetSubsystem<UPowerNetworkSubsystem>() : nullptr)
+		{
+			PowerNetwork->LogNetworks();
+		}
+	}));
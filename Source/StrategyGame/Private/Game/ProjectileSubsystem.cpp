@@ -0,0 +1,253 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Game/ProjectileSubsystem.h"
+
+#include "StrategyGame.h"
+#include "Projectile.h"
+#include "Async/ParallelFor.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Enemies/EnemyShip.h"
+#include "Enemies/EnemySwarmSubsystem.h"
+#include "Game/HealthSubsystem.h"
+#include "Rendering/InstancedRenderActor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Projectiles Integrate"), STAT_ProjectilesIntegrate, STATGROUP_StrategyGame);
+DECLARE_CYCLE_STAT(TEXT("Projectiles Sweep"), STAT_ProjectilesSweep, STATGROUP_StrategyGame);
+DECLARE_CYCLE_STAT(TEXT("Projectiles Resolve"), STAT_ProjectilesResolve, STATGROUP_StrategyGame);
+DECLARE_CYCLE_STAT(TEXT("Projectiles Render"), STAT_ProjectilesRender, STATGROUP_StrategyGame);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Projectiles"), STAT_Projectiles, STATGROUP_StrategyGame);
+
+void FProjectileBatch::Add(const FVector& Position, const FVector& Velocity, float Damage, float KnockbackMultiplier, AActor* Shooter)
+{
+	Positions.Add(Position);
+	PreviousPositions.Add(Position);
+	Velocities.Add(Velocity);
+	Damages.Add(Damage);
+	KnockbackMultipliers.Add(KnockbackMultiplier);
+	Lifetimes.Add(LifeSpan);
+	Shooters.Add(Shooter);
+}
+
+void FProjectileBatch::RemoveAtSwap(int32 Index)
+{
+	Positions.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	PreviousPositions.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Velocities.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Damages.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	KnockbackMultipliers.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Lifetimes.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	Shooters.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+}
+
+bool UProjectileSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UProjectileSubsystem::Deinitialize()
+{
+	Batches.Empty();
+	RenderActor = nullptr;
+
+	Super::Deinitialize();
+}
+
+TStatId UProjectileSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UProjectileSubsystem, STATGROUP_Tickables);
+}
+
+FProjectileBatch& UProjectileSubsystem::FindOrAddBatch(TSubclassOf<AProjectile> ProjectileClass)
+{
+	if (FProjectileBatch* Existing = Batches.Find(ProjectileClass)) return *Existing;
+
+	FProjectileBatch& Batch = Batches.Add(ProjectileClass);
+
+	// The class default object describes how the projectile looks, how big it is and how long it lives.
+	const AProjectile* ProjectileDefaults = ProjectileClass.GetDefaultObject();
+	if (ProjectileDefaults->GetMesh())
+	{
+		Batch.MeshTransform = ProjectileDefaults->GetMesh()->GetRelativeTransform();
+
+		if (!RenderActor)
+		{
+			FActorSpawnParameters SpawnParameters;
+			SpawnParameters.ObjectFlags |= RF_Transient;
+			RenderActor = GetWorld()->SpawnActor<AInstancedRenderActor>(SpawnParameters);
+		}
+		if (RenderActor) Batch.InstancedMesh = RenderActor->GetInstancedMesh(ProjectileDefaults->GetMesh()->GetStaticMesh());
+	}
+	if (ProjectileDefaults->GetSphere())
+	{
+		const FVector SphereScale = Batch.MeshTransform.GetScale3D() * ProjectileDefaults->GetSphere()->GetRelativeScale3D();
+		Batch.Radius = ProjectileDefaults->GetSphere()->GetUnscaledSphereRadius() * SphereScale.GetAbsMin();
+	}
+	if (ProjectileDefaults->GetInitialLifeSpan() > 0.0f) Batch.LifeSpan = ProjectileDefaults->GetInitialLifeSpan();
+
+	return Batch;
+}
+
+void UProjectileSubsystem::SpawnProjectile(TSubclassOf<AProjectile> ProjectileClass, const FVector& Location, const FVector& Velocity, float Damage, float KnockbackMultiplier, AActor* Shooter)
+{
+	if (!ProjectileClass) return;
+
+	FindOrAddBatch(ProjectileClass).Add(Location, Velocity, Damage, KnockbackMultiplier, Shooter);
+}
+
+int32 UProjectileSubsystem::GetNumProjectiles() const
+{
+	int32 NumProjectiles = 0;
+	for (const TPair<TSubclassOf<AProjectile>, FProjectileBatch>& Pair : Batches)
+	{
+		NumProjectiles += Pair.Value.Num();
+	}
+	return NumProjectiles;
+}
+
+void UProjectileSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	int32 NumProjectiles = 0;
+	for (TPair<TSubclassOf<AProjectile>, FProjectileBatch>& Pair : Batches)
+	{
+		FProjectileBatch& Batch = Pair.Value;
+		if (Batch.Num() > 0)
+		{
+			IntegrateBatch(Batch, DeltaTime);
+			SweepBatch(Batch);
+			ResolveBatch(Batch);
+		}
+		RenderBatch(Batch);
+
+		NumProjectiles += Batch.Num();
+	}
+
+	SET_DWORD_STAT(STAT_Projectiles, NumProjectiles);
+
+	if (PendingHits.IsEmpty()) return;
+
+	SCOPE_CYCLE_COUNTER(STAT_ProjectilesResolve);
+
+	// Damage is only queued here, the health subsystem applies it along with every other hit this frame.
+	UHealthSubsystem* HealthSubsystem = GetWorld()->GetSubsystem<UHealthSubsystem>();
+
+	for (const FPendingHit& PendingHit : PendingHits)
+	{
+		AActor* HitActor = PendingHit.Hit.GetActor();
+		if (!IsValid(HitActor)) continue;
+
+		if (HealthSubsystem) HealthSubsystem->QueueDamage(HitActor, PendingHit.Damage, PendingHit.Shooter.Get());
+
+		if (UStaticMeshComponent* SMComp = HitActor->GetComponentByClass<UStaticMeshComponent>())
+		{
+			if (SMComp->IsSimulatingPhysics()) SMComp->AddImpulseAtLocation(PendingHit.Velocity * PendingHit.KnockbackMultiplier * PendingHit.Damage, PendingHit.Hit.ImpactPoint);
+		}
+	}
+
+	PendingHits.Reset();
+}
+
+void UProjectileSubsystem::IntegrateBatch(FProjectileBatch& Batch, float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ProjectilesIntegrate);
+
+	const int32 Num = Batch.Num();
+	FVector* RESTRICT Positions = Batch.Positions.GetData();
+	FVector* RESTRICT PreviousPositions = Batch.PreviousPositions.GetData();
+	const FVector* RESTRICT Velocities = Batch.Velocities.GetData();
+	float* RESTRICT Lifetimes = Batch.Lifetimes.GetData();
+
+	for (int32 i = 0; i < Num; i++)
+	{
+		PreviousPositions[i] = Positions[i];
+		Positions[i] += Velocities[i] * DeltaTime;
+		Lifetimes[i] -= DeltaTime;
+	}
+}
+
+void UProjectileSubsystem::SweepBatch(const FProjectileBatch& Batch)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ProjectilesSweep);
+
+	const int32 Num = Batch.Num();
+	SweepHits.SetNum(Num, EAllowShrinking::No);
+	SweepDidHit.SetNumZeroed(Num, EAllowShrinking::No);
+	SwarmHitShips.SetNum(Num, EAllowShrinking::No);
+	SwarmHitTimes.SetNum(Num, EAllowShrinking::No);
+
+	// Resolved on the game thread, the sweeps themselves only read the world.
+	IgnoredActors.SetNum(Num, EAllowShrinking::No);
+	for (int32 i = 0; i < Num; i++)
+	{
+		IgnoredActors[i] = Batch.Shooters[i].Get();
+	}
+
+	const UWorld* World = GetWorld();
+	const FCollisionShape Shape = FCollisionShape::MakeSphere(Batch.Radius);
+
+	UEnemySwarmSubsystem* Swarm = World->GetSubsystem<UEnemySwarmSubsystem>();
+	const bool bTraceSwarm = Swarm && Swarm->GetNumShips() > 0;
+	if (bTraceSwarm) Swarm->UpdateSpatialHash();
+
+	ParallelFor(Num, [&](int32 i)
+	{
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ProjectileSweep), false, IgnoredActors[i]);
+		SweepDidHit[i] = World->SweepSingleByChannel(SweepHits[i], Batch.PreviousPositions[i], Batch.Positions[i], FQuat::Identity, ECC_Visibility, Shape, QueryParams);
+
+		// Swarm ships have no collision until they're actors, so they're traced separately and win if they're closer.
+		SwarmHitShips[i] = INDEX_NONE;
+		if (bTraceSwarm)
+		{
+			const int32 Ship = Swarm->TraceShips(Batch.PreviousPositions[i], Batch.Positions[i], Batch.Radius, SwarmHitTimes[i]);
+			if (Ship != INDEX_NONE && !Swarm->GetShipActor(Ship) && (!SweepDidHit[i] || SwarmHitTimes[i] < SweepHits[i].Time)) SwarmHitShips[i] = Ship;
+		}
+	}, Num < MinParallelSweeps ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+}
+
+void UProjectileSubsystem::ResolveBatch(FProjectileBatch& Batch)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ProjectilesResolve);
+
+	UEnemySwarmSubsystem* Swarm = GetWorld()->GetSubsystem<UEnemySwarmSubsystem>();
+
+	// Backwards, so the projectile swapped into a removed slot has already been handled.
+	for (int32 i = Batch.Num() - 1; i >= 0; i--)
+	{
+		// The ship is promoted so the hit has an actor to damage. Promoting never removes ships, so the other hits stay valid.
+		AEnemyShip* SwarmShip = Swarm && SwarmHitShips[i] != INDEX_NONE ? Swarm->PromoteShip(SwarmHitShips[i]) : nullptr;
+		if (SwarmShip)
+		{
+			const FVector HitLocation = FMath::Lerp(Batch.PreviousPositions[i], Batch.Positions[i], SwarmHitTimes[i]);
+			SweepHits[i] = FHitResult(SwarmShip, nullptr, HitLocation, -Batch.Velocities[i].GetSafeNormal());
+			SweepDidHit[i] = true;
+		}
+
+		const bool bHit = SweepDidHit[i] && SweepHits[i].GetActor();
+		if (bHit)
+		{
+			PendingHits.Add({ Batch.Shooters[i], SweepHits[i], Batch.Velocities[i], Batch.Damages[i], Batch.KnockbackMultipliers[i] });
+		}
+
+		if (bHit || Batch.Lifetimes[i] <= 0.0f) Batch.RemoveAtSwap(i);
+	}
+}
+
+void UProjectileSubsystem::RenderBatch(FProjectileBatch& Batch)
+{
+	if (!Batch.InstancedMesh) return;
+
+	SCOPE_CYCLE_COUNTER(STAT_ProjectilesRender);
+
+	const int32 Num = Batch.Num();
+	InstanceTransforms.SetNum(Num, EAllowShrinking::No);
+	for (int32 i = 0; i < Num; i++)
+	{
+		// Rotation follows velocity, the same as the old projectile movement component.
+		const FTransform ProjectileTransform(FRotationMatrix::MakeFromX(Batch.Velocities[i]).ToQuat(), Batch.Positions[i]);
+		InstanceTransforms[i] = Batch.MeshTransform * ProjectileTransform;
+	}
+
+	AInstancedRenderActor::UpdateInstances(Batch.InstancedMesh, InstanceTransforms);
+}
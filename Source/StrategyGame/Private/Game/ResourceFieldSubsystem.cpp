@@ -0,0 +1,374 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Game/ResourceFieldSubsystem.h"
+
+#include "StrategyGame.h"
+#include "ResourceNode.h"
+#include "Building/Structure.h"
+#include "Curves/CurveFloat.h"
+
+DECLARE_CYCLE_STAT(TEXT("Resource Node Lookup"), STAT_ResourceNodeLookup, STATGROUP_StrategyGame);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Resource Node Lookup Cells"), STAT_ResourceNodeLookupCells, STATGROUP_StrategyGame);
+DECLARE_CYCLE_STAT(TEXT("Resource Extraction"), STAT_ResourceExtraction, STATGROUP_StrategyGame);
+DECLARE_CYCLE_STAT(TEXT("Resource Regeneration"), STAT_ResourceRegeneration, STATGROUP_StrategyGame);
+
+bool UResourceFieldSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UResourceFieldSubsystem::Deinitialize()
+{
+	Nodes.Empty();
+	NodeActors.Empty();
+	NodeIndices.Empty();
+	FreeNodes.Empty();
+	Reserves.Empty();
+	RegenerationCurves.Empty();
+	RegeneratingNodes.Empty();
+	for (TMap<FIntPoint, TArray<int32>>& Cells : TypeCells) Cells.Empty();
+
+	Super::Deinitialize();
+}
+
+FIntPoint UResourceFieldSubsystem::WorldToCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt32(Location.X / CellSize), FMath::FloorToInt32(Location.Y / CellSize));
+}
+
+void UResourceFieldSubsystem::RegisterNode(AResourceNode* Node)
+{
+	if (!Node || NodeIndices.Contains(Node)) return;
+
+	int32 NodeIndex;
+	if (!FreeNodes.IsEmpty())
+	{
+		NodeIndex = FreeNodes.Pop(EAllowShrinking::No);
+		NodeActors[NodeIndex] = Node;
+		RegenerationCurves[NodeIndex] = Node->GetRegenerationCurve();
+	}
+	else
+	{
+		NodeIndex = Nodes.AddDefaulted();
+		NodeActors.Add(Node);
+		Reserves.AddDefaulted();
+		RegenerationCurves.Add(Node->GetRegenerationCurve());
+	}
+	NodeIndices.Add(Node, NodeIndex);
+
+	FFieldNode& FieldNode = Nodes[NodeIndex];
+	FieldNode.Location = Node->GetActorLocation();
+	FieldNode.ExtractionRadius = Node->GetExtractionRadius();
+	FieldNode.ResourceType = Node->GetResourceType();
+	FieldNode.Cell = WorldToCell(FieldNode.Location);
+	FieldNode.bAssigned = Node->GetAssignedExtractor() != nullptr;
+
+	FNodeReserve& Reserve = Reserves[NodeIndex];
+	Reserve.Capacity = ToReserve(Node->GetStartingResourceAmount());
+	Reserve.Amount = Reserve.Capacity;
+	if (RegenerationCurves[NodeIndex]) RegeneratingNodes.Add(NodeIndex);
+
+	const int32 Resource = static_cast<int32>(FieldNode.ResourceType);
+	TypeCells[Resource].FindOrAdd(FieldNode.Cell).Add(NodeIndex);
+	NumNodes[Resource]++;
+	if (!FieldNode.bAssigned) NumUnassignedNodes[Resource]++;
+
+	MaxExtractionRadius = FMath::Max(MaxExtractionRadius, FieldNode.ExtractionRadius);
+}
+
+void UResourceFieldSubsystem::UnregisterNode(AResourceNode* Node)
+{
+	int32 NodeIndex;
+	if (!NodeIndices.RemoveAndCopyValue(Node, NodeIndex)) return;
+
+	const FFieldNode& FieldNode = Nodes[NodeIndex];
+	const int32 Resource = static_cast<int32>(FieldNode.ResourceType);
+
+	TMap<FIntPoint, TArray<int32>>& Cells = TypeCells[Resource];
+	if (TArray<int32>* CellNodes = Cells.Find(FieldNode.Cell))
+	{
+		CellNodes->RemoveSingleSwap(NodeIndex, EAllowShrinking::No);
+		if (CellNodes->IsEmpty()) Cells.Remove(FieldNode.Cell);
+	}
+
+	NumNodes[Resource]--;
+	if (!FieldNode.bAssigned) NumUnassignedNodes[Resource]--;
+
+	if (RegenerationCurves[NodeIndex]) RegeneratingNodes.RemoveSingleSwap(NodeIndex, EAllowShrinking::No);
+
+	NodeActors[NodeIndex] = nullptr;
+	RegenerationCurves[NodeIndex] = nullptr;
+	Reserves[NodeIndex] = FNodeReserve();
+	FreeNodes.Add(NodeIndex);
+}
+
+void UResourceFieldSubsystem::SetNodeAssigned(AResourceNode* Node, bool bAssigned)
+{
+	const int32* NodeIndex = NodeIndices.Find(Node);
+	if (!NodeIndex) return;
+
+	FFieldNode& FieldNode = Nodes[*NodeIndex];
+	if (FieldNode.bAssigned == bAssigned) return;
+
+	FieldNode.bAssigned = bAssigned;
+	NumUnassignedNodes[static_cast<int32>(FieldNode.ResourceType)] += bAssigned ? -1 : 1;
+}
+
+int32 UResourceFieldSubsystem::FindNearestNodeOfType(EResourceType ResourceType, const FVector& Location, float Radius, bool bUnassignedOnly, float& OutDistanceSquared) const
+{
+	const TMap<FIntPoint, TArray<int32>>& Cells = TypeCells[static_cast<int32>(ResourceType)];
+
+	const FIntPoint Centre = WorldToCell(Location);
+	const int32 MaxRing = FMath::CeilToInt32((Radius + MaxExtractionRadius) / CellSize);
+
+	int32 BestNode = INDEX_NONE;
+	int32 CellsChecked = 0;
+
+	auto CheckCell = [&](const FIntPoint& Cell)
+	{
+		CellsChecked++;
+		const TArray<int32>* CellNodes = Cells.Find(Cell);
+		if (!CellNodes) return;
+
+		for (const int32 NodeIndex : *CellNodes)
+		{
+			const FFieldNode& FieldNode = Nodes[NodeIndex];
+			if (bUnassignedOnly && FieldNode.bAssigned) continue;
+
+			const float DistanceSquared = FVector::DistSquared2D(Location, FieldNode.Location);
+			if (DistanceSquared >= OutDistanceSquared || DistanceSquared > FMath::Square(Radius + FieldNode.ExtractionRadius)) continue;
+
+			OutDistanceSquared = DistanceSquared;
+			BestNode = NodeIndex;
+		}
+	};
+
+	for (int32 Ring = 0; Ring <= MaxRing; Ring++)
+	{
+		// Every cell past this ring is at least Ring cells away, so a node found closer than that can't be beaten.
+		if (OutDistanceSquared <= FMath::Square((Ring - 1) * CellSize)) break;
+
+		if (Ring == 0)
+		{
+			CheckCell(Centre);
+			continue;
+		}
+
+		for (int32 X = -Ring; X <= Ring; X++)
+		{
+			CheckCell(Centre + FIntPoint(X, -Ring));
+			CheckCell(Centre + FIntPoint(X, Ring));
+		}
+		for (int32 Y = -Ring + 1; Y < Ring; Y++)
+		{
+			CheckCell(Centre + FIntPoint(-Ring, Y));
+			CheckCell(Centre + FIntPoint(Ring, Y));
+		}
+	}
+
+	INC_DWORD_STAT_BY(STAT_ResourceNodeLookupCells, CellsChecked);
+	return BestNode;
+}
+
+AResourceNode* UResourceFieldSubsystem::FindNearestNode(uint32 ResourceTypeMask, const FVector& Location, float Radius, bool bUnassignedOnly) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_ResourceNodeLookup);
+
+	float BestDistanceSquared = TNumericLimits<float>::Max();
+	int32 BestNode = INDEX_NONE;
+
+	for (EResourceType ResourceType : TEnumRange<EResourceType>())
+	{
+		const int32 Resource = static_cast<int32>(ResourceType);
+		if (!(ResourceTypeMask & (1u << static_cast<uint32>(Resource)))) continue;
+		if ((bUnassignedOnly ? NumUnassignedNodes[Resource] : NumNodes[Resource]) <= 0) continue;
+
+		const int32 NodeIndex = FindNearestNodeOfType(ResourceType, Location, Radius, bUnassignedOnly, BestDistanceSquared);
+		if (NodeIndex != INDEX_NONE) BestNode = NodeIndex;
+	}
+
+	return BestNode != INDEX_NONE ? NodeActors[BestNode] : nullptr;
+}
+
+AResourceNode* UResourceFieldSubsystem::FindNearestUnassignedNode(EResourceType ResourceType, FVector Location, float Radius) const
+{
+	return FindNearestNode(1u << static_cast<uint32>(ResourceType), Location, Radius);
+}
+
+float UResourceFieldSubsystem::GetReserve(AResourceNode* Node) const
+{
+	const int32* NodeIndex = NodeIndices.Find(Node);
+	return NodeIndex ? FromReserve(Reserves[*NodeIndex].Amount) : 0.0f;
+}
+
+int64 UResourceFieldSubsystem::DrainReserve(int32 NodeIndex, int64 Amount)
+{
+	FNodeReserve& Reserve = Reserves[NodeIndex];
+	const int64 AmountDrained = FMath::Clamp<int64>(Amount, 0, Reserve.Amount);
+	Reserve.Amount -= AmountDrained;
+
+	if (Reserve.Amount <= 0 && !RegenerationCurves[NodeIndex])
+	{
+		// Taken out of the index straight away, so extractors looking for a new node this step don't find it.
+		AResourceNode* Node = NodeActors[NodeIndex];
+		UnregisterNode(Node);
+		Node->Destroy();
+	}
+
+	return AmountDrained;
+}
+
+float UResourceFieldSubsystem::DrainNode(AResourceNode* Node, float Amount)
+{
+	const int32* NodeIndex = NodeIndices.Find(Node);
+	if (!NodeIndex) return 0.0f;
+
+	return FromReserve(DrainReserve(*NodeIndex, ToReserve(Amount)));
+}
+
+bool UResourceFieldSubsystem::BindExtractorStep(FExtractorStep& Step, float StepSeconds) const
+{
+	AResourceNode* Node = Step.Extractor->GetTargetResourceNode();
+	const int32* NodeIndex = IsValid(Node) ? NodeIndices.Find(Node) : nullptr;
+	if (!NodeIndex)
+	{
+		Step.NodeIndex = INDEX_NONE;
+		return false;
+	}
+
+	const EResourceType ResourceType = Nodes[*NodeIndex].ResourceType;
+	Step.NodeIndex = *NodeIndex;
+	Step.Resource = static_cast<int32>(ResourceType);
+	Step.DrainRate = Step.Extractor->GetStructureDescriptor().GetConsumptionRate(ResourceType);
+	Step.DrainPerStep = ToReserve(Step.DrainRate * Step.Extractor->GetWorkerEfficiency() * StepSeconds);
+	return true;
+}
+
+uint32 UResourceFieldSubsystem::GatherExtractors(const TArray<AStructure*>& Extractors, float StepSeconds, TArray<FExtractorStep>& OutSteps) const
+{
+	OutSteps.Reset();
+
+	uint32 ResourceMask = 0;
+	for (AStructure* Extractor : Extractors)
+	{
+		FExtractorStep& Step = OutSteps.AddDefaulted_GetRef();
+		Step.Extractor = Extractor;
+
+		if (BindExtractorStep(Step, StepSeconds)) ResourceMask |= 1u << static_cast<uint32>(Step.Resource);
+		else ResourceMask |= Extractor->GetStructureDescriptor().ConsumedResourceMask;
+	}
+
+	return ResourceMask;
+}
+
+bool UResourceFieldSubsystem::ExtractStep(TArray<FExtractorStep>& Steps, float* Amounts, const float* Capacities, float StepSeconds)
+{
+	int64 Extracted[NumResourceTypes] = {};
+	bool bActive = false;
+	StorageFullMask = 0;
+
+	for (FExtractorStep& Step : Steps)
+	{
+		// Extractors only start on a new node the step after finding it.
+		if (Step.NodeIndex == INDEX_NONE)
+		{
+			if (Step.bNoNodeInRange) continue;
+
+			Step.bNoNodeInRange = !Step.Extractor->AcquireResourceNode() || !BindExtractorStep(Step, StepSeconds);
+			bActive |= !Step.bNoNodeInRange;
+			continue;
+		}
+
+		// Only extracts when storage has room for a full step, counting what's already been extracted this step.
+		const float StoredAmount = Amounts[Step.Resource] + FromReserve(Extracted[Step.Resource]);
+		if (FMath::FloorToFloat(Capacities[Step.Resource]) < StoredAmount + Step.DrainRate)
+		{
+			StorageFullMask |= 1u << Step.Resource;
+			continue;
+		}
+
+		// A regenerating node can have something to give next step even if it's empty now.
+		bActive |= RegenerationCurves[Step.NodeIndex] != nullptr;
+
+		const int64 AmountDrained = DrainReserve(Step.NodeIndex, Step.DrainPerStep);
+		Extracted[Step.Resource] += AmountDrained;
+		bActive |= AmountDrained > 0;
+
+		// Emptied and destroyed, the extractor looks for another node next step.
+		if (!NodeActors[Step.NodeIndex]) Step.NodeIndex = INDEX_NONE;
+	}
+
+	for (int32 Resource = 0; Resource < NumResourceTypes; Resource++)
+	{
+		// Credited the same way AStrategyGameState::AddResources would.
+		if (Extracted[Resource] > 0 && Amounts[Resource] < Capacities[Resource])
+		{
+			Amounts[Resource] = FMath::Clamp(Amounts[Resource] + FromReserve(Extracted[Resource]), 0.0f, Capacities[Resource]);
+		}
+	}
+
+	return bActive;
+}
+
+void UResourceFieldSubsystem::StepExtraction(const TArray<AStructure*>& Extractors, AStrategyGameState* StrategyGameState, float StepSeconds)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ResourceExtraction);
+
+	float StartingAmounts[NumResourceTypes];
+	float Amounts[NumResourceTypes];
+	float Capacities[NumResourceTypes];
+	for (EResourceType ResourceType : TEnumRange<EResourceType>())
+	{
+		const int32 Resource = static_cast<int32>(ResourceType);
+		StartingAmounts[Resource] = Amounts[Resource] = StrategyGameState->GetResourceAmount(ResourceType);
+		Capacities[Resource] = StrategyGameState->GetResourceLedger().GetCapacity(ResourceType);
+	}
+
+	const uint32 PreviousStorageFullMask = StorageFullMask;
+
+	GatherExtractors(Extractors, StepSeconds, ExtractorSteps);
+	ExtractStep(ExtractorSteps, Amounts, Capacities, StepSeconds);
+
+	// Reported once when storage fills up, not for every extractor on every step it stays full.
+	if (const uint32 NewlyFullMask = StorageFullMask & ~PreviousStorageFullMask)
+	{
+		for (EResourceType ResourceType : TEnumRange<EResourceType>())
+		{
+			UE_CLOG(NewlyFullMask & (1u << static_cast<uint32>(ResourceType)), LogStrategyGame, Log, TEXT("%s storage is full, extractors have stopped."),
+				*UEnum::GetDisplayValueAsText(ResourceType).ToString());
+		}
+	}
+
+	for (EResourceType ResourceType : TEnumRange<EResourceType>())
+	{
+		const int32 Resource = static_cast<int32>(ResourceType);
+		if (Amounts[Resource] != StartingAmounts[Resource]) StrategyGameState->SetResourceAmount(ResourceType, Amounts[Resource]);
+	}
+
+	AdvanceRegeneration(StepSeconds);
+}
+
+void UResourceFieldSubsystem::AdvanceRegeneration(float Seconds, int32 NumSubsteps)
+{
+	SCOPE_CYCLE_COUNTER(STAT_ResourceRegeneration);
+
+	if (Seconds <= 0.0f || RegeneratingNodes.IsEmpty()) return;
+
+	NumSubsteps = FMath::Max(NumSubsteps, 1);
+	const float SubstepSeconds = Seconds / NumSubsteps;
+
+	for (const int32 NodeIndex : RegeneratingNodes)
+	{
+		FNodeReserve& Reserve = Reserves[NodeIndex];
+		if (Reserve.Capacity <= 0) continue;
+
+		const UCurveFloat* Curve = RegenerationCurves[NodeIndex];
+		for (int32 Substep = 0; Substep < NumSubsteps && Reserve.Amount < Reserve.Capacity; Substep++)
+		{
+			const float Fullness = static_cast<float>(static_cast<double>(Reserve.Amount) / Reserve.Capacity);
+			const int64 Regenerated = ToReserve(Curve->GetFloatValue(Fullness) * SubstepSeconds);
+			Reserve.Amount = FMath::Min(Reserve.Amount + Regenerated, Reserve.Capacity);
+		}
+	}
+}
@@ -3,8 +3,16 @@
 
 #include "Game/StrategyGameState.h"
 
+#include "StrategyGame.h"
+#include "EngineUtils.h"
 #include "Building/Structure.h"
-#include "Kismet/GameplayStatics.h"
+#include "Debug/TickCensus.h"
+#include "Game/EconomySubsystem.h"
+
+static TAutoConsoleVariable<bool> CVarVerifyEmployment(
+	TEXT("StrategyGame.Population.VerifyEmployment"),
+	false,
+	TEXT("Recounts every structure's workers after each employment change and reports if the running totals have drifted."));
 
 
 AStrategyGameState::AStrategyGameState()
@@ -29,79 +37,96 @@ AStrategyGameState::AStrategyGameState()
 
 	Population.Add(ECitizenType::Worker, 100);
 	Population.Add(ECitizenType::Scientist, 20);
-
-	StructureBuiltDelegate.AddUniqueDynamic(this, &ThisClass::OnStructureBuilt);
-	StructureDestroyedDelegate.AddUniqueDynamic(this, &ThisClass::OnStructureDestroyed);
 }
 
-void AStrategyGameState::BeginPlay()
+void AStrategyGameState::PostInitializeComponents()
 {
-	Super::BeginPlay();
-
-	ClampResources();
+	Super::PostInitializeComponents();
 
-	BuiltStructures = FindAllStructures();
+	// Loaded here rather than in BeginPlay so other actors can read resources during their own BeginPlay.
+	ResourceLedger.Initialize(ResourceInventory, MaximumResources);
+	DirtyResourceMask = (1 << NumResourceTypes) - 1;
+	bPopulationDirty = true;
 }
 
-void AStrategyGameState::OnStructureBuilt(AStructure* BuiltStructure)
+void AStrategyGameState::BeginPlay()
 {
-	BuiltStructures.AddUnique(BuiltStructure);
+	Super::BeginPlay();
 }
 
-void AStrategyGameState::OnStructureDestroyed(AStructure* BuiltStructure)
+void AStrategyGameState::ClampResources()
 {
-	BuiltStructures.Remove(BuiltStructure);
-	BuiltStructures.Shrink();
+	ResourceLedger.ClampAll();
 }
 
-void AStrategyGameState::ClampResources()
+void AStrategyGameState::UpdateTimeOfDay(float DeltaSeconds)
 {
-	for (auto Resource : ResourceInventory)
+	TimeOfDay += DeltaSeconds / GetStrategyGameMode()->GetSecondsInGameHours();
+
+	if (TimeOfDay >= 24.0f)
 	{
-		EResourceType ResourceType = Resource.Key;
-		float Amount = Resource.Value;
-		
-		if (Amount > GetResourceCapacity(ResourceType))
-		{
-			ResourceInventory.Add(ResourceType, GetResourceCapacity(ResourceType));
-		}
-		else if (Amount < 0)
-		{
-			ResourceInventory.Add(ResourceType, 0);
-		}
+		TimeOfDay -= 24.0f;
+		DaysCitySurvived++;
 	}
 }
 
-TArray<AStructure*> AStrategyGameState::FindAllStructures()
+void AStrategyGameState::SkipHours(float Hours)
 {
-	TArray<AActor*> FoundStructures;
-	UGameplayStatics::GetAllActorsOfClass(GetWorld(), AStructure::StaticClass(), FoundStructures);
+	if (Hours <= 0.0f) return;
 
-	TArray<AStructure*> OutArray;
-	for (AActor* FoundStructure : FoundStructures)
+	if (UEconomySubsystem* Economy = GetWorld()->GetSubsystem<UEconomySubsystem>())
 	{
-		OutArray.AddUnique(Cast<AStructure>(FoundStructure));
+		Economy->FastForward(Hours * GetStrategyGameMode()->GetSecondsInGameHours());
 	}
 
-	return OutArray;
+	TimeOfDay += Hours;
+	const int32 DaysPassed = FMath::FloorToInt32(TimeOfDay / 24.0f);
+	TimeOfDay -= DaysPassed * 24.0f;
+	DaysCitySurvived += DaysPassed;
+
+	FlushNotifications();
 }
 
-void AStrategyGameState::UpdateTimeOfDay(float DeltaSeconds)
+void AStrategyGameState::SkipToHour(float Hour)
 {
-	TimeOfDay += DeltaSeconds / GetStrategyGameMode()->GetSecondsInGameHours();
+	float HoursToSkip = FMath::Fmod(Hour, 24.0f) - TimeOfDay;
+	if (HoursToSkip <= 0.0f) HoursToSkip += 24.0f;
 
-	if (TimeOfDay >= 24.0f)
-	{
-		TimeOfDay -= 24.0f;
-		DaysCitySurvived++;
-	}
+	SkipHours(HoursToSkip);
 }
 
 void AStrategyGameState::Tick(float DeltaSeconds)
 {
+	FTickCensusScope CensusScope(this);
 	Super::Tick(DeltaSeconds);
 
-	UpdateTimeOfDay(DeltaSeconds);
+	UpdateTimeOfDay(DeltaSeconds * SimulationSpeed);
+
+	TimeSinceNotificationFlush += DeltaSeconds;
+	if (TimeSinceNotificationFlush >= NotificationFlushInterval)
+	{
+		FlushNotifications();
+	}
+}
+
+void AStrategyGameState::FlushNotifications()
+{
+	TimeSinceNotificationFlush = 0.0f;
+
+	// Cleared before broadcasting so listeners that change resources are picked up by the next flush.
+	const int32 ChangedResourceMask = DirtyResourceMask;
+	const bool bPopulationChanged = bPopulationDirty;
+	DirtyResourceMask = 0;
+	bPopulationDirty = false;
+
+	if (ChangedResourceMask != 0) OnResourcesChanged.Broadcast(ChangedResourceMask);
+	if (bPopulationChanged) OnPopulationChanged.Broadcast();
+
+	if (bAssignedWorkersDirty)
+	{
+		bAssignedWorkersDirty = false;
+		OnAssignedWorkersChanged.Broadcast();
+	}
 }
 
 AStrategyGameModeBase* AStrategyGameState::GetStrategyGameMode()
@@ -116,44 +141,34 @@ AStrategyGameModeBase* AStrategyGameState::GetStrategyGameMode()
 
 ETimeScale AStrategyGameState::SetTimeScale(ETimeScale NewTimeScale)
 {
-	switch (NewTimeScale)
-	{
-	case ETimeScale::OneTimesSpeed:
-		UGameplayStatics::SetGlobalTimeDilation(GetWorld(), 1.0f);
-		break;
-	case ETimeScale::TwoTimesSpeed:
-		UGameplayStatics::SetGlobalTimeDilation(GetWorld(), 2.0f);
-		break;
-	case ETimeScale::ThreeTimesSpeed:
-		UGameplayStatics::SetGlobalTimeDilation(GetWorld(), 3.0f);
-		break;
-	}
+	// The simulation is sped up on its own rather than through global time dilation, so physics, projectiles and the player stay at 1x.
+	TimeScale = NewTimeScale;
+	SimulationSpeed = GetTimeScaleMultiplier(NewTimeScale);
 	
 	OnTimeScaleChanged.Broadcast(NewTimeScale);
 	
-	return TimeScale = NewTimeScale;
+	return TimeScale;
 }
 
-int32 AStrategyGameState::GetEmployedPopulation(ECitizenType WorkerType)
+float AStrategyGameState::GetTimeScaleMultiplier(ETimeScale InTimeScale)
 {
-	int32 EmployedWorkers = 0;
-	for (auto Structure : BuiltStructures)
+	switch (InTimeScale)
 	{
-		EmployedWorkers += Structure->GetWorkerCount(WorkerType);
-	}
-
-	return EmployedWorkers;
-}
-
-int32 AStrategyGameState::GetTotalEmployedPopulation()
-{
-	int32 EmployedWorkers = 0;
-	for (auto Structure : BuiltStructures)
-	{
-		EmployedWorkers += Structure->GetTotalWorkers();
+	case ETimeScale::OneTimesSpeed:
+		return 1.0f;
+	case ETimeScale::TwoTimesSpeed:
+		return 2.0f;
+	case ETimeScale::ThreeTimesSpeed:
+		return 3.0f;
+	case ETimeScale::TenTimesSpeed:
+		return 10.0f;
+	case ETimeScale::TwentyFiveTimesSpeed:
+		return 25.0f;
+	case ETimeScale::FiftyTimesSpeed:
+		return 50.0f;
+	default:
+		return 1.0f;
 	}
-
-	return EmployedWorkers;
 }
 
 int32 AStrategyGameState::GetHomelessPopulation()
@@ -166,7 +181,7 @@ int32 AStrategyGameState::GetHomelessPopulation()
 float AStrategyGameState::AddResources(EResourceType ResourceType, float Amount)
 {
 	// Prints a debug message and returns if the resource storage is full.
-	if (GetResourceAmount(ResourceType) == GetResourceCapacity(ResourceType))
+	if (ResourceLedger.IsFull(ResourceType))
 	{
 		switch (ResourceType)
 		{
@@ -191,15 +206,17 @@ float AStrategyGameState::AddResources(EResourceType ResourceType, float Amount)
 		case EResourceType::ResearchPoints:
 			GEngine->AddOnScreenDebugMessage(904, 3.0f, FColor::Red, "RESEARCH POINTS capacity is full.");
 			break;
+		default:
+			break;
 		}
 		return GetResourceAmount(ResourceType);
 	}
 	
-	ResourceInventory.Add(ResourceType, GetResourceAmount(ResourceType) + Amount);
+	ResourceLedger.SetAmount(ResourceType, GetResourceAmount(ResourceType) + Amount);
 
 	ClampResources();
 
-	OnResourcesChanged.Broadcast();
+	MarkResourceDirty(ResourceType);
 	return GetResourceAmount(ResourceType);
 }
 
@@ -231,31 +248,59 @@ float AStrategyGameState::ConsumeResources(EResourceType ResourceType, float Amo
 		case EResourceType::ResearchPoints:
 			GEngine->AddOnScreenDebugMessage(909, 3.0f, FColor::Red, "Attempted to remove more RESEARCH POINTS than was available.");
 			break;
+		default:
+			break;
 		}
 		return GetResourceAmount(ResourceType);
 	}
 	
-	ResourceInventory.Add(ResourceType, GetResourceAmount(ResourceType) - Amount);
+	ResourceLedger.SetAmount(ResourceType, GetResourceAmount(ResourceType) - Amount);
 
 	ClampResources();
 
-	OnResourcesChanged.Broadcast();
+	MarkResourceDirty(ResourceType);
 	return GetResourceAmount(ResourceType);
 }
 
+float AStrategyGameState::SetResourceAmount(EResourceType ResourceType, float NewAmount)
+{
+	ResourceLedger.SetAmount(ResourceType, FMath::Clamp(NewAmount, 0.0f, ResourceLedger.GetCapacity(ResourceType)));
+
+	MarkResourceDirty(ResourceType);
+	return GetResourceAmount(ResourceType);
+}
+
+bool AStrategyGameState::BP_CanAfford(const TMap<EResourceType, int32>& Cost, int32 Count)
+{
+	FResourceTransaction Transaction;
+	Transaction.AddCosts(Cost, Count);
+	return CanAfford(Transaction);
+}
+
+bool AStrategyGameState::CommitResourceTransaction(const FResourceTransaction& Transaction)
+{
+	if (Transaction.IsEmpty()) return true;
+	if (!CanAfford(Transaction)) return false;
+
+	ResourceLedger.Apply(Transaction);
+
+	DirtyResourceMask |= Transaction.ResourceMask;
+	return true;
+}
+
 int32 AStrategyGameState::IncreaseResourceStorage(EResourceType ResourceType, int32 IncreaseAmount)
 {
-	MaximumResources.Add(ResourceType, GetResourceCapacity(ResourceType) + IncreaseAmount);
+	ResourceLedger.SetCapacity(ResourceType, GetResourceCapacity(ResourceType) + IncreaseAmount);
 	ClampResources();
-	OnResourcesChanged.Broadcast();
+	MarkResourceDirty(ResourceType);
 	return GetResourceCapacity(ResourceType);
 }
 
 int32 AStrategyGameState::DecreaseResourceStorage(EResourceType ResourceType, int32 DecreaseAmount)
 {
-	MaximumResources.Add(ResourceType, FMath::Clamp(GetResourceCapacity(ResourceType) - DecreaseAmount, 0, GetResourceCapacity(ResourceType)));
+	ResourceLedger.SetCapacity(ResourceType, FMath::Clamp(GetResourceCapacity(ResourceType) - DecreaseAmount, 0, GetResourceCapacity(ResourceType)));
 	ClampResources();
-	OnResourcesChanged.Broadcast();
+	MarkResourceDirty(ResourceType);
 	return GetResourceCapacity(ResourceType);
 }
 
@@ -263,7 +308,7 @@ int32 AStrategyGameState::IncreasePopulation(ECitizenType WorkerType, int32 Incr
 {
 	Population.Add(WorkerType, GetPopulation(WorkerType) + IncreaseAmount);
 
-	OnPopulationChanged.Broadcast();
+	MarkPopulationDirty();
 	return GetPopulation(WorkerType);
 }
 
@@ -271,21 +316,59 @@ int32 AStrategyGameState::DecreasePopulation(ECitizenType WorkerType, int32 Decr
 {
 	Population.Add(WorkerType, GetPopulation(WorkerType) - DecreaseAmount);
 
-	OnPopulationChanged.Broadcast();
+	MarkPopulationDirty();
 	return GetPopulation(WorkerType);
 }
 
 int32 AStrategyGameState::IncreasePopulationCapacity(int32 IncreaseAmount)
 {
 	PopulationCapacity += IncreaseAmount;
-	OnPopulationChanged.Broadcast();
+	MarkPopulationDirty();
 	return PopulationCapacity;
 }
 
 int32 AStrategyGameState::DecreasePopulationCapacity(int32 DecreaseAmount)
 {
 	PopulationCapacity = FMath::Clamp(PopulationCapacity - DecreaseAmount, 0, PopulationCapacity);
-	OnPopulationChanged.Broadcast();
+	MarkPopulationDirty();
 	return PopulationCapacity;
 	
 }
+
+void AStrategyGameState::ChangeEmployedPopulation(ECitizenType WorkerType, int32 Delta)
+{
+	if (Delta == 0) return;
+
+	EmployedPopulation[static_cast<int32>(WorkerType)] += Delta;
+	bAssignedWorkersDirty = true;
+
+	if (CVarVerifyEmployment.GetValueOnGameThread())
+	{
+		VerifyEmployedPopulation();
+	}
+}
+
+bool AStrategyGameState::VerifyEmployedPopulation()
+{
+	int32 RecountedPopulation[NumCitizenTypes] = {};
+	for (TActorIterator<AStructure> It(GetWorld()); It; ++It)
+	{
+		for (ECitizenType WorkerType : TEnumRange<ECitizenType>())
+		{
+			RecountedPopulation[static_cast<int32>(WorkerType)] += It->GetWorkerCount(WorkerType);
+		}
+	}
+
+	bool bCountersMatch = true;
+	for (ECitizenType WorkerType : TEnumRange<ECitizenType>())
+	{
+		const int32 Index = static_cast<int32>(WorkerType);
+		if (!ensureMsgf(RecountedPopulation[Index] == EmployedPopulation[Index], TEXT("AStrategyGameState employed %s counter is %d but a recount found %d."),
+			*UEnum::GetValueAsString(WorkerType), EmployedPopulation[Index], RecountedPopulation[Index]))
+		{
+			bCountersMatch = false;
+		}
+	}
+
+	return bCountersMatch;
+}
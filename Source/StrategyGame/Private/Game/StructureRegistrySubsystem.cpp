@@ -0,0 +1,172 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Game/StructureRegistrySubsystem.h"
+
+#include "EngineUtils.h"
+#include "Building/Structure.h"
+
+bool UStructureRegistrySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UStructureRegistrySubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	CapabilityBuckets.SetNum(NumStructureCapabilities);
+}
+
+void UStructureRegistrySubsystem::Deinitialize()
+{
+	Slots.Empty();
+	FreeSlots.Empty();
+	AllStructures = FStructureBucket();
+	ClassBuckets.Empty();
+	CapabilityBuckets.Empty();
+
+	Super::Deinitialize();
+}
+
+void UStructureRegistrySubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	for (TActorIterator<AStructure> It(&InWorld); It; ++It)
+	{
+		if (It->IsConstructionComplete()) RegisterStructure(*It);
+	}
+}
+
+int32 UStructureRegistrySubsystem::AddToBucket(FStructureBucket& Bucket, AStructure* Structure, int32 Slot)
+{
+	Bucket.Slots.Add(Slot);
+	return Bucket.Structures.Add(Structure);
+}
+
+int32 UStructureRegistrySubsystem::RemoveFromBucket(FStructureBucket& Bucket, int32 Position)
+{
+	const bool bMovesLastEntry = Position != Bucket.Structures.Num() - 1;
+
+	Bucket.Structures.RemoveAtSwap(Position, 1, EAllowShrinking::No);
+	Bucket.Slots.RemoveAtSwap(Position, 1, EAllowShrinking::No);
+
+	return bMovesLastEntry ? Bucket.Slots[Position] : INDEX_NONE;
+}
+
+bool UStructureRegistrySubsystem::HasCapability(AStructure* Structure, EStructureCapability Capability)
+{
+	switch (Capability)
+	{
+	case EStructureCapability::Generator:
+		return Structure->GetGeneratesResources();
+	case EStructureCapability::Consumer:
+		return Structure->GetConsumesResources() && !Structure->GetConsumesResourcesFromNearbyNode();
+	case EStructureCapability::Extractor:
+		return Structure->GetConsumesResourcesFromNearbyNode();
+	case EStructureCapability::Storage:
+		return Structure->GetIncreasesStorageCapacity();
+	case EStructureCapability::Housing:
+		return Structure->DoesIncreasePopulationCapacity();
+	default:
+		return false;
+	}
+}
+
+FStructureHandle UStructureRegistrySubsystem::RegisterStructure(AStructure* Structure)
+{
+	if (!Structure) return FStructureHandle();
+	if (IsRegistered(Structure)) return Structure->StructureHandle;
+
+	int32 Slot;
+	if (FreeSlots.Num() > 0)
+	{
+		Slot = FreeSlots.Pop(EAllowShrinking::No);
+	}
+	else
+	{
+		Slot = Slots.AddDefaulted();
+	}
+
+	FSlot& Entry = Slots[Slot];
+	Entry.Structure = Structure;
+	Entry.Class = Structure->GetClass();
+	Entry.AllPosition = AddToBucket(AllStructures, Structure, Slot);
+	Entry.ClassPosition = AddToBucket(ClassBuckets.FindOrAdd(Entry.Class), Structure, Slot);
+
+	for (EStructureCapability Capability : TEnumRange<EStructureCapability>())
+	{
+		const int32 CapabilityIndex = static_cast<int32>(Capability);
+		Entry.CapabilityPositions[CapabilityIndex] = HasCapability(Structure, Capability) ? AddToBucket(CapabilityBuckets[CapabilityIndex], Structure, Slot) : INDEX_NONE;
+	}
+
+	Structure->StructureHandle.Index = Slot;
+	Structure->StructureHandle.Generation = Entry.Generation;
+
+	return Structure->StructureHandle;
+}
+
+void UStructureRegistrySubsystem::UnregisterStructure(AStructure* Structure)
+{
+	if (!IsRegistered(Structure)) return;
+
+	const int32 Slot = Structure->StructureHandle.Index;
+	FSlot& Entry = Slots[Slot];
+
+	if (const int32 MovedSlot = RemoveFromBucket(AllStructures, Entry.AllPosition); MovedSlot != INDEX_NONE)
+	{
+		Slots[MovedSlot].AllPosition = Entry.AllPosition;
+	}
+
+	if (const int32 MovedSlot = RemoveFromBucket(ClassBuckets.FindChecked(Entry.Class), Entry.ClassPosition); MovedSlot != INDEX_NONE)
+	{
+		Slots[MovedSlot].ClassPosition = Entry.ClassPosition;
+	}
+
+	for (int32 CapabilityIndex = 0; CapabilityIndex < NumStructureCapabilities; CapabilityIndex++)
+	{
+		const int32 Position = Entry.CapabilityPositions[CapabilityIndex];
+		if (Position == INDEX_NONE) continue;
+
+		if (const int32 MovedSlot = RemoveFromBucket(CapabilityBuckets[CapabilityIndex], Position); MovedSlot != INDEX_NONE)
+		{
+			Slots[MovedSlot].CapabilityPositions[CapabilityIndex] = Position;
+		}
+	}
+
+	Entry.Structure = nullptr;
+	Entry.Class = nullptr;
+	Entry.Generation++;
+	FreeSlots.Add(Slot);
+
+	Structure->StructureHandle.Invalidate();
+}
+
+AStructure* UStructureRegistrySubsystem::ResolveHandle(FStructureHandle Handle) const
+{
+	if (!Slots.IsValidIndex(Handle.Index)) return nullptr;
+
+	const FSlot& Entry = Slots[Handle.Index];
+	return Entry.Generation == Handle.Generation ? Entry.Structure : nullptr;
+}
+
+bool UStructureRegistrySubsystem::IsRegistered(AStructure* Structure) const
+{
+	return Structure && Structure->StructureHandle.IsValid() && ResolveHandle(Structure->StructureHandle) == Structure;
+}
+
+const TArray<AStructure*>& UStructureRegistrySubsystem::GetStructuresOfClass(TSubclassOf<AStructure> StructureClass) const
+{
+	static const TArray<AStructure*> Empty;
+
+	const FStructureBucket* Bucket = ClassBuckets.Find(StructureClass.Get());
+	return Bucket ? Bucket->Structures : Empty;
+}
+
+const TArray<AStructure*>& UStructureRegistrySubsystem::GetStructuresWithCapability(EStructureCapability Capability) const
+{
+	static const TArray<AStructure*> Empty;
+
+	return CapabilityBuckets.IsValidIndex(static_cast<int32>(Capability)) ? CapabilityBuckets[static_cast<int32>(Capability)].Structures : Empty;
+}
@@ -0,0 +1,128 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Game/TickPolicySubsystem.h"
+
+#include "StrategyGame.h"
+#include "CustomActor.h"
+
+DECLARE_CYCLE_STAT(TEXT("Tick Significance Update"), STAT_TickSignificanceUpdate, STATGROUP_StrategyGame);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Tick Significance Actors"), STAT_TickSignificanceActors, STATGROUP_StrategyGame);
+
+bool UTickPolicySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UTickPolicySubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	SignificanceUpdateAccumulator += DeltaTime;
+	if (SignificanceUpdateAccumulator < SignificanceUpdateInterval) return;
+	SignificanceUpdateAccumulator = 0.0f;
+
+	UpdateSignificance();
+}
+
+TStatId UTickPolicySubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTickPolicySubsystem, STATGROUP_Tickables);
+}
+
+void UTickPolicySubsystem::Deinitialize()
+{
+	SignificanceActors.Empty();
+	SignificanceBuckets.Empty();
+
+	Super::Deinitialize();
+}
+
+void UTickPolicySubsystem::RegisterActor(ACustomActor* Actor)
+{
+	if (!Actor || !Actor->PrimaryActorTick.bCanEverTick) return;
+
+	const FGameplayTickPolicy& TickPolicy = Actor->GetTickPolicy();
+	switch (TickPolicy.Policy)
+	{
+	case EGameplayTickPolicy::EveryFrame:
+		break;
+	case EGameplayTickPolicy::Never:
+	case EGameplayTickPolicy::OnDemand:
+		Actor->SetActorTickEnabled(false);
+		break;
+	case EGameplayTickPolicy::Interval:
+		Actor->SetActorTickInterval(TickPolicy.Interval);
+		break;
+	case EGameplayTickPolicy::Significance:
+		if (Actor->SignificanceIndex != INDEX_NONE) return;
+
+		// Starts asleep, the next significance update decides if it's close enough to tick.
+		Actor->SetActorTickEnabled(false);
+		Actor->SignificanceIndex = SignificanceActors.Add(Actor);
+		SignificanceBuckets.Add(ESignificanceBucket::Unknown);
+		SignificanceUpdateAccumulator = SignificanceUpdateInterval;
+		break;
+	}
+}
+
+void UTickPolicySubsystem::UnregisterActor(ACustomActor* Actor)
+{
+	if (!Actor || !SignificanceActors.IsValidIndex(Actor->SignificanceIndex)) return;
+
+	const int32 Index = Actor->SignificanceIndex;
+	SignificanceActors.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	SignificanceBuckets.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	if (SignificanceActors.IsValidIndex(Index)) SignificanceActors[Index]->SignificanceIndex = Index;
+
+	Actor->SignificanceIndex = INDEX_NONE;
+}
+
+void UTickPolicySubsystem::UpdateSignificance()
+{
+	SCOPE_CYCLE_COUNTER(STAT_TickSignificanceUpdate);
+	SET_DWORD_STAT(STAT_TickSignificanceActors, SignificanceActors.Num());
+
+	if (SignificanceActors.IsEmpty()) return;
+
+	APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	if (!PlayerController) return;
+
+	FVector ViewLocation;
+	FRotator ViewRotation;
+	PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+	for (int32 i = 0; i < SignificanceActors.Num(); i++)
+	{
+		ACustomActor* Actor = SignificanceActors[i];
+		const FGameplayTickPolicy& TickPolicy = Actor->GetTickPolicy();
+		const double DistanceSquared = FVector::DistSquared(ViewLocation, Actor->GetActorLocation());
+
+		ESignificanceBucket Bucket = ESignificanceBucket::Culled;
+		if (DistanceSquared <= FMath::Square(TickPolicy.NearDistance)) Bucket = ESignificanceBucket::Near;
+		else if (DistanceSquared <= FMath::Square(TickPolicy.FarDistance)) Bucket = ESignificanceBucket::Far;
+
+		if (Bucket == SignificanceBuckets[i]) continue;
+
+		SignificanceBuckets[i] = Bucket;
+		ApplySignificanceBucket(Actor, Bucket);
+	}
+}
+
+void UTickPolicySubsystem::ApplySignificanceBucket(ACustomActor* Actor, ESignificanceBucket Bucket)
+{
+	switch (Bucket)
+	{
+	case ESignificanceBucket::Near:
+		Actor->SetActorTickInterval(0.0f);
+		Actor->SetActorTickEnabled(true);
+		break;
+	case ESignificanceBucket::Far:
+		Actor->SetActorTickInterval(Actor->GetTickPolicy().FarInterval);
+		Actor->SetActorTickEnabled(true);
+		break;
+	default:
+		Actor->SetActorTickEnabled(false);
+		break;
+	}
+}
@@ -7,7 +7,7 @@
 AInteractableObject::AInteractableObject()
 {
  	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bCanEverTick = false;
 
 	StaticMesh = CreateDefaultSubobject<UStaticMeshComponent>("Static Mesh");
 }
@@ -30,11 +30,4 @@ bool AInteractableObject::Interact(APlayerCharacter* InteractInstigator)
 	BP_OnInteract(InteractInstigator);
 	
 	return IInteractionInterface::Interact(InteractInstigator);
-}
-
-// Called every frame
-void AInteractableObject::Tick(float DeltaTime)
-{
-	Super::Tick(DeltaTime);
-
 }
\ No newline at end of file
@@ -114,6 +114,14 @@ void APlayerCharacter::EnterSeat(AActor* Seat)
 	FirstPersonCamera->bUsePawnControlRotation = false;
 }
 
+ARemoteControlTurret* APlayerCharacter::SetControlledTurret(ARemoteControlTurret* NewTurret)
+{
+	if (ControlledTurret) ControlledTurret->SetPlayerControlled(false);
+	if (NewTurret) NewTurret->SetPlayerControlled(true);
+
+	return ControlledTurret = NewTurret;
+}
+
 void APlayerCharacter::Exit()
 {
 	GetPlayerController()->SetControllerMode(EControllerMode::FirstPerson);
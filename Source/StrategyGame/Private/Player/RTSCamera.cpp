@@ -5,7 +5,10 @@
 
 #include "Building/Road.h"
 #include "Player/PlayerCharacter.h"
+#include "Camera/PlayerCameraManager.h"
 #include "Components/ArrowComponent.h"
+#include "Debug/TickCensus.h"
+#include "Game/ActorPoolSubsystem.h"
 #include "Game/StrategyGameModeBase.h"
 #include "Kismet/GameplayStatics.h"
 #include "Kismet/KismetSystemLibrary.h"
@@ -34,6 +37,8 @@ void ARTSCamera::BeginPlay()
 	SpringArm->TargetArmLength = (ZoomDistanceMax + ZoomDistanceMin) / 2;
 	ZoomDistanceTarget = SpringArm->TargetArmLength;
 	UpdateCameraPitch();
+
+	RefreshCursorTraceParams();
 }
 
 void ARTSCamera::Move(FVector2D MoveInput)
@@ -129,8 +134,7 @@ void ARTSCamera::CancelAction()
 {
 	if (BuildableBlueprint && BuildableBlueprint->IsBeingCreated())
 	{
-		BuildableBlueprint->Destroy();
-		BuildableBlueprint = nullptr;
+		ReleaseBuildableBlueprint();
 	}
 
 	if (CurrentRTSTool != ERTSTool::SelectTool)
@@ -142,6 +146,9 @@ void ARTSCamera::CancelAction()
 void ARTSCamera::PlaceBlueprint()
 {
 	BuildableBlueprint->PlaceBuilding();
+
+	// Placing can change what the blueprint does with the same location, like roads adding a point or finishing.
+	LastBlueprintLocation = FVector(TNumericLimits<float>::Max());
 }
 
 void ARTSCamera::RotateBuilding()
@@ -153,8 +160,7 @@ void ARTSCamera::EquipRecycleTool()
 {
 	if (BuildableBlueprint)
 	{
-		BuildableBlueprint->Destroy();
-		BuildableBlueprint = nullptr;
+		ReleaseBuildableBlueprint();
 	}
 	
 	CurrentRTSTool = ERTSTool::RecycleTool;
@@ -174,65 +180,165 @@ void ARTSCamera::ExitRTSMode()
 FHitResult ARTSCamera::LineTraceToMousePos(ECollisionChannel CollisionChannel)
 {
 	FHitResult Hit;
+
+	UpdateCursorRay();
+	if (!bCursorRayValid) return Hit;
+
+	FVector TraceEnd = CursorRayOrigin + CursorRayDirection * 200000.0f;
+	GetWorld()->LineTraceSingleByChannel(Hit, CursorRayOrigin, TraceEnd, CollisionChannel, CursorTraceParams);
 	
-	FVector TraceStart;
-	FVector TraceDirection;
-	GetPlayerController()->DeprojectMousePositionToWorld(TraceStart, TraceDirection);
-	FVector TraceEnd = TraceStart + TraceDirection * 200000.0f;
+	return Hit;
+}
 
-	FCollisionQueryParams TraceParams;
+void ARTSCamera::RefreshCursorTraceParams()
+{
 	TArray<AActor*> ActorsToIgnore;
 	GetAllChildActors(ActorsToIgnore);
 	ActorsToIgnore.Add(this);
 	if (BuildableBlueprint) ActorsToIgnore.Add(BuildableBlueprint);
 
-	TraceParams.AddIgnoredActors(ActorsToIgnore);
+	CursorTraceParams = FCollisionQueryParams(SCENE_QUERY_STAT(RTSCursorTrace), false);
+	CursorTraceParams.AddIgnoredActors(ActorsToIgnore);
+}
 
-	GetWorld()->LineTraceSingleByChannel(Hit, TraceStart, TraceEnd, CollisionChannel, TraceParams);
-	
-	return Hit;
+bool ARTSCamera::UpdateCursorRay()
+{
+	ARTSPlayerController* PlayerController = GetPlayerController();
+	float MouseX, MouseY;
+	if (!PlayerController || !PlayerController->PlayerCameraManager || !PlayerController->GetMousePosition(MouseX, MouseY))
+	{
+		bCursorRayValid = false;
+		return false;
+	}
+
+	// Deprojecting uses last frame's view, which is what the camera manager has cached.
+	const FVector2D ScreenPosition(MouseX, MouseY);
+	const FVector ViewLocation = PlayerController->PlayerCameraManager->GetCameraLocation();
+	const FRotator ViewRotation = PlayerController->PlayerCameraManager->GetCameraRotation();
+
+	if (bCursorRayValid && ScreenPosition == CursorScreenPosition && ViewLocation == CursorViewLocation && ViewRotation == CursorViewRotation)
+	{
+		return false;
+	}
+
+	CursorScreenPosition = ScreenPosition;
+	CursorViewLocation = ViewLocation;
+	CursorViewRotation = ViewRotation;
+	bCursorRayValid = PlayerController->DeprojectScreenPositionToWorld(MouseX, MouseY, CursorRayOrigin, CursorRayDirection);
+	CursorRayVersion++;
+
+	return true;
+}
+
+bool ARTSCamera::GetCursorGroundLocation(FVector& OutLocation)
+{
+	UpdateCursorRay();
+	if (!bCursorRayValid || FMath::IsNearlyZero(CursorRayDirection.Z)) return false;
+
+	if (CursorGroundVersion == CursorRayVersion)
+	{
+		OutLocation = CursorGroundLocation;
+		return true;
+	}
+
+	// Starts from the height under the last ground location, then moves to the height of the cell the ray lands on
+	// until it settles. Flat ground settles straight away, slopes take a couple of steps.
+	float Height = CursorGroundLocation.Z;
+	FVector Location = CursorGroundLocation;
+	for (int32 Step = 0; Step < 4; Step++)
+	{
+		const double Distance = (Height - CursorRayOrigin.Z) / CursorRayDirection.Z;
+		if (Distance < 0.0) return false;
+
+		Location = CursorRayOrigin + CursorRayDirection * Distance;
+		const float CellHeight = GetGroundHeight(Location);
+		if (FMath::IsNearlyEqual(CellHeight, Height, 1.0f)) break;
+
+		Height = CellHeight;
+	}
+
+	CursorGroundLocation = FVector(Location.X, Location.Y, Height);
+	CursorGroundVersion = CursorRayVersion;
+
+	OutLocation = CursorGroundLocation;
+	return true;
+}
+
+float ARTSCamera::GetGroundHeight(const FVector& Location)
+{
+	const float CellSize = GetSnappingSize();
+	const FIntPoint Cell(FMath::RoundToInt32(Location.X / CellSize), FMath::RoundToInt32(Location.Y / CellSize));
+
+	if (const float* Height = GroundHeightCache.Find(Cell))
+	{
+		return *Height;
+	}
+
+	// Samples the ground at the snap point, since that's where the blueprint ends up.
+	const FVector CellCenter(Cell.X * CellSize, Cell.Y * CellSize, 0.0f);
+	FHitResult Hit;
+	GetWorld()->LineTraceSingleByChannel(Hit, CellCenter + FVector(0.0f, 0.0f, 200000.0f), CellCenter - FVector(0.0f, 0.0f, 200000.0f), ECC_GameTraceChannel1, CursorTraceParams);
+
+	const float Height = Hit.bBlockingHit ? Hit.ImpactPoint.Z : 0.0f;
+	GroundHeightCache.Add(Cell, Height);
+	return Height;
+}
+
+void ARTSCamera::InvalidateGroundHeightCache()
+{
+	GroundHeightCache.Reset();
+	CursorGroundVersion = MAX_uint32;
 }
 
 void ARTSCamera::SelectBuildableBlueprint(TSubclassOf<ABuildable> NewBlueprint)
 {
 	CancelAction();
-	BuildableBlueprint = GetWorld()->SpawnActor<ABuildable>(NewBlueprint);
-	BuildableBlueprint->SetBuildableState(EBuildableState::BeingCreated);
+
+	UActorPoolSubsystem* ActorPool = GetWorld()->GetSubsystem<UActorPoolSubsystem>();
+	BuildableBlueprint = ActorPool ? ActorPool->AcquireActor<ABuildable>(NewBlueprint, FTransform::Identity) : GetWorld()->SpawnActor<ABuildable>(NewBlueprint);
+	if (BuildableBlueprint) BuildableBlueprint->SetBuildableState(EBuildableState::BeingCreated);
+
+	// Buildings placed since the last time could be standing on the cached heights.
+	InvalidateGroundHeightCache();
+	RefreshCursorTraceParams();
+	LastBlueprintLocation = FVector(TNumericLimits<float>::Max());
+}
+
+void ARTSCamera::ReleaseBuildableBlueprint()
+{
+	UActorPoolSubsystem* ActorPool = GetWorld()->GetSubsystem<UActorPoolSubsystem>();
+	if (ActorPool) ActorPool->ReleaseActor(BuildableBlueprint);
+	else BuildableBlueprint->Destroy();
+
+	BuildableBlueprint = nullptr;
+	RefreshCursorTraceParams();
 }
 
 void ARTSCamera::MoveBlueprintToMousePos()
 {
 	if (!BuildableBlueprint) return;
 
-	FHitResult Hit = LineTraceToMousePos(ECC_GameTraceChannel1);
+	FVector GroundLocation;
+	if (!GetCursorGroundLocation(GroundLocation)) return;
 	
-	FVector NewLocation = SnapVectorToGrid(Hit.ImpactPoint, GetSnappingSize());
+	FVector NewLocation = SnapVectorToGrid(GroundLocation, GetSnappingSize());
 	NewLocation += FVector(BuildableBlueprint->GetSnappingOffset().X, BuildableBlueprint->GetSnappingOffset().Y, 0.0f);
 
+	if (NewLocation == LastBlueprintLocation) return;
+	LastBlueprintLocation = NewLocation;
+
 	BuildableBlueprint->MoveBuilding(NewLocation);
 }
 
 void ARTSCamera::OnTimeScaleChanged(const ETimeScale NewTimeScale)
 {
-	switch (NewTimeScale)
-	{
-	case ETimeScale::OneTimesSpeed:
-		CustomTimeDilation = 1.0f;
-		break;
-	case ETimeScale::TwoTimesSpeed:
-		CustomTimeDilation = 1.0f / 2.0f;
-		break;
-	case ETimeScale::ThreeTimesSpeed:
-		CustomTimeDilation = 1.0f / 3.0f;
-		break;
-	}
-	
 	BP_OnTimeScaleChanged(NewTimeScale);
 }
 
 // Called every frame
 void ARTSCamera::Tick(float DeltaTime)
 {
+	FTickCensusScope CensusScope(this);
 	Super::Tick(DeltaTime);
 
 	// Empty spaces to move the debug messages below the in-game UI.
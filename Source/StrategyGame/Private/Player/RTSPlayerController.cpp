@@ -38,6 +38,10 @@ void ARTSPlayerController::SetupPlayerInputComponent(UInputComponent* PlayerInpu
 	Input->BindAction(Input_RTS_1xSpeed, ETriggerEvent::Triggered, this, &ARTSPlayerController::RTS_Set1xSpeed);
 	Input->BindAction(Input_RTS_2xSpeed, ETriggerEvent::Triggered, this, &ARTSPlayerController::RTS_Set2xSpeed);
 	Input->BindAction(Input_RTS_3xSpeed, ETriggerEvent::Triggered, this, &ARTSPlayerController::RTS_Set3xSpeed);
+	// The high speeds are optional, so only bind them if an action has been assigned.
+	if (Input_RTS_10xSpeed) Input->BindAction(Input_RTS_10xSpeed, ETriggerEvent::Triggered, this, &ARTSPlayerController::RTS_Set10xSpeed);
+	if (Input_RTS_25xSpeed) Input->BindAction(Input_RTS_25xSpeed, ETriggerEvent::Triggered, this, &ARTSPlayerController::RTS_Set25xSpeed);
+	if (Input_RTS_50xSpeed) Input->BindAction(Input_RTS_50xSpeed, ETriggerEvent::Triggered, this, &ARTSPlayerController::RTS_Set50xSpeed);
 
 	// TURRET INPUT
 	Input->BindAction(Input_Turret_Look, ETriggerEvent::Triggered, this, &ARTSPlayerController::Turret_Look);
@@ -86,19 +90,6 @@ void ARTSPlayerController::OnPossess(APawn* InPawn)
 
 void ARTSPlayerController::OnTimeScaleChanged(const ETimeScale NewTimeScale)
 {
-	switch (NewTimeScale)
-	{
-	case ETimeScale::OneTimesSpeed:
-		CustomTimeDilation = 1.0f;
-		break;
-	case ETimeScale::TwoTimesSpeed:
-		CustomTimeDilation = 1.0f / 2.0f;
-		break;
-	case ETimeScale::ThreeTimesSpeed:
-		CustomTimeDilation = 1.0f / 3.0f;
-		break;
-	}
-	
 	BP_OnTimeScaleChanged(NewTimeScale);
 }
 
@@ -279,6 +270,27 @@ void ARTSPlayerController::RTS_Set3xSpeed()
 	GetStrategyGameState()->SetTimeScale(ETimeScale::ThreeTimesSpeed);
 }
 
+void ARTSPlayerController::RTS_Set10xSpeed()
+{
+	if (ControllerMode != EControllerMode::RTS) return;
+
+	GetStrategyGameState()->SetTimeScale(ETimeScale::TenTimesSpeed);
+}
+
+void ARTSPlayerController::RTS_Set25xSpeed()
+{
+	if (ControllerMode != EControllerMode::RTS) return;
+
+	GetStrategyGameState()->SetTimeScale(ETimeScale::TwentyFiveTimesSpeed);
+}
+
+void ARTSPlayerController::RTS_Set50xSpeed()
+{
+	if (ControllerMode != EControllerMode::RTS) return;
+
+	GetStrategyGameState()->SetTimeScale(ETimeScale::FiftyTimesSpeed);
+}
+
 void ARTSPlayerController::ReturnToFirstPerson()
 {
 	switch (ControllerMode)
@@ -3,6 +3,8 @@
 
 #include "Projectile.h"
 
+#include "Debug/TickCensus.h"
+#include "Game/HealthSubsystem.h"
 #include "Kismet/KismetSystemLibrary.h"
 
 // Sets default values
@@ -46,9 +48,10 @@ void AProjectile::CheckCollision()
 
 	if (!Hit.GetActor()) return;
 		
-	Hit.GetActor()->TakeDamage(Damage, FPointDamageEvent(), GetInstigatorController(), GetInstigator());
-
-	GEngine->AddOnScreenDebugMessage(20, 3.0f, FColor::Green, Hit.GetActor()->GetName());
+	if (UHealthSubsystem* HealthSubsystem = GetWorld()->GetSubsystem<UHealthSubsystem>())
+	{
+		HealthSubsystem->QueueDamage(Hit.GetActor(), Damage, Spawner);
+	}
 
 	if (UStaticMeshComponent* SMComp = Hit.GetActor()->GetComponentByClass<UStaticMeshComponent>())
 	{
@@ -61,6 +64,7 @@ void AProjectile::CheckCollision()
 // Called every frame
 void AProjectile::Tick(float DeltaTime)
 {
+	FTickCensusScope CensusScope(this);
 	Super::Tick(DeltaTime);
 
 	CheckCollision();
@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Rendering/InstancedRenderActor.h"
+
+#include "Components/InstancedStaticMeshComponent.h"
+
+// Sets default values
+AInstancedRenderActor::AInstancedRenderActor()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	SceneComponent = CreateDefaultSubobject<USceneComponent>("Root");
+	SetRootComponent(SceneComponent);
+}
+
+UInstancedStaticMeshComponent* AInstancedRenderActor::GetInstancedMesh(UStaticMesh* Mesh, bool bCastShadow)
+{
+	if (!Mesh) return nullptr;
+
+	if (UInstancedStaticMeshComponent** Existing = InstancedMeshes.Find(Mesh)) return *Existing;
+
+	UInstancedStaticMeshComponent* InstancedMesh = NewObject<UInstancedStaticMeshComponent>(this);
+	InstancedMesh->SetupAttachment(SceneComponent);
+	InstancedMesh->SetStaticMesh(Mesh);
+	InstancedMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	InstancedMesh->SetGenerateOverlapEvents(false);
+	InstancedMesh->SetCastShadow(bCastShadow);
+	InstancedMesh->SetMobility(EComponentMobility::Movable);
+	InstancedMesh->RegisterComponent();
+
+	InstancedMeshes.Add(Mesh, InstancedMesh);
+	return InstancedMesh;
+}
+
+void AInstancedRenderActor::UpdateInstances(UInstancedStaticMeshComponent* InstancedMesh, const TArray<FTransform>& Transforms)
+{
+	if (!InstancedMesh) return;
+
+	// Only the instances past the end are added or removed, everything else is overwritten in place.
+	const int32 CurrentCount = InstancedMesh->GetInstanceCount();
+	if (CurrentCount > Transforms.Num())
+	{
+		TArray<int32> InstancesToRemove;
+		for (int32 Index = CurrentCount - 1; Index >= Transforms.Num(); Index--)
+		{
+			InstancesToRemove.Add(Index);
+		}
+		InstancedMesh->RemoveInstances(InstancesToRemove);
+	}
+	else if (CurrentCount < Transforms.Num())
+	{
+		const TArray<FTransform> NewInstances(Transforms.GetData() + CurrentCount, Transforms.Num() - CurrentCount);
+		InstancedMesh->AddInstances(NewInstances, false, true, false);
+	}
+
+	if (Transforms.Num() > 0)
+	{
+		InstancedMesh->BatchUpdateInstancesTransforms(0, Transforms, true, true, true);
+	}
+}
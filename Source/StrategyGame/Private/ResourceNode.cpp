@@ -3,12 +3,14 @@
 
 #include "ResourceNode.h"
 
+#include "Game/ResourceFieldSubsystem.h"
+
 
 // Sets default values
 AResourceNode::AResourceNode()
 {
 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bCanEverTick = false;
 
 	SceneComponent = CreateDefaultSubobject<USceneComponent>("Root");
 	SetRootComponent(SceneComponent);
@@ -16,35 +18,45 @@ AResourceNode::AResourceNode()
 	StaticMesh = CreateDefaultSubobject<UStaticMeshComponent>("Static Mesh");
 	StaticMesh->SetupAttachment(SceneComponent);
 	StaticMesh->SetCollisionProfileName("SelectableObject");
-	StaticMesh->SetGenerateOverlapEvents(true);
-
-	Sphere = CreateDefaultSubobject<USphereComponent>("Trigger");
-	Sphere->SetupAttachment(StaticMesh);
-	Sphere->SetCollisionProfileName("Trigger");
-	Sphere->SetSphereRadius(2000.0f);
 }
 
 // Called when the game starts or when spawned
 void AResourceNode::BeginPlay()
 {
 	Super::BeginPlay();
-	
+
+	if (UResourceFieldSubsystem* ResourceField = GetWorld()->GetSubsystem<UResourceFieldSubsystem>())
+	{
+		ResourceField->RegisterNode(this);
+	}
 }
 
-// Called every frame
-void AResourceNode::Tick(float DeltaTime)
+void AResourceNode::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	Super::Tick(DeltaTime);
+	if (UResourceFieldSubsystem* ResourceField = GetWorld()->GetSubsystem<UResourceFieldSubsystem>())
+	{
+		ResourceField->UnregisterNode(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
-void AResourceNode::DrainResource(int32 DecreaseAmount)
+float AResourceNode::DrainResource(float DecreaseAmount)
 {
-	ResourceAmount = FMath::Clamp(ResourceAmount - DecreaseAmount, 0, ResourceAmount);
+	UResourceFieldSubsystem* ResourceField = GetWorld()->GetSubsystem<UResourceFieldSubsystem>();
+	if (ResourceField && ResourceField->IsRegistered(this)) return ResourceField->DrainNode(this, DecreaseAmount);
 
-	if (ResourceAmount <= 0)
-	{
-		Destroy();
-	}
+	const float AmountDrained = FMath::Clamp(DecreaseAmount, 0.0f, ResourceAmount);
+	ResourceAmount -= AmountDrained;
+	return AmountDrained;
+}
+
+float AResourceNode::GetResourceAmount()
+{
+	const UResourceFieldSubsystem* ResourceField = GetWorld() ? GetWorld()->GetSubsystem<UResourceFieldSubsystem>() : nullptr;
+	if (ResourceField && ResourceField->IsRegistered(this)) return ResourceField->GetReserve(this);
+
+	return ResourceAmount;
 }
 
 void AResourceNode::SetAssignedExtractor(ABuildable* NewExtractor)
@@ -53,6 +65,23 @@ void AResourceNode::SetAssignedExtractor(ABuildable* NewExtractor)
 	{
 		GEngine->AddOnScreenDebugMessage(960, 3.0f, FColor::Red, "Cannot assign new extractor, there is already one assigned.");
 	}
-	else AssignedExtractor = NewExtractor;
+	else
+	{
+		AssignedExtractor = NewExtractor;
+		if (UResourceFieldSubsystem* ResourceField = GetWorld()->GetSubsystem<UResourceFieldSubsystem>())
+		{
+			ResourceField->SetNodeAssigned(this, AssignedExtractor != nullptr);
+		}
+	}
 }
 
+void AResourceNode::ClearAssignedExtractor(ABuildable* Extractor)
+{
+	if (!AssignedExtractor || AssignedExtractor != Extractor) return;
+
+	AssignedExtractor = nullptr;
+	if (UResourceFieldSubsystem* ResourceField = GetWorld()->GetSubsystem<UResourceFieldSubsystem>())
+	{
+		ResourceField->SetNodeAssigned(this, false);
+	}
+}
@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+// Build grid stamp tests.
+//
+// Stamps overlapping rects into the build grid of a test world, the way crossing roads, road chunks sharing an end
+// cell or overlapping exclusion zones do, and checks removing one leaves the cells the others cover occupied.
+//
+// Example:
+//   -ExecCmds="Automation RunTests StrategyGame.BuildGrid"
+
+#include "Building/BuildGridSubsystem.h"
+#include "Misc/AutomationTest.h"
+#include "Tests/StrategyGameTestWorld.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBuildGridOverlappingStampsTest, "StrategyGame.BuildGrid.OverlappingStamps",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FBuildGridOverlappingStampsTest::RunTest(const FString& Parameters)
+{
+	FStrategyGameTestWorld TestWorld;
+	UBuildGridSubsystem* BuildGrid = TestWorld.World->GetSubsystem<UBuildGridSubsystem>();
+	if (!TestNotNull(TEXT("Build grid subsystem"), BuildGrid)) return false;
+
+	AActor* First = TestWorld.SpawnActor<AActor>();
+	AActor* Second = TestWorld.SpawnActor<AActor>();
+
+	// Two roads crossing in a shared cell.
+	const FIntRect FirstRect(FIntPoint(0, 0), FIntPoint(4, 1));
+	const FIntRect SecondRect(FIntPoint(2, -2), FIntPoint(3, 3));
+	const FIntRect Shared(FIntPoint(2, 0), FIntPoint(3, 1));
+	const FIntRect FirstOnly(FIntPoint(0, 0), FIntPoint(2, 1));
+
+	BuildGrid->StampRect(First, EBuildGridLayer::Road, FirstRect);
+	BuildGrid->StampRect(Second, EBuildGridLayer::Road, SecondRect);
+
+	TArray<AActor*> Owners;
+	BuildGrid->GetOwnersInArea(Shared, EBuildGridLayer::Road, Owners);
+	TestTrue(TEXT("Both stamps own the shared cell"), Owners.Num() == 2 && Owners.Contains(First) && Owners.Contains(Second));
+	TestFalse(TEXT("Shared cell is blocked by the second stamp when ignoring the first"), BuildGrid->IsAreaFree(Shared, EBuildGridLayer::Road, First));
+	TestFalse(TEXT("Shared cell is blocked by the first stamp when ignoring the second"), BuildGrid->IsAreaFree(Shared, EBuildGridLayer::Road, Second));
+
+	BuildGrid->Unstamp(First);
+
+	TestFalse(TEXT("Shared cell stays occupied after removing one stamp"), BuildGrid->IsAreaFree(Shared, EBuildGridLayer::Road));
+	TestTrue(TEXT("Cells only the removed stamp covered are free"), BuildGrid->IsAreaFree(FirstOnly, EBuildGridLayer::Road));
+	TestTrue(TEXT("Remaining stamp is the only owner of its cells"), BuildGrid->IsAreaFree(SecondRect, EBuildGridLayer::Road, Second));
+
+	Owners.Reset();
+	BuildGrid->GetOwnersInArea(FirstRect, EBuildGridLayer::Road, Owners);
+	TestTrue(TEXT("Only the remaining stamp owns cells in the removed stamp's area"), Owners.Num() == 1 && Owners.Contains(Second));
+
+	// Restamping in place, as moving a building does, keeps the count right.
+	BuildGrid->StampRect(Second, EBuildGridLayer::Road, SecondRect);
+	BuildGrid->Unstamp(Second);
+	TestTrue(TEXT("Every cell is free once both stamps are removed"), BuildGrid->IsAreaFree(SecondRect, EBuildGridLayer::Road));
+
+	return true;
+}
+
+#endif
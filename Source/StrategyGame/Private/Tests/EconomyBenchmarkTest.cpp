@@ -0,0 +1,262 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+// Headless economy scaling benchmark.
+//
+// Builds cities of increasing size, each in a world of its own, simulates a number of in-game days through the economy
+// subsystem and writes the cost per simulated second to a CSV in Saved/Profiling/StrategyGame, so results can be
+// compared between builds. Days, sizes and the data table to build from can be set on the command line.
+//
+// Example, on a Linux build:
+//   StrategyGame.sh -game -nullrhi -unattended -EconomyBenchmarkDays=2 -EconomyBenchmarkSizes=100+1000+10000+50000
+//     -ExecCmds="Automation RunTests StrategyGame.Benchmark.Economy; Quit"
+// Sizes are separated with plus signs, the command line parser stops at commas.
+
+#include "StrategyGame.h"
+#include "Building/Structure.h"
+#include "Game/EconomySubsystem.h"
+#include "Game/StrategyGameState.h"
+#include "HAL/FileManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Tests/StrategyGameTestWorld.h"
+#include "UObject/StrongObjectPtr.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace EconomyBenchmark
+{
+	struct FResult
+	{
+		int32 Structures = 0;
+		int32 Days = 0;
+		int32 SimulatedSeconds = 0;
+		double SpawnMilliseconds = 0.0;
+		double EconomyMilliseconds = 0.0;
+		double EmploymentMilliseconds = 0.0;
+		double BroadcastMilliseconds = 0.0;
+	};
+
+	// Builds a small mix of producers, consumers, housing and storage, used when no table is passed in.
+	UDataTable* CreateDefaultTable()
+	{
+		UDataTable* Table = NewObject<UDataTable>(GetTransientPackage(), TEXT("EconomyBenchmarkTable"), RF_Transient);
+		Table->RowStruct = FStructureData::StaticStruct();
+
+		FStructureData Factory;
+		Factory.bGeneratesResources = true;
+		Factory.ResourcesToGeneratePerSecond = { { EResourceType::Metal, 1.0f }, { EResourceType::Concrete, 1.0f } };
+		Factory.bConsumesResources = true;
+		Factory.ResourcesToConsumePerSecond = { { EResourceType::Power, 0.5f } };
+		Factory.bAllowWorkerEmployment = true;
+		Factory.MaxWorkerCapacity = 10;
+		Table->AddRow(TEXT("Factory"), Factory);
+
+		FStructureData Farm;
+		Farm.bGeneratesResources = true;
+		Farm.ResourcesToGeneratePerSecond = { { EResourceType::Food, 2.0f } };
+		Farm.bAllowWorkerEmployment = true;
+		Farm.MaxWorkerCapacity = 5;
+		Table->AddRow(TEXT("Farm"), Farm);
+
+		FStructureData PowerPlant;
+		PowerPlant.bGeneratesResources = true;
+		PowerPlant.ResourcesToGeneratePerSecond = { { EResourceType::Power, 2.0f } };
+		PowerPlant.bConsumesResources = true;
+		PowerPlant.ResourcesToConsumePerSecond = { { EResourceType::Oil, 0.2f } };
+		PowerPlant.bAllowWorkerEmployment = true;
+		PowerPlant.MaxWorkerCapacity = 5;
+		Table->AddRow(TEXT("PowerPlant"), PowerPlant);
+
+		FStructureData Laboratory;
+		Laboratory.bGeneratesResources = true;
+		Laboratory.ResourcesToGeneratePerSecond = { { EResourceType::ResearchPoints, 0.1f } };
+		Laboratory.bConsumesResources = true;
+		Laboratory.ResourcesToConsumePerSecond = { { EResourceType::Power, 0.2f } };
+		Laboratory.bAllowScientistEmployment = true;
+		Laboratory.MaxWorkerCapacity = 5;
+		Table->AddRow(TEXT("Laboratory"), Laboratory);
+
+		FStructureData Housing;
+		Housing.AdditionalPopulationCapacity = 20;
+		Table->AddRow(TEXT("Housing"), Housing);
+
+		FStructureData Warehouse;
+		Warehouse.bIncreasesStorageCapacity = true;
+		Warehouse.ResourcesToIncreaseStorage = { { EResourceType::Metal, 500 }, { EResourceType::Concrete, 500 }, { EResourceType::Food, 500 } };
+		Table->AddRow(TEXT("Warehouse"), Warehouse);
+
+		return Table;
+	}
+
+	// Game hours last this many seconds in the shipped game mode. The test world has no game mode to ask.
+	constexpr float SecondsInGameHours = 5.0f;
+
+	FResult RunCity(UDataTable* Table, int32 NumStructures, int32 Days)
+	{
+		FStrategyGameTestWorld TestWorld;
+		AStrategyGameState* GameState = TestWorld.GameState;
+		UEconomySubsystem* Economy = TestWorld.World->GetSubsystem<UEconomySubsystem>();
+
+		FResult Result;
+		Result.Structures = NumStructures;
+		Result.Days = Days;
+
+		// ------ SPAWN ------
+
+		const TArray<FName> RowNames = Table->GetRowNames();
+		const int32 GridWidth = FMath::CeilToInt32(FMath::Sqrt(static_cast<float>(NumStructures)));
+		const float Spacing = 1000.0f;
+
+		double StartTime = FPlatformTime::Seconds();
+
+		TArray<AStructure*> Structures;
+		Structures.Reserve(NumStructures);
+		for (int32 i = 0; i < NumStructures; i++)
+		{
+			AStructure* Structure = TestWorld.SpawnActor<AStructure>(FVector((i % GridWidth) * Spacing, (i / GridWidth) * Spacing, 0.0f));
+			if (!Structure) continue;
+
+			FDataTableRowHandle Row;
+			Row.DataTable = Table;
+			Row.RowName = RowNames[i % RowNames.Num()];
+			Structure->SetStructureDataTableRow(Row);
+			Structure->ActivateStructureEffects();
+
+			Structures.Add(Structure);
+		}
+
+		// Fill the new housing and give every structure as many citizens as it can employ.
+		int32 HousingLeft = FMath::Max(GameState->GetPopulationCapacity() - GameState->GetTotalPopulation(), 0);
+		for (AStructure* Structure : Structures)
+		{
+			for (ECitizenType WorkerType : TEnumRange<ECitizenType>())
+			{
+				const bool bAllowed = WorkerType == ECitizenType::Worker ? Structure->GetAllowWorkerEmployment() : Structure->GetAllowScientistEmployment();
+				const int32 Amount = FMath::Min(Structure->GetAvailableWorkersSlots(), HousingLeft);
+				if (!bAllowed || Amount <= 0) continue;
+
+				GameState->IncreasePopulation(WorkerType, Amount);
+				HousingLeft -= Amount;
+				Structure->AssignWorkers(WorkerType, Amount);
+			}
+		}
+
+		Result.SpawnMilliseconds = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+		GameState->FlushNotifications();
+
+		// ------ SIMULATE ------
+
+		const int32 NumSteps = FMath::CeilToInt32(Days * 24.0f * SecondsInGameHours / Economy->GetStepSeconds());
+		Result.SimulatedSeconds = FMath::CeilToInt32(NumSteps * Economy->GetStepSeconds());
+
+		// Summed so the queries can't be optimized away.
+		int64 QueryChecksum = 0;
+
+		for (int32 Step = 0; Step < NumSteps; Step++)
+		{
+			StartTime = FPlatformTime::Seconds();
+			Economy->StepEconomy();
+			Result.EconomyMilliseconds += (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+			// What the UI and worker assignment ask every step: open slots and efficiency per structure, and the city's employment totals.
+			StartTime = FPlatformTime::Seconds();
+			for (AStructure* Structure : Structures)
+			{
+				QueryChecksum += Structure->GetAvailableWorkersSlots();
+				QueryChecksum += Structure->GetWorkerEfficiency() > 0.5f;
+			}
+			for (ECitizenType WorkerType : TEnumRange<ECitizenType>())
+			{
+				QueryChecksum += GameState->GetUnemployedPopulation(WorkerType);
+			}
+			QueryChecksum += GameState->GetTotalEmployedPopulation() + GameState->GetHomelessPopulation();
+			Result.EmploymentMilliseconds += (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+			StartTime = FPlatformTime::Seconds();
+			GameState->FlushNotifications();
+			Result.BroadcastMilliseconds += (FPlatformTime::Seconds() - StartTime) * 1000.0;
+		}
+
+		UE_LOG(LogStrategyGame, Verbose, TEXT("Economy benchmark query checksum: %lld"), QueryChecksum);
+
+		return Result;
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FEconomyBenchmarkTest, "StrategyGame.Benchmark.Economy",
+	EAutomationTestFlags_ApplicationContextMask | EAutomationTestFlags::PerfFilter)
+
+bool FEconomyBenchmarkTest::RunTest(const FString& Parameters)
+{
+	using namespace EconomyBenchmark;
+
+	int32 Days = 1;
+	FParse::Value(FCommandLine::Get(), TEXT("EconomyBenchmarkDays="), Days);
+	Days = FMath::Max(Days, 1);
+
+	TArray<int32> Sizes = { 100, 1000, 10000, 50000 };
+	FString SizesValue;
+	if (FParse::Value(FCommandLine::Get(), TEXT("EconomyBenchmarkSizes="), SizesValue))
+	{
+		TArray<FString> SizeStrings;
+		const TCHAR* Delimiters[] = { TEXT(","), TEXT("+") };
+		SizesValue.ParseIntoArray(SizeStrings, Delimiters, UE_ARRAY_COUNT(Delimiters));
+
+		Sizes.Reset();
+		for (const FString& Size : SizeStrings)
+		{
+			if (FCString::Atoi(*Size) > 0) Sizes.Add(FCString::Atoi(*Size));
+		}
+	}
+
+	FString TablePath;
+	FParse::Value(FCommandLine::Get(), TEXT("EconomyBenchmarkTable="), TablePath);
+
+	TStrongObjectPtr<UDataTable> Table;
+	if (TablePath.IsEmpty())
+	{
+		Table.Reset(CreateDefaultTable());
+	}
+	else
+	{
+		Table.Reset(LoadObject<UDataTable>(nullptr, *TablePath));
+		if (!Table || !Table->GetRowStruct() || !Table->GetRowStruct()->IsChildOf(FStructureData::StaticStruct()) || Table->GetRowNames().IsEmpty())
+		{
+			AddError(FString::Printf(TEXT("%s is not a data table of FStructureData rows."), *TablePath));
+			return false;
+		}
+	}
+
+	FString Csv = TEXT("Structures,Days,SimulatedSeconds,SpawnMs,EconomyMsPerSimSecond,EmploymentMsPerSimSecond,BroadcastMsPerSimSecond\n");
+	for (const int32 Size : Sizes)
+	{
+		const FResult Result = RunCity(Table.Get(), Size, Days);
+		const double Seconds = FMath::Max(Result.SimulatedSeconds, 1);
+
+		AddInfo(FString::Printf(TEXT("%d structures, %d days | spawn %.1f ms | economy %.4f ms/s | employment %.4f ms/s | broadcasts %.4f ms/s"),
+			Result.Structures, Result.Days, Result.SpawnMilliseconds,
+			Result.EconomyMilliseconds / Seconds, Result.EmploymentMilliseconds / Seconds, Result.BroadcastMilliseconds / Seconds));
+
+		Csv += FString::Printf(TEXT("%d,%d,%d,%.3f,%.6f,%.6f,%.6f\n"),
+			Result.Structures, Result.Days, Result.SimulatedSeconds, Result.SpawnMilliseconds,
+			Result.EconomyMilliseconds / Seconds, Result.EmploymentMilliseconds / Seconds, Result.BroadcastMilliseconds / Seconds);
+	}
+
+	// Only the benchmark's own descriptors, a table loaded from disk may be shared with a level that's open.
+	if (TablePath.IsEmpty()) FStructureDescriptor::ClearCache(Table.Get());
+
+	const FString CsvPath = FPaths::ProfilingDir() / TEXT("StrategyGame") / FString::Printf(TEXT("EconomyBenchmark-%s.csv"), *FDateTime::Now().ToString());
+	if (!FFileHelper::SaveStringToFile(Csv, *CsvPath))
+	{
+		AddError(FString::Printf(TEXT("Failed to write %s"), *CsvPath));
+		return false;
+	}
+
+	AddInfo(FString::Printf(TEXT("Results written to %s"), *IFileManager::Get().ConvertToAbsolutePathForExternalAppForWrite(*CsvPath)));
+	return true;
+}
+
+#endif
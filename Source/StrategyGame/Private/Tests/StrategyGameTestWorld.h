@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+#include "Game/StrategyGameState.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// A game world of its own for automation tests, so they never touch the level that's being played.
+// Has an AStrategyGameState with its default resources and every world subsystem, but no game mode, and is never ticked.
+// Tests drive the subsystems directly. The world is destroyed when this goes out of scope.
+struct FStrategyGameTestWorld
+{
+	UWorld* World = nullptr;
+	AStrategyGameState* GameState = nullptr;
+
+	FStrategyGameTestWorld()
+	{
+		World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("StrategyGameTestWorld"));
+		FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+		WorldContext.SetCurrentWorld(World);
+
+		World->InitializeActorsForPlay(FURL());
+
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.ObjectFlags |= RF_Transient;
+		GameState = World->SpawnActor<AStrategyGameState>(SpawnParameters);
+		World->SetGameState(GameState);
+
+		// Without a game mode to start the match, actors are told to begin play here.
+		World->BeginPlay();
+		World->GetWorldSettings()->NotifyBeginPlay();
+	}
+
+	~FStrategyGameTestWorld()
+	{
+		GEngine->DestroyWorldContext(World);
+		World->DestroyWorld(false);
+	}
+
+	FStrategyGameTestWorld(const FStrategyGameTestWorld&) = delete;
+	FStrategyGameTestWorld& operator=(const FStrategyGameTestWorld&) = delete;
+
+	template <typename ActorType>
+	ActorType* SpawnActor(const FVector& Location = FVector::ZeroVector)
+	{
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		SpawnParameters.ObjectFlags |= RF_Transient;
+		return World->SpawnActor<ActorType>(ActorType::StaticClass(), Location, FRotator::ZeroRotator, SpawnParameters);
+	}
+};
+
+#endif
@@ -6,8 +6,9 @@
 #include "Components/ShootingComponent.h"
 #include "Components/SphereComponent.h"
 #include "Enemies/EnemyShip.h"
+#include "Enemies/EnemySwarmSubsystem.h"
 #include "Kismet/KismetMathLibrary.h"
-#include "Kismet/KismetSystemLibrary.h"
+#include "Turrets/TargetingSubsystem.h"
 
 
 // Sets default values
@@ -16,6 +17,9 @@ AAutomatedTurret::AAutomatedTurret()
 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
 
+	// Only ticks while it has a target to aim at.
+	TickPolicy.Policy = EGameplayTickPolicy::OnDemand;
+
 	SphereComponent = CreateDefaultSubobject<USphereComponent>("Turret Range");
 	SphereComponent->SetupAttachment(SceneComponent);
 	SphereComponent->SetCollisionProfileName("NoCollision");
@@ -26,39 +30,56 @@ void AAutomatedTurret::BeginPlay()
 {
 	Super::BeginPlay();
 
-	float TimerDuration = 0.2f;
-	bool Loops = true;
-	GetWorldTimerManager().SetTimer(ScanForEnemiesTimer, this, &ThisClass::ScanForEnemies, TimerDuration, Loops);
+	if (UTargetingSubsystem* TargetingSubsystem = GetWorld()->GetSubsystem<UTargetingSubsystem>())
+	{
+		TargetingSubsystem->RegisterTurret(this);
+	}
+}
+
+void AAutomatedTurret::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UTargetingSubsystem* TargetingSubsystem = GetWorld()->GetSubsystem<UTargetingSubsystem>())
+	{
+		TargetingSubsystem->UnregisterTurret(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void AAutomatedTurret::ScanForEnemies()
 {
-	if (BuildableState != EBuildableState::ConstructionComplete) return;
-	
-	FVector TraceStart = SphereComponent->GetComponentLocation();
-	FVector TraceEnd = TraceStart;
-	float Radius = SphereComponent->GetScaledSphereRadius();
-	bool TraceComplex = false;
-	TArray<AActor*> ActorsToIgnore;
-
-	TArray<FHitResult> Hits;
-	UKismetSystemLibrary::SphereTraceMulti(GetWorld(), TraceStart, TraceEnd, Radius, UEngineTypes::ConvertToTraceType(ECC_Visibility),
-		TraceComplex, ActorsToIgnore, EDrawDebugTrace::ForDuration, Hits, true, FLinearColor::Yellow, FLinearColor::Green, 0.2f);
-
-	AActor* ClosestEnemy = nullptr;
-	float ClosestEnemyDistance = SphereComponent->GetScaledSphereRadius();
-	for (FHitResult Hit : Hits)
+	if (UTargetingSubsystem* TargetingSubsystem = GetWorld()->GetSubsystem<UTargetingSubsystem>())
 	{
-		if (Hit.GetActor() && Hit.GetActor()->IsA(AEnemyShip::StaticClass()))
-		{
-			if (GetDistanceTo(Hit.GetActor()) < ClosestEnemyDistance)
-			{
-				ClosestEnemy = Hit.GetActor();
-				ClosestEnemyDistance = GetDistanceTo(Hit.GetActor());
-			}
-		}
+		TargetingSubsystem->AssignTarget(this);
 	}
-	TargetEnemy = ClosestEnemy;
+}
+
+void AAutomatedTurret::SetTargetEnemy(AActor* NewTargetEnemy)
+{
+	TargetEnemy = NewTargetEnemy;
+	TargetSwarmShip = INDEX_NONE;
+
+	if (TargetEnemy) WakeTick();
+	else SleepTick();
+}
+
+void AAutomatedTurret::SetTargetSwarmShip(int32 NewTargetSwarmShip)
+{
+	TargetEnemy = nullptr;
+	TargetSwarmShip = NewTargetSwarmShip;
+
+	if (TargetSwarmShip != INDEX_NONE) WakeTick();
+	else SleepTick();
+}
+
+FVector AAutomatedTurret::GetTargetingOrigin() const
+{
+	return SphereComponent->GetComponentLocation();
+}
+
+float AAutomatedTurret::GetTargetingRange() const
+{
+	return SphereComponent->GetScaledSphereRadius();
 }
 
 void AAutomatedTurret::AimAtTarget(FVector TargetPos)
@@ -71,6 +92,35 @@ void AAutomatedTurret::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
+	// The enemy can be destroyed or returned to its pool between target assignments.
+	if (TargetEnemy && (!IsValid(TargetEnemy) || TargetEnemy->IsHidden()))
+	{
+		SetTargetEnemy(nullptr);
+		return;
+	}
+
+	if (TargetSwarmShip != INDEX_NONE)
+	{
+		const UEnemySwarmSubsystem* Swarm = GetWorld()->GetSubsystem<UEnemySwarmSubsystem>();
+		if (!Swarm || !Swarm->GetShipPositions().IsValidIndex(TargetSwarmShip))
+		{
+			SetTargetSwarmShip(INDEX_NONE);
+			return;
+		}
+
+		// Once something promoted the ship, its actor is the target like any other enemy.
+		if (AEnemyShip* ShipActor = Swarm->GetShipActor(TargetSwarmShip))
+		{
+			SetTargetEnemy(ShipActor);
+		}
+		else
+		{
+			AimAtTarget(Swarm->GetShipPositions()[TargetSwarmShip]);
+			Fire();
+			return;
+		}
+	}
+
 	if (TargetEnemy)
 	{
 		AimAtTarget(TargetEnemy->GetActorLocation());
@@ -4,6 +4,7 @@
 #include "Turrets/RemoteControlTurret.h"
 
 #include "Components/SceneCaptureComponent2D.h"
+#include "Enemies/EnemySwarmSubsystem.h"
 
 ARemoteControlTurret::ARemoteControlTurret()
 {
@@ -20,6 +21,22 @@ void ARemoteControlTurret::BeginPlay()
 	DefaultFOV = SceneCapture->FOVAngle;
 }
 
+void ARemoteControlTurret::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	SetPlayerControlled(false);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ARemoteControlTurret::SetPlayerControlled(bool bPlayerControlled)
+{
+	UEnemySwarmSubsystem* Swarm = GetWorld()->GetSubsystem<UEnemySwarmSubsystem>();
+	if (!Swarm) return;
+
+	if (bPlayerControlled) Swarm->AddPromotionSource(this);
+	else Swarm->RemovePromotionSource(this);
+}
+
 void ARemoteControlTurret::Look(FVector2D Input)
 {
 	Input /= DefaultFOV / SceneCapture->FOVAngle;
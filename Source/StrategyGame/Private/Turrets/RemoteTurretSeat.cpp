@@ -11,7 +11,7 @@
 ARemoteTurretSeat::ARemoteTurretSeat()
 {
 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bCanEverTick = false;
 }
 
 // Called when the game starts or when spawned
@@ -35,10 +35,3 @@ void ARemoteTurretSeat::OnInteract(APlayerCharacter* InteractInstigator)
 	InteractInstigator->GetPlayerController()->SetControllerMode(EControllerMode::Turret);
 	InteractInstigator->EnterSeat(this);
 }
-
-// Called every frame
-void ARemoteTurretSeat::Tick(float DeltaTime)
-{
-	Super::Tick(DeltaTime);
-}
-
@@ -0,0 +1,257 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "Turrets/TargetingSubsystem.h"
+
+#include "StrategyGame.h"
+#include "Async/ParallelFor.h"
+#include "Enemies/EnemyShip.h"
+#include "Enemies/EnemySwarmSubsystem.h"
+#include "Turrets/AutomatedTurret.h"
+
+DECLARE_CYCLE_STAT(TEXT("Targeting Hash Build"), STAT_TargetingHashBuild, STATGROUP_StrategyGame);
+DECLARE_CYCLE_STAT(TEXT("Targeting Assign"), STAT_TargetingAssign, STATGROUP_StrategyGame);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Targeting Enemies"), STAT_TargetingEnemies, STATGROUP_StrategyGame);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Targeting Turrets"), STAT_TargetingTurrets, STATGROUP_StrategyGame);
+
+bool UTargetingSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UTargetingSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	TargetingAccumulator += DeltaTime;
+	if (TargetingAccumulator < TargetingInterval) return;
+	TargetingAccumulator = 0.0f;
+
+	AssignTargets();
+}
+
+TStatId UTargetingSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTargetingSubsystem, STATGROUP_Tickables);
+}
+
+void UTargetingSubsystem::Deinitialize()
+{
+	Enemies.Empty();
+	EnemyIndices.Empty();
+	Turrets.Empty();
+	TurretIndices.Empty();
+
+	Super::Deinitialize();
+}
+
+template <typename MapType, typename ElementType>
+void UTargetingSubsystem::RemoveIndexed(TArray<ElementType*>& Array, MapType& Indices, ElementType* Element)
+{
+	int32 Index;
+	if (!Indices.RemoveAndCopyValue(Element, Index)) return;
+
+	Array.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	if (Array.IsValidIndex(Index)) Indices[Array[Index]] = Index;
+}
+
+void UTargetingSubsystem::RegisterEnemy(AActor* Enemy)
+{
+	if (!Enemy || EnemyIndices.Contains(Enemy)) return;
+
+	EnemyIndices.Add(Enemy, Enemies.Add(Enemy));
+	HashFrame = MAX_uint64;
+}
+
+void UTargetingSubsystem::UnregisterEnemy(AActor* Enemy)
+{
+	// Pooled ships stay valid after they die, so turrets can't tell on their own that their target is gone.
+	for (AAutomatedTurret* Turret : Turrets)
+	{
+		if (Turret->GetTargetEnemy() == Enemy) Turret->SetTargetEnemy(nullptr);
+	}
+
+	if (!EnemyIndices.Contains(Enemy)) return;
+
+	RemoveIndexed(Enemies, EnemyIndices, Enemy);
+	HashFrame = MAX_uint64;
+}
+
+void UTargetingSubsystem::RemapSwarmShip(int32 OldIndex, int32 NewIndex)
+{
+	for (AAutomatedTurret* Turret : Turrets)
+	{
+		if (Turret->GetTargetSwarmShip() == OldIndex) Turret->SetTargetSwarmShip(NewIndex);
+	}
+}
+
+void UTargetingSubsystem::RegisterTurret(AAutomatedTurret* Turret)
+{
+	if (!Turret || TurretIndices.Contains(Turret)) return;
+
+	TurretIndices.Add(Turret, Turrets.Add(Turret));
+}
+
+void UTargetingSubsystem::UnregisterTurret(AAutomatedTurret* Turret)
+{
+	RemoveIndexed(Turrets, TurretIndices, Turret);
+}
+
+FIntVector UTargetingSubsystem::WorldToCell(const FVector& Location) const
+{
+	return FIntVector(FMath::FloorToInt32(Location.X / CellSize), FMath::FloorToInt32(Location.Y / CellSize), FMath::FloorToInt32(Location.Z / CellSize));
+}
+
+uint64 UTargetingSubsystem::PackCell(const FIntVector& Cell)
+{
+	// 21 bits per axis is plenty for any map at a cell size of a few thousand units.
+	constexpr uint64 Mask = (1ull << 21) - 1;
+	return (static_cast<uint64>(Cell.X) & Mask) | ((static_cast<uint64>(Cell.Y) & Mask) << 21) | ((static_cast<uint64>(Cell.Z) & Mask) << 42);
+}
+
+void UTargetingSubsystem::UpdateSpatialHash()
+{
+	if (HashFrame == GFrameCounter) return;
+	HashFrame = GFrameCounter;
+
+	SCOPE_CYCLE_COUNTER(STAT_TargetingHashBuild);
+
+	const UEnemySwarmSubsystem* Swarm = GetWorld()->GetSubsystem<UEnemySwarmSubsystem>();
+	const int32 NumSwarmShips = Swarm ? Swarm->GetNumShips() : 0;
+
+	NumHashedActors = Enemies.Num();
+	EnemyPositions.SetNum(NumHashedActors + NumSwarmShips, EAllowShrinking::No);
+	CellEntries.Reset();
+
+	for (int32 i = 0; i < NumHashedActors; i++)
+	{
+		EnemyPositions[i] = Enemies[i]->GetActorLocation();
+		CellEntries.Add({ PackCell(WorldToCell(EnemyPositions[i])), i });
+	}
+
+	// Promoted swarm ships are already registered as actors.
+	for (int32 i = 0; i < NumSwarmShips; i++)
+	{
+		const int32 Index = NumHashedActors + i;
+		EnemyPositions[Index] = Swarm->GetShipPositions()[i];
+		if (!Swarm->GetShipActor(i)) CellEntries.Add({ PackCell(WorldToCell(EnemyPositions[Index])), Index });
+	}
+
+	const int32 NumEnemies = CellEntries.Num();
+	SET_DWORD_STAT(STAT_TargetingEnemies, NumEnemies);
+
+	CellEntries.Sort([](const FCellEntry& A, const FCellEntry& B) { return A.Cell < B.Cell; });
+
+	CellRanges.Reset();
+	for (int32 Start = 0; Start < NumEnemies;)
+	{
+		int32 End = Start + 1;
+		while (End < NumEnemies && CellEntries[End].Cell == CellEntries[Start].Cell) End++;
+
+		CellRanges.Add(CellEntries[Start].Cell, FIntPoint(Start, End - Start));
+		Start = End;
+	}
+}
+
+int32 UTargetingSubsystem::FindClosestEnemyIndex(const FVector& Origin, float Range) const
+{
+	const FIntVector MinCell = WorldToCell(Origin - FVector(Range));
+	const FIntVector MaxCell = WorldToCell(Origin + FVector(Range));
+
+	int32 ClosestEnemy = INDEX_NONE;
+	double ClosestDistanceSquared = FMath::Square(static_cast<double>(Range));
+
+	for (int32 Z = MinCell.Z; Z <= MaxCell.Z; Z++)
+	{
+		for (int32 Y = MinCell.Y; Y <= MaxCell.Y; Y++)
+		{
+			for (int32 X = MinCell.X; X <= MaxCell.X; X++)
+			{
+				const FIntPoint* CellRange = CellRanges.Find(PackCell(FIntVector(X, Y, Z)));
+				if (!CellRange) continue;
+
+				for (int32 Entry = CellRange->X; Entry < CellRange->X + CellRange->Y; Entry++)
+				{
+					const int32 Enemy = CellEntries[Entry].Enemy;
+					const double DistanceSquared = FVector::DistSquared(Origin, EnemyPositions[Enemy]);
+					if (DistanceSquared < ClosestDistanceSquared)
+					{
+						ClosestDistanceSquared = DistanceSquared;
+						ClosestEnemy = Enemy;
+					}
+				}
+			}
+		}
+	}
+
+	return ClosestEnemy;
+}
+
+void UTargetingSubsystem::AssignTargets()
+{
+	UpdateSpatialHash();
+
+	SCOPE_CYCLE_COUNTER(STAT_TargetingAssign);
+	SET_DWORD_STAT(STAT_TargetingTurrets, Turrets.Num());
+
+	const int32 NumTurrets = Turrets.Num();
+	TurretOrigins.SetNum(NumTurrets, EAllowShrinking::No);
+	TurretRanges.SetNum(NumTurrets, EAllowShrinking::No);
+	TurretTargets.SetNum(NumTurrets, EAllowShrinking::No);
+
+	// Turrets that aren't built yet get a range of 0, so they never pick a target.
+	for (int32 i = 0; i < NumTurrets; i++)
+	{
+		TurretOrigins[i] = Turrets[i]->GetTargetingOrigin();
+		TurretRanges[i] = Turrets[i]->IsConstructionComplete() ? Turrets[i]->GetTargetingRange() : 0.0f;
+	}
+
+	if (!CellEntries.IsEmpty())
+	{
+		ParallelFor(NumTurrets, [this](int32 i)
+		{
+			TurretTargets[i] = TurretRanges[i] > 0.0f ? FindClosestEnemyIndex(TurretOrigins[i], TurretRanges[i]) : INDEX_NONE;
+		}, NumTurrets < MinParallelTurrets ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+	}
+	else
+	{
+		for (int32& Target : TurretTargets) Target = INDEX_NONE;
+	}
+
+	for (int32 i = 0; i < NumTurrets; i++)
+	{
+		SetTurretTarget(Turrets[i], TurretTargets[i]);
+	}
+}
+
+void UTargetingSubsystem::AssignTarget(AAutomatedTurret* Turret)
+{
+	if (!Turret->IsConstructionComplete()) return;
+
+	UpdateSpatialHash();
+
+	SetTurretTarget(Turret, FindClosestEnemyIndex(Turret->GetTargetingOrigin(), Turret->GetTargetingRange()));
+}
+
+void UTargetingSubsystem::SetTurretTarget(AAutomatedTurret* Turret, int32 Index) const
+{
+	if (Index == INDEX_NONE) Turret->SetTargetEnemy(nullptr);
+	else if (Index < NumHashedActors) Turret->SetTargetEnemy(Enemies[Index]);
+	else Turret->SetTargetSwarmShip(Index - NumHashedActors);
+}
+
+AActor* UTargetingSubsystem::ResolveEnemy(int32 Index)
+{
+	if (Index == INDEX_NONE) return nullptr;
+	if (Index < NumHashedActors) return Enemies[Index];
+
+	UEnemySwarmSubsystem* Swarm = GetWorld()->GetSubsystem<UEnemySwarmSubsystem>();
+	return Swarm ? Swarm->PromoteShip(Index - NumHashedActors) : nullptr;
+}
+
+AActor* UTargetingSubsystem::FindClosestEnemy(FVector Origin, float Range)
+{
+	UpdateSpatialHash();
+
+	return ResolveEnemy(FindClosestEnemyIndex(Origin, Range));
+}
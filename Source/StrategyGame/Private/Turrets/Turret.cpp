@@ -11,7 +11,7 @@
 ATurret::ATurret()
 {
 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bCanEverTick = false;
 
 	TurretMesh = CreateDefaultSubobject<UStaticMeshComponent>("Turret Mesh");
 	TurretMesh->SetupAttachment(StaticMeshComponent);
@@ -69,10 +69,3 @@ void ATurret::Reload()
 {
 	ShootingComponent->StartReload();
 }
-
-// Called every frame
-void ATurret::Tick(float DeltaTime)
-{
-	Super::Tick(DeltaTime);
-}
-
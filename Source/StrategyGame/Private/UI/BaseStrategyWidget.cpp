@@ -15,8 +15,8 @@ void UBaseStrategyWidget::NativeConstruct()
 	if (GetStrategyGameState())
 	{
 		GetStrategyGameState()->OnResourcesChanged.AddUniqueDynamic(this, &ThisClass::OnResourcesChanged);
-		GetStrategyGameState()->OnPopulationChanged.AddUniqueDynamic(this, &ThisClass::OnResourcesChanged);
-		GetStrategyGameState()->OnAssignedWorkersChanged.AddUniqueDynamic(this, &ThisClass::OnResourcesChanged);
+		GetStrategyGameState()->OnPopulationChanged.AddUniqueDynamic(this, &ThisClass::OnPopulationChanged);
+		GetStrategyGameState()->OnAssignedWorkersChanged.AddUniqueDynamic(this, &ThisClass::OnAssignedWorkersChanged);
 		GetStrategyGameState()->OnSkyscraperModuleAdded.AddUniqueDynamic(this, &ThisClass::OnSkyscraperModuleAdded);
 	}
 }
@@ -42,19 +42,22 @@ void UBaseStrategyWidget::OnBuildableDeSelected()
 	BP_OnBuildableDeSelected();
 }
 
-void UBaseStrategyWidget::OnResourcesChanged()
+void UBaseStrategyWidget::OnResourcesChanged(int32 ChangedResourceMask)
 {
+	BP_OnResourceMaskChanged(ChangedResourceMask);
 	BP_OnResourcesChanged();
 }
 
 void UBaseStrategyWidget::OnPopulationChanged()
 {
 	BP_OnPopulationChanged();
+	BP_OnResourcesChanged();
 }
 
 void UBaseStrategyWidget::OnAssignedWorkersChanged()
 {
 	BP_OnAssignedWorkersChanged();
+	BP_OnResourcesChanged();
 }
 
 void UBaseStrategyWidget::OnStructureBuilt(AStructure* BuiltStructure)
@@ -0,0 +1,139 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "BuildGridSubsystem.generated.h"
+
+// What occupies a cell of the build grid. A cell can hold more than one layer.
+UENUM(BlueprintType, meta=(Bitflags, UseEnumValuesAsMaskValuesInEditor="true"))
+enum class EBuildGridLayer : uint8
+{
+	None			= 0 UMETA(Hidden),
+	Building		= 1 << 0,
+	ExclusionZone	= 1 << 1,
+	Road			= 1 << 2,
+};
+ENUM_CLASS_FLAGS(EBuildGridLayer);
+
+// World level occupancy map on the structure snapping grid.
+// Cells are stored in 64x64 chunks as one bitset row per layer plus the owner of each cell, so checking if a building
+// fits is a handful of mask tests over its footprint instead of physics overlaps against every other building.
+// Stamps can overlap, such as crossing roads or exclusion zones, so every cell counts how many stamps cover it.
+UCLASS()
+class STRATEGYGAME_API UBuildGridSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	static constexpr int32 ChunkSize = 64;
+	static constexpr int32 NumLayers = 3;
+
+	struct FChunk
+	{
+		// One row of cells per entry, bit X is set if the cell at X is occupied by any layer.
+		uint64 Occupied[ChunkSize] = {};
+
+		// Same as Occupied, split up by EBuildGridLayer.
+		uint64 Layers[NumLayers][ChunkSize] = {};
+
+		// Number of stamps covering each cell, per layer. The layer's bit is set while it's above 0. Indexed by Y * ChunkSize + X.
+		uint16 Counts[NumLayers][ChunkSize * ChunkSize] = {};
+
+		// Unique ID of the only actor stamping each cell, 0 if it's empty or SharedCell if more than one actor stamps it.
+		uint32 Owners[ChunkSize * ChunkSize] = {};
+
+		// Every stamp with a rect in this chunk, to work out who owns the cells where stamps overlap.
+		TArray<uint32> StampIDs;
+
+		// Number of occupied cells, the chunk is freed once it reaches 0.
+		int32 NumOccupied = 0;
+	};
+
+	struct FStamp
+	{
+		TWeakObjectPtr<AActor> Actor;
+		EBuildGridLayer Layer = EBuildGridLayer::None;
+		TArray<FIntRect> Rects;
+	};
+
+	// Owner of a cell that more than one actor has stamped. Unique IDs count up from 0, so it can't be a real one.
+	static constexpr uint32 SharedCell = MAX_uint32;
+
+	TMap<FIntPoint, TUniquePtr<FChunk>> Chunks;
+
+	// Everything stamped into the grid, keyed by the owner's unique ID, so it can be cleared again.
+	TMap<uint32, FStamp> Stamps;
+
+	// Size of a cell in world units, taken from the game mode's snapping size.
+	UPROPERTY()
+	float CellSize = 0.0f;
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	// Splits a cell rect into the parts that fall into each chunk.
+	template <typename FunctionType>
+	static void ForEachChunkSpan(const FIntRect& CellRect, FunctionType&& Function);
+
+	// Bits from X0 up to but not including X1, within a single chunk row.
+	static uint64 RowMask(int32 X0, int32 X1);
+
+	static int32 LayerIndex(EBuildGridLayer Layer);
+
+	// Calls Function with the ID and stamp of every stamp in the chunk that covers Cell.
+	template <typename FunctionType>
+	void ForEachStampAt(const FChunk& Chunk, const FIntPoint& Cell, FunctionType&& Function) const;
+
+	// The owner a cell should have given the stamps that still cover it.
+	uint32 ResolveOwner(const FChunk& Chunk, const FIntPoint& Cell) const;
+
+	void SetCells(const FIntRect& CellRect, EBuildGridLayer Layer, uint32 Owner);
+	void ClearCells(const FIntRect& CellRect, EBuildGridLayer Layer, uint32 Owner);
+
+public:
+
+	// Stamps every built buildable that was already placed in the level. Exclusion zones stamp themselves.
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	virtual void Deinitialize() override;
+
+	// ------ CELLS ------
+
+	float GetCellSize();
+
+	FIntPoint WorldToCell(const FVector& WorldLocation);
+
+	// Converts a world space box into the cells it covers. Inset shrinks the box first, so boxes sitting exactly on cell borders don't spill over.
+	FIntRect WorldBoxToCellRect(const FBox& WorldBox, float Inset = 0.0f);
+
+	// Fills OutCells with every cell on the line between two cells.
+	static void RasterizeLine(FIntPoint From, FIntPoint To, TArray<FIntPoint>& OutCells);
+
+	// ------ STAMPING ------
+
+	// Marks the cells as occupied by Owner. Any cells Owner already had stamped are cleared first.
+	void Stamp(AActor* Owner, EBuildGridLayer Layer, const TArray<FIntRect>& CellRects);
+
+	void StampRect(AActor* Owner, EBuildGridLayer Layer, const FIntRect& CellRect) { Stamp(Owner, Layer, { CellRect }); }
+
+	// Clears every cell stamped by Owner.
+	void Unstamp(AActor* Owner);
+
+	bool IsStamped(AActor* Owner) const { return Owner && Stamps.Contains(Owner->GetUniqueID()); }
+
+	// ------ QUERIES ------
+
+	// Returns true if no cell in the rect is occupied by anything other than IgnoredOwner, on any of the layers in LayerMask.
+	bool IsAreaFree(const FIntRect& CellRect, EBuildGridLayer LayerMask, const AActor* IgnoredOwner = nullptr) const;
+
+	// Fills OutOwners with every actor occupying a cell in the rect on any of the layers in LayerMask.
+	void GetOwnersInArea(const FIntRect& CellRect, EBuildGridLayer LayerMask, TArray<AActor*>& OutOwners) const;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Build Grid")
+	bool IsCellOccupied(FIntPoint Cell, UPARAM(meta=(Bitmask, BitmaskEnum="/Script/StrategyGame.EBuildGridLayer")) int32 LayerMask) const
+	{
+		return !IsAreaFree(FIntRect(Cell, Cell + FIntPoint(1, 1)), static_cast<EBuildGridLayer>(LayerMask));
+	}
+};
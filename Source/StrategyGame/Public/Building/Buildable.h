@@ -8,6 +8,7 @@
 #include "Game/StrategyGameState.h"
 #include "ResourceNode.h"
 #include "Interfaces/BuildingInterface.h"
+#include "Building/BuildGridSubsystem.h"
 #include "Buildable.generated.h"
 
 class UArrowComponent;
@@ -60,9 +61,6 @@ protected:
 	UPROPERTY(BlueprintGetter=GetBuildableState)
 	EBuildableState BuildableState = EBuildableState::ConstructionComplete;
 	
-	UPROPERTY() TArray<AActor*> OverlappingExclusionZones;
-	UPROPERTY() TArray<AActor*> OverlappingResourceNodes;
-	UPROPERTY() TArray<AActor*> OverlappingRoads;
 	UPROPERTY() AResourceNode* TargetResourceNode;
 
 	// ------ CONSTRUCTION ------
@@ -70,6 +68,10 @@ protected:
 	UPROPERTY()
 	FTimerHandle ConstructionTimer;
 
+	// The simulation speed the construction timer was last set for, used to rescale it when the time scale changes.
+	UPROPERTY()
+	float ConstructionTimerSpeed = 1.0f;
+
 	// How long it takes for the structure to be built.
 	UPROPERTY(EditDefaultsOnly, Category="Buildable|Construction")
 	float TimeToCompleteConstruction = 3.0f;
@@ -84,6 +86,9 @@ protected:
 	UPROPERTY()
 	UMaterialInterface* DefaultMaterial;	
 
+	// The build grid cells the buildable covered the last time it was moved, used to only update materials when they change.
+	TArray<FIntRect> LastBuildGridFootprint;
+
 	UPROPERTY(EditDefaultsOnly, Category="Buildable|Construction|Materials")
 	UMaterialInstance* CanBuildMaterial;
 
@@ -101,13 +106,9 @@ protected:
 
 	virtual void OnConstruction(const FTransform& Transform) override;
 
-	virtual void BeginDestroy() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
-	UFUNCTION()
-	virtual void OnOverlapBegin(UPrimitiveComponent* OverlappedComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
-	
-	UFUNCTION()
-	virtual void OnOverlapEnd(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex);
+	virtual void BeginDestroy() override;
 
 public:
 	
@@ -130,6 +131,8 @@ public:
 
 	virtual bool GetIsConstructionComplete_Implementation() override;
 	virtual bool Recycle_Implementation(ARTSCamera* RecycleInstigator) override;
+	virtual void OnAcquiredFromPool_Implementation() override;
+	virtual void OnReturnedToPool_Implementation() override;
 
 	UFUNCTION(BlueprintCallable)
 	virtual void MoveBuilding(FVector NewLocation);
@@ -137,14 +140,32 @@ public:
 	UFUNCTION(BlueprintCallable)
 	virtual void PlaceBuilding();
 	
-	// Function to be called when the building is placed.
+	// Function to be called when the building is placed. Returns false if the construction cost couldn't be paid.
+	UFUNCTION(BlueprintCallable)
+	bool BeginConstruction();
+
+	// Starts building once the construction cost has been paid.
+	// Override this rather than BeginConstruction so batches of buildings can be paid for with a single ledger update.
+	virtual void StartConstruction();
+
+	// Pays for every buildable in the array in one transaction, then starts building all of them.
+	// Returns false and starts none of them if the combined cost can't be paid.
 	UFUNCTION(BlueprintCallable)
-	virtual void BeginConstruction();
+	static bool PlaceBuildables(const TArray<ABuildable*>& Buildables);
 	
 	// If the structure is being built, cancels it and gets the materials back.
 	UFUNCTION(BlueprintCallable)
 	virtual void CancelConstruction();
-	void ConsumeConstructionResources();
+
+	// Pays the whole construction cost in one transaction. Returns false and pays nothing if any resource is short.
+	bool ConsumeConstructionResources();
+
+	// Returns true if the construction cost could be paid right now.
+	bool CanAffordConstruction();
+
+	// How many times ConstructionCost is paid, for buildables like roads that are priced per segment.
+	virtual int32 GetConstructionCostCount() { return 1; }
+
 	void RefundConstructionMaterials();
 	virtual void CompleteConstruction();
 
@@ -152,11 +173,35 @@ public:
 	void BP_Recycle() { Recycle(); }
 	
 	// Begins recycling the structure to destroy it and get its materials back.
-	virtual void Recycle();
+	void Recycle();
+
+	// Recycles the structure, adding its refund to Refunds instead of paying it out straight away.
+	// Override this rather than Recycle so batches of buildings can be recycled with a single ledger update.
+	virtual void RecycleInto(FResourceTransaction& Refunds);
+
+	// Recycles every buildable in the array and refunds all of them in one transaction.
+	UFUNCTION(BlueprintCallable)
+	static void RecycleBuildables(const TArray<ABuildable*>& Buildables);
 
 	// Changes the mesh material depending on if the structure is being placed, is being constructed, or is unable to be built.
 	virtual void UpdateBuildMaterials();
 
+	// ------ BUILD GRID ------
+
+	UBuildGridSubsystem* GetBuildGrid() const { return GetWorld()->GetSubsystem<UBuildGridSubsystem>(); }
+
+	// The build grid cells the buildable covers at its current location.
+	virtual void GetBuildGridFootprint(TArray<FIntRect>& OutCellRects);
+
+	// The layer the buildable is stamped into once it's placed, None if it shouldn't block anything.
+	virtual EBuildGridLayer GetBuildGridLayer() const { return EBuildGridLayer::Building; }
+
+	// The layers that stop the buildable from being placed on top of them.
+	virtual EBuildGridLayer GetBuildGridBlockingLayers() const { return EBuildGridLayer::Building | EBuildGridLayer::ExclusionZone | EBuildGridLayer::Road; }
+
+	void AddToBuildGrid();
+	void RemoveFromBuildGrid();
+
 	// ------ GETTERS ------
 
 	UFUNCTION(BlueprintGetter)
@@ -183,20 +228,26 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintPure)
 	bool IsConstructionComplete() { return BuildableState == EBuildableState::ConstructionComplete; }
 
+	// Returns true if the footprint of the buildable covers any cell it isn't allowed to be built on.
+	UFUNCTION(BlueprintCallable, BlueprintPure)
+	bool IsOverlappingBuildExclusionZone();
+
+	// True if the buildable is in range of a resource node it can extract from.
 	UFUNCTION(BlueprintCallable, BlueprintPure)
-	bool IsOverlappingBuildExclusionZone() { return !OverlappingExclusionZones.IsEmpty(); }
+	virtual bool IsOverlappingResourceNode() { return false; }
 
 	UFUNCTION(BlueprintCallable, BlueprintPure)
-	bool IsOverlappingResourceNode() { return !OverlappingResourceNodes.IsEmpty(); }
+	AResourceNode* GetTargetResourceNode() { return TargetResourceNode; }
 
+	// True if a built road runs along or through the footprint.
 	UFUNCTION(BlueprintCallable, BlueprintPure)
-	bool IsConnectedToRoad() { return !OverlappingRoads.IsEmpty(); }
+	bool IsConnectedToRoad();
 
 	UFUNCTION(BlueprintCallable, BlueprintPure)
 	virtual bool IsBuildingPermitted();
 
 	UFUNCTION(BlueprintCallable, BlueprintPure)
-	TArray<AActor*> GetOverlappingBuildExclusionZones() { return OverlappingExclusionZones; }
+	TArray<AActor*> GetOverlappingBuildExclusionZones();
 
 	UFUNCTION(BlueprintCallable, BlueprintPure)
 	bool HaveEnoughResourcesToBuild();
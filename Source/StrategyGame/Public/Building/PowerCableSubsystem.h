@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "PowerCableSubsystem.generated.h"
+
+class AInstancedRenderActor;
+class APowerLine;
+class UInstancedStaticMeshComponent;
+
+USTRUCT()
+struct FPowerCable
+{
+	GENERATED_BODY()
+
+	UPROPERTY() APowerLine* PowerLineA = nullptr;
+	UPROPERTY() APowerLine* PowerLineB = nullptr;
+
+	bool bPowered = false;
+};
+
+// Draws the cables between linked power lines as stretched segments of one instanced mesh.
+// A cable's sagging segments are built once when it's added. A power line that moves drops its cables and adds new
+// ones for the links in range of its new location. The instances are only uploaded again when a cable is added,
+// removed or changes power state.
+// Each instance has one custom data float, 1 when powered and 0 when not, for the cable material to pick its colour.
+UCLASS()
+class STRATEGYGAME_API UPowerCableSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	// Every cable is drawn with the same number of segments, so cable i owns the instances from i * CableSegments.
+	static constexpr int32 CableSegments = 8;
+
+	UPROPERTY() TArray<FPowerCable> Cables;
+
+	// Indices into Cables for every power line that has a cable attached.
+	TMap<APowerLine*, TArray<int32>> PowerLineCables;
+
+	// CableSegments transforms per cable, in the same order as Cables.
+	TArray<FTransform> SegmentTransforms;
+
+	UPROPERTY() AInstancedRenderActor* RenderActor = nullptr;
+	UPROPERTY() UInstancedStaticMeshComponent* InstancedMesh = nullptr;
+
+	bool bGeometryDirty = false;
+	bool bColoursDirty = false;
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	// Creates the instanced mesh from the first power line's cable settings.
+	UInstancedStaticMeshComponent* GetInstancedMesh(const APowerLine* PowerLine);
+
+	void BuildCableSegments(int32 CableIndex);
+
+	// Swap-removes the cable and its segments, fixing up the indices of the cable that moved into its place.
+	void RemoveCableAt(int32 CableIndex);
+
+	void UploadInstances();
+
+public:
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	virtual void Deinitialize() override;
+
+	// Adds a cable between the two power lines, unless they already have one.
+	void AddCable(APowerLine* PowerLineA, APowerLine* PowerLineB);
+
+	// Removes every cable attached to the power line.
+	void RemoveCables(APowerLine* PowerLine);
+
+	// Reads the power line's power state again and recolours its cables if it changed.
+	void UpdateCableColours(APowerLine* PowerLine);
+
+	// ------ GETTERS ------
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Power")
+	int32 GetNumCables() const { return Cables.Num(); }
+};
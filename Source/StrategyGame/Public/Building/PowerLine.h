@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "Buildable.h"
+#include "Components/SphereComponent.h"
 #include "Interfaces/PowerInterface.h"
 #include "PowerLine.generated.h"
 
@@ -18,43 +19,76 @@ public:
 
 protected:
 
+	// Shows how far the power line reaches. Links are worked out by the power network subsystem, not by overlaps.
 	UPROPERTY(EditAnywhere)
 	USphereComponent* Sphere;
 
+	// Where cables attach to the power line.
 	UPROPERTY(EditAnywhere)
 	UArrowComponent* PowerLineArrow;
 
-	// The power line that is supplying this power line.
-	UPROPERTY() AActor* PowerFeeder = nullptr;
-	// The power line that this power line is sending power to.
-	UPROPERTY() APowerLine* PowerTarget = nullptr;
-	
+	// Set by the power network subsystem.
 	UPROPERTY() bool ConnectedToPower = false;
+
+	// ------ CABLES ------
+
+	// Stretched along X to draw each cable segment. Expected to be CableMeshSize units across, like the engine's cube.
+	UPROPERTY(EditDefaultsOnly, BlueprintGetter=GetCableMesh, Category="Cables")
+	UStaticMesh* CableMesh = nullptr;
+
+	// Should read PerInstanceCustomData 0, which is 1 for powered cables and 0 for unpowered ones.
+	UPROPERTY(EditDefaultsOnly, Category="Cables")
+	UMaterialInterface* CableMaterial = nullptr;
+
+	UPROPERTY(EditDefaultsOnly, Category="Cables")
+	float CableThickness = 50.0f;
+
+	// How far the middle of a cable hangs below its ends, as a fraction of its length.
+	UPROPERTY(EditDefaultsOnly, Category="Cables")
+	float CableSag = 0.05f;
+
+	// Adds this power line to the power network and runs cables to the power lines it links to.
+	void JoinPowerNetwork();
+	void LeavePowerNetwork();
+
+	// A built power line that gets moved has to be linked again.
+	void OnPowerLineMoved(USceneComponent* UpdatedComponent, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
 	
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	virtual void OnOverlapBegin(UPrimitiveComponent* OverlappedComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult) override;
 	virtual void OnOverlapEnd(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex) override;
 
-	UFUNCTION() void OnPowerOverlapBegin(UPrimitiveComponent* OverlappedComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
-	UFUNCTION() void OnPowerOverlapEnd(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex);
-
 public:
 
 	virtual bool ConnectPower_Implementation(APowerLine* PowerLine) override;
 	virtual bool DisconnectPower_Implementation(APowerLine* PowerLine) override;
 	virtual bool GetIsConnectedToPowerSource_Implementation() override;
-	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
+	virtual float GetPowerGeneration_Implementation() override { return 0.0f; }
+	virtual float GetPowerConsumption_Implementation() override { return 0.0f; }
+	virtual float GetPowerConnectionRadius_Implementation() override;
+	virtual void OnPowerNetworkChanged_Implementation(bool bConnectedToPowerSource, float Satisfaction) override;
+
+	virtual void OnReturnedToPool_Implementation() override;
 
-	UFUNCTION(BlueprintCallable, Category="Power")
-	void SetPowerFeeder(AActor* NewPowerFeeder) { if (!PowerFeeder) PowerFeeder = NewPowerFeeder; }
+	virtual void CompleteConstruction() override;
 
-	UFUNCTION(BlueprintCallable, Category="Power")
-	void ClearPowerFeeder() { PowerFeeder = nullptr; }
+	static constexpr float CableMeshSize = 100.0f;
 
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Power")
 	bool IsConnectedToPower() { return ConnectedToPower; }
+
+	// ------ GETTERS ------
+
+	UFUNCTION(BlueprintGetter)
+	UStaticMesh* GetCableMesh() const { return CableMesh; }
+
+	UMaterialInterface* GetCableMaterial() const { return CableMaterial; }
+	float GetCableThickness() const { return CableThickness; }
+	float GetCableSag() const { return CableSag; }
+
+	FVector GetCableAttachLocation() const { return PowerLineArrow->GetComponentLocation(); }
 };
@@ -7,6 +7,9 @@
 #include "Components/SplineMeshComponent.h"
 #include "Road.generated.h"
 
+// A road drawn as a polyline. Every click adds a point and clicking the last point again builds the road.
+// Points that carry on in the same direction extend the last segment instead of adding one, and the road is split
+// into chunks of at most MaxSegmentsPerRoad segments, each one actor with one spline mesh per segment.
 UCLASS()
 class STRATEGYGAME_API ARoad : public ABuildable
 {
@@ -18,25 +21,77 @@ public:
 
 protected:
 
+	// The first segment. The other segments are copies of it made at runtime.
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	USplineMeshComponent* SplineMesh = nullptr;
 
-	UPROPERTY() FVector RoadStartPos = FVector::ZeroVector;
+	UPROPERTY() TArray<USplineMeshComponent*> SegmentMeshes;
+
+	// The collision SplineMesh was set up with, given to segments while they're in use.
+	TEnumAsByte<ECollisionEnabled::Type> SegmentCollision = ECollisionEnabled::QueryAndPhysics;
+
+	// The points along the road. While drawing, only the points that have been clicked.
+	UPROPERTY() TArray<FVector> RoadPoints;
+
+	// Where the segment being drawn ends, following the cursor.
 	UPROPERTY() FVector RoadEndPos = FVector::ZeroVector;
+
+	// Bounds how many spline meshes, and so draw calls, a single road actor can have.
+	UPROPERTY(EditDefaultsOnly, Category="Road", meta=(ClampMin=1))
+	int32 MaxSegmentsPerRoad = 16;
 	
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Adds a point to the road being drawn, or moves the last one if the road carries on in a straight line.
+	void AddRoadPoint(const FVector& Point);
+
+	// The points of every segment, including the one following the cursor while drawing.
+	void GetRoadPolyline(TArray<FVector>& OutPoints);
+
+	USplineMeshComponent* GetSegmentMesh(int32 SegmentIndex);
+
+	// Fits the spline meshes from FirstSegment on to the polyline, and hides the ones that aren't needed.
+	void UpdateSegmentMeshes(int32 FirstSegment = 0);
+
 public:
 
 	virtual void MoveBuilding(FVector NewLocation) override;
 
+	// Adds a point to the road, or builds it if the last point is clicked again.
 	virtual void PlaceBuilding() override;
 
+	// Builds the road drawn so far, split into chunks, and starts a new one.
+	UFUNCTION(BlueprintCallable, Category="Road")
+	void FinishRoad();
+
+	// Replaces the points of the road and moves it to the first one.
+	void SetRoadPoints(TArrayView<const FVector> NewPoints);
+
 	virtual void UpdateBuildMaterials() override;
-	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
 
-	
+	// Forgets the points of the road, so the next use starts a new one.
+	virtual void OnReturnedToPool_Implementation() override;
+
+	// Adds the road to the road network.
+	virtual void CompleteConstruction() override;
+
+	// Roads cost their construction cost once per segment.
+	virtual int32 GetConstructionCostCount() override;
+
+	// Every build grid cell along the road, from start to end. Just the cell under the road if it hasn't been started yet.
+	void GetRoadCells(TArray<FIntPoint>& OutCells);
+
+	// Every cell along the road, or just the cell under the road if it hasn't been started yet.
+	virtual void GetBuildGridFootprint(TArray<FIntRect>& OutCellRects) override;
+
+	virtual EBuildGridLayer GetBuildGridLayer() const override { return EBuildGridLayer::Road; }
+
+	// Roads can cross and join other roads.
+	virtual EBuildGridLayer GetBuildGridBlockingLayers() const override { return EBuildGridLayer::Building | EBuildGridLayer::ExclusionZone; }
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Road")
+	int32 GetNumRoadSegments() const { return FMath::Max(RoadPoints.Num() - 1, 0); }
 };
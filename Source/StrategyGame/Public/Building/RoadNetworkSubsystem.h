@@ -0,0 +1,148 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "RoadNetworkSubsystem.generated.h"
+
+class ABuildable;
+class ARoad;
+
+// Keeps the built roads as a graph of build grid cells, linked along each road.
+// Roads that cross or meet on a cell share its node, which is how they join up.
+// Connected roads are tracked with union-find, so connectivity checks are close to O(1). Recycling a road
+// only relabels the components it was part of. Paths are found with A* and cached, and a component's cached paths
+// are dropped whenever a road is built into it or recycled out of it.
+UCLASS()
+class STRATEGYGAME_API URoadNetworkSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	struct FRoadNode
+	{
+		FIntPoint Cell = FIntPoint::ZeroValue;
+
+		// Number of roads covering the cell. The node is removed once it reaches 0.
+		int32 RoadCount = 0;
+
+		// Neighbouring nodes, once per road linking them.
+		TArray<int32> Links;
+
+		// Union-find. Size and Epoch are only meaningful on the root.
+		mutable int32 Parent = INDEX_NONE;
+		int32 Size = 1;
+
+		// Changes whenever the component changes, so cached paths know they're out of date.
+		uint32 Epoch = 0;
+
+		// Scratch for searches.
+		uint32 SearchStamp = 0;
+		float PathCost = 0.0f;
+		int32 CameFrom = INDEX_NONE;
+		bool bClosed = false;
+	};
+
+	struct FCachedRoadPath
+	{
+		TArray<FIntPoint> Cells;
+		uint32 Epoch = 0;
+	};
+
+	struct FOpenNode
+	{
+		float Estimate;
+		int32 Node;
+	};
+
+	TArray<FRoadNode> Nodes;
+	TMap<FIntPoint, int32> NodeIndices;
+	TArray<int32> FreeNodes;
+
+	// The cells each registered road covers, in order along the road.
+	TMap<ARoad*, TArray<FIntPoint>> RoadCells;
+
+	uint32 EpochCounter = 0;
+	uint32 SearchStamp = 0;
+
+	TMap<TPair<FIntPoint, FIntPoint>, FCachedRoadPath> PathCache;
+
+	// The cache is cleared once it holds this many paths.
+	int32 MaxCachedPaths = 512;
+
+	// Scratch for searches.
+	TArray<FOpenNode> OpenSet;
+	TArray<int32> SearchQueue;
+
+	// The building everything else is checked against by IsConnectedToCityCore.
+	UPROPERTY() ABuildable* CityCore = nullptr;
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	// Returns the node for the cell, adding it if no road covered it yet.
+	int32 AddRoadToCell(const FIntPoint& Cell);
+
+	int32 FindRoot(int32 NodeIndex) const;
+	void Union(int32 NodeA, int32 NodeB);
+
+	// Gives every node reachable from the seeds a fresh root, for after a road is removed.
+	void RelabelComponents(const TArray<int32>& Seeds);
+
+	bool SearchPath(int32 StartNode, int32 GoalNode, TArray<FIntPoint>& OutCells);
+
+	// Roots of every road node that touches the building's footprint.
+	void GetAdjacentRoots(ABuildable* Building, TArray<int32>& OutRoots);
+
+public:
+
+	virtual void Deinitialize() override;
+
+	// Registers every road that was already built when the level loaded.
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	UFUNCTION(BlueprintCallable, Category="Roads")
+	void RegisterRoad(ARoad* Road);
+
+	UFUNCTION(BlueprintCallable, Category="Roads")
+	void UnregisterRoad(ARoad* Road);
+
+	UFUNCTION(BlueprintCallable, Category="Roads")
+	void SetCityCore(ABuildable* NewCityCore) { CityCore = NewCityCore; }
+
+	// Finds the shortest path along roads between two road cells. Returns false if they aren't connected.
+	bool FindPath(const FIntPoint& StartCell, const FIntPoint& GoalCell, TArray<FIntPoint>& OutCells);
+
+	// Finds the shortest path along roads between the road cells under two world locations, as cell centres.
+	UFUNCTION(BlueprintCallable, Category="Roads")
+	bool FindRoadPath(FVector Start, FVector End, TArray<FVector>& OutPath);
+
+	// ------ GETTERS ------
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Roads")
+	bool IsRoadCell(FIntPoint Cell) const { return NodeIndices.Contains(Cell); }
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Roads")
+	bool AreCellsConnected(FIntPoint CellA, FIntPoint CellB) const;
+
+	// True if a road runs along or through the building's footprint.
+	UFUNCTION(BlueprintCallable, Category="Roads")
+	bool IsBuildingConnectedToRoad(ABuildable* Building);
+
+	// True if a road touching one building leads to a road touching the other.
+	UFUNCTION(BlueprintCallable, Category="Roads")
+	bool AreBuildingsConnected(ABuildable* BuildingA, ABuildable* BuildingB);
+
+	UFUNCTION(BlueprintCallable, Category="Roads")
+	bool IsConnectedToCityCore(ABuildable* Building) { return CityCore && AreBuildingsConnected(Building, CityCore); }
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Roads")
+	ABuildable* GetCityCore() const { return CityCore; }
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Roads")
+	int32 GetNumRoads() const { return RoadCells.Num(); }
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Roads")
+	int32 GetNumRoadCells() const { return NodeIndices.Num(); }
+};
@@ -37,10 +37,8 @@ public:
 	UFUNCTION(BlueprintCallable, Category="Skyscraper")
 	void AddModule(TSubclassOf<ASkyscraperModule> ModuleToAdd);
 
-	virtual void Recycle() override;
+	virtual void RecycleInto(FResourceTransaction& Refunds) override;
 	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
 
 	// ------ GETTERS ------
 
@@ -38,12 +38,12 @@ public:
 	virtual bool Select_Implementation(ARTSCamera* SelectInstigator) override;
 	virtual bool Recycle_Implementation(ARTSCamera* DestroyInstigator) override;
 
+	// Modules sit on top of their skyscraper, which already covers the cells underneath.
+	virtual EBuildGridLayer GetBuildGridLayer() const override { return EBuildGridLayer::None; }
+
 	UFUNCTION(BlueprintCallable)
 	void SwitchToTopMesh();
 
 	UFUNCTION(BlueprintCallable)
 	void SwitchToDefaultMesh();
-	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
 };
@@ -6,6 +6,7 @@
 #include "Buildable.h"
 #include "Components/TextRenderComponent.h"
 #include "DataTables/StructureData.h"
+#include "DataTables/StructureDescriptor.h"
 #include "Interfaces/PowerInterface.h"
 #include "Structure.generated.h"
 
@@ -15,6 +16,8 @@ class STRATEGYGAME_API AStructure : public ABuildable, public IPowerInterface
 {
 	GENERATED_BODY()
 
+	friend class UStructureRegistrySubsystem;
+
 public:
 	// Sets default values for this actor's properties
 	AStructure();
@@ -24,60 +27,98 @@ protected:
 	UPROPERTY(EditAnywhere)
 	UTextRenderComponent* StructureText;
 
-	UPROPERTY() FTimerHandle ResourceGenerationTimer;
-	UPROPERTY() FTimerHandle ResourceConsumptionTimer;
-	UPROPERTY() FTimerHandle ResourceDrainingTimer;
-
 	// ------ STRUCTURE DATA ------
 
 	UPROPERTY(EditDefaultsOnly, Category="Structure Data")
 	FDataTableRowHandle StructureDataTableRow;
+
+	// Flattened copy of StructureDataTableRow, resolved the first time it's needed and shared between structures using the same row.
+	TSharedPtr<const FStructureDescriptor> StructureDescriptor;
+
+	// Resolves StructureDescriptor from the data table. Only runs once per structure.
+	const FStructureDescriptor& ResolveStructureDescriptor();
 	
-	UPROPERTY() TMap<ECitizenType, int32> AssignedWorkers;
+	// Set by the structure registry while the structure is registered.
+	UPROPERTY() FStructureHandle StructureHandle;
+
+	// Number of assigned citizens, indexed by ECitizenType.
+	int32 AssignedWorkers[NumCitizenTypes] = {};
+
+	// Set while the structure's effects on the economy and population are applied, so they're only reverted once.
+	bool bStructureEffectsActive = false;
 	
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	virtual void OnConstruction(const FTransform& Transform) override;
-	
-	virtual void OnOverlapBegin(UPrimitiveComponent* OverlappedComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult) override;
-	virtual void OnOverlapEnd(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex) override;
+
+	// Frees the node the structure was extracting from, so another extractor can be built on it.
+	void ReleaseResourceNode();
+
+	// Takes the structure out of the economy, registry, power network and labels, when it's destroyed or pooled.
+	void RemoveFromWorldSystems();
 
 public:
 
 	// ------ INTERFACE FUNCTIONS ------
 	
 	virtual bool Select_Implementation(ARTSCamera* SelectInstigator) override;
+	virtual void OnAcquiredFromPool_Implementation() override;
+	virtual void OnReturnedToPool_Implementation() override;
+
+	virtual bool ConnectPower_Implementation(APowerLine* PowerLine) override;
+	virtual bool DisconnectPower_Implementation(APowerLine* PowerLine) override;
+	virtual bool GetIsConnectedToPowerSource_Implementation() override;
+	virtual float GetPowerGeneration_Implementation() override { return GetStructureDescriptor().GetGenerationRate(EResourceType::Power); }
+	virtual float GetPowerConsumption_Implementation() override { return GetStructureDescriptor().GetConsumptionRate(EResourceType::Power); }
+	virtual float GetPowerConnectionRadius_Implementation() override;
+	virtual void OnPowerNetworkChanged_Implementation(bool bConnectedToPowerSource, float Satisfaction) override {}
 
 	UFUNCTION(BlueprintCallable)
 	void ActivateStructureEffects();
 
+	// Undoes ActivateStructureEffects: lets the workers go and takes back the storage and population capacity.
+	// Called when the structure is recycled, destroyed or returned to its pool. Does nothing if the effects aren't active.
 	UFUNCTION(BlueprintCallable)
-	AResourceNode* FindClosestResourceNode();
+	void DeactivateStructureEffects();
 
+	// Finds the closest node in range of the structure with a resource it consumes, through the resource field.
+	UFUNCTION(BlueprintCallable)
+	AResourceNode* FindClosestResourceNode(bool bUnassignedOnly = true);
+
+	virtual bool IsOverlappingResourceNode() override { return FindClosestResourceNode(false) != nullptr; }
+
+	// Returns false if the construction cost couldn't be paid, in which case nothing was built.
 	UFUNCTION(BlueprintCallable, DisplayName="BeginConstruction")
-	void BP_BeginConstruction() { BeginConstruction(); }
+	bool BP_BeginConstruction() { return BeginConstruction(); }
 	
-	virtual void BeginConstruction() override;
+	virtual void StartConstruction() override;
 	virtual void CompleteConstruction() override;
 	
-	virtual void Recycle() override;
+	virtual void RecycleInto(FResourceTransaction& Refunds) override;
 
 	// If the structure increases storage capacity, this function will revert that.
-	// Used for when the structure is destroyed.
+	// Part of DeactivateStructureEffects, which should be used instead.
 	void RevertStorageCapacity();
 
+	// Registers the structure with the economy subsystem, which generates its resources every economy step.
 	UFUNCTION(BlueprintCallable)
 	void BeginGeneratingResources();
-	void GenerateResources();
 
+	// Registers the structure with the economy subsystem, which consumes its resources every economy step.
 	UFUNCTION(BlueprintCallable)
 	void BeginConsumingResources();
-	void ConsumeResources();
-	
+
+	// Registers the structure with the economy subsystem, which drains its resource node every economy step.
 	UFUNCTION(BlueprintCallable)
 	void BeginDrainingResourceFromNode();
-	void DrainResourceFromNode();
+
+	// Assigns the structure to the closest free node in range, for when its node has been used up.
+	// The resource field drains the node and credits what's extracted.
+	UFUNCTION(BlueprintCallable)
+	bool AcquireResourceNode();
 	
 	UFUNCTION(BlueprintCallable)
 	void AssignWorkers(ECitizenType WorkerType, int32 Amount);
@@ -90,9 +131,9 @@ public:
 	void RemoveAllWorkers(ECitizenType WorkerType);
 
 	virtual void UpdateBuildMaterials() override;
-	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
+
+	// Points the structure at a different data table row. Has to be called before the structure's effects are activated.
+	void SetStructureDataTableRow(const FDataTableRowHandle& NewRow) { StructureDataTableRow = NewRow; StructureDescriptor.Reset(); }
 
 	
 	// ------ GETTERS ------
@@ -101,48 +142,57 @@ public:
     UFUNCTION(BlueprintCallable, BlueprintPure, DisplayName="IsBuildingPermitted")
     bool BP_IsBuildingPermitted() { return IsBuildingPermitted(); }
 	
+	const FStructureDescriptor& GetStructureDescriptor() { return StructureDescriptor ? *StructureDescriptor : ResolveStructureDescriptor(); }
+
+	// Looks the row up in the data table, so it's never left pointing at a row that was reimported.
 	const FStructureData* GetStructureData();
 	UFUNCTION(BlueprintCallable, BlueprintPure, DisplayName="GetStructureData")
 	FStructureData BP_GetStructureData() { return *GetStructureData();}
 
 	UFUNCTION(BlueprintCallable, BlueprintPure)
-	bool GetGeneratesResources() { return GetStructureData()->bGeneratesResources; }
+	FStructureHandle GetStructureHandle() { return StructureHandle; }
+
+	UFUNCTION(BlueprintCallable, BlueprintPure)
+	bool GetGeneratesResources() { return GetStructureDescriptor().HasFlag(EStructureFlags::GeneratesResources); }
 
 	UFUNCTION(BlueprintCallable, BlueprintPure)
-	bool GetConsumesResources() { return GetStructureData()->bConsumesResources; }
+	bool GetConsumesResources() { return GetStructureDescriptor().HasFlag(EStructureFlags::ConsumesResources); }
 
 	UFUNCTION(BlueprintCallable, BlueprintPure)
-	bool GetConsumesResourcesFromNearbyNode() { return GetStructureData()->bConsumesResourceFromNearbyNode; }
+	bool GetConsumesResourcesFromNearbyNode() { return GetStructureDescriptor().HasFlag(EStructureFlags::ConsumesResourceFromNearbyNode); }
 
 	UFUNCTION(BlueprintCallable, BlueprintPure)
-	bool GetIncreasesStorageCapacity() { return GetStructureData()->bIncreasesStorageCapacity; }
+	bool GetIncreasesStorageCapacity() { return GetStructureDescriptor().HasFlag(EStructureFlags::IncreasesStorageCapacity); }
 
+	// Returns a copy of the row's map, use GetStructureDescriptor() from C++ instead.
 	UFUNCTION(BlueprintCallable, BlueprintPure)
 	TMap<EResourceType, float> GetResourcesToGeneratePerSecond() { return GetStructureData()->ResourcesToGeneratePerSecond; }
 
+	// Returns a copy of the row's map, use GetStructureDescriptor() from C++ instead.
 	UFUNCTION(BlueprintCallable, BlueprintPure)
 	TMap<EResourceType, float> GetResourcesToConsumePerSecond() { return GetStructureData()->ResourcesToConsumePerSecond; }
 
+	// Returns a copy of the row's map, use GetStructureDescriptor() from C++ instead.
 	UFUNCTION(BlueprintCallable, BlueprintPure)
 	TMap<EResourceType, int32> GetResourcesToIncreaseStorage() { return GetStructureData()->ResourcesToIncreaseStorage; }
 
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Population")
-	bool DoesIncreasePopulationCapacity() { return GetStructureData()->AdditionalPopulationCapacity > 0; }
+	bool DoesIncreasePopulationCapacity() { return GetStructureDescriptor().HasFlag(EStructureFlags::IncreasesPopulationCapacity); }
 
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Population")
-	int32 GetAdditionalPopulationCapacity() { return GetStructureData()->AdditionalPopulationCapacity; }
+	int32 GetAdditionalPopulationCapacity() { return GetStructureDescriptor().AdditionalPopulationCapacity; }
 
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Workers")
-	bool GetAllowWorkerEmployment() { return GetStructureData()->bAllowWorkerEmployment; }
+	bool GetAllowWorkerEmployment() { return GetStructureDescriptor().HasFlag(EStructureFlags::AllowWorkerEmployment); }
 
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Workers")
-	bool GetAllowScientistEmployment() { return GetStructureData()->bAllowScientistEmployment; }
+	bool GetAllowScientistEmployment() { return GetStructureDescriptor().HasFlag(EStructureFlags::AllowScientistEmployment); }
 
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Workers")
-	int32 GetWorkerCount(ECitizenType WorkerType) { return AssignedWorkers.FindRef(WorkerType); }
+	int32 GetWorkerCount(ECitizenType WorkerType) { return WorkerType < ECitizenType::MAX ? AssignedWorkers[static_cast<int32>(WorkerType)] : 0; }
 
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Workers")
-	int32 GetMaxWorkerCapacity() { return GetStructureData()->MaxWorkerCapacity; }
+	int32 GetMaxWorkerCapacity() { return GetStructureDescriptor().MaxWorkerCapacity; }
 
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Workers")
 	int32 GetTotalWorkers() { return GetWorkerCount(ECitizenType::Worker) + GetWorkerCount(ECitizenType::Scientist); }
@@ -155,5 +205,10 @@ public:
 
 	// Returns a value between 0 and 1 based on how many workers are assigned to the structure.
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Workers")
-	float GetWorkerEfficiency() { if (!GetAllowWorkerEmployment() && !GetAllowScientistEmployment()) return 1; return static_cast<float>(GetTotalWorkers()) / GetMaxWorkerCapacity(); }
+	float GetWorkerEfficiency()
+	{
+		const FStructureDescriptor& Descriptor = GetStructureDescriptor();
+		if (!Descriptor.HasFlag(EStructureFlags::AllowWorkerEmployment | EStructureFlags::AllowScientistEmployment)) return 1;
+		return Descriptor.MaxWorkerCapacity > 0 ? static_cast<float>(GetTotalWorkers()) / Descriptor.MaxWorkerCapacity : 0.0f;
+	}
 };
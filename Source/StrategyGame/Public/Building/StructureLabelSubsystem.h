@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "StructureLabelSubsystem.generated.h"
+
+class UTextRenderComponent;
+
+// Turns every structure's name label towards the camera in one pass, instead of each structure doing it in its own tick.
+// Labels outside the camera's view or too far away are hidden and left alone, and nothing is done while neither the camera
+// nor any label moves.
+UCLASS()
+class STRATEGYGAME_API UStructureLabelSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	UPROPERTY() TArray<UTextRenderComponent*> Labels;
+
+	// Position of each label in Labels, for swap-removes.
+	TMap<UTextRenderComponent*, int32> LabelIndices;
+
+	// Labels further than this from the camera are hidden.
+	UPROPERTY()
+	float MaxLabelDistance = 20000.0f;
+
+	// Widens the view cone used to cull labels, so labels at the edge of the screen don't pop in late.
+	UPROPERTY()
+	float ViewAngleMargin = 1.2f;
+
+	// Camera transform the labels were last updated for.
+	FVector LastCameraLocation = FVector::ZeroVector;
+	FRotator LastCameraRotation = FRotator::ZeroRotator;
+	float LastCameraFOV = 0.0f;
+
+	// Set when labels are added or moved, so they get oriented even if the camera hasn't moved.
+	bool bLabelsDirty = false;
+
+	// Set while UpdateLabels turns the labels, so their own rotation doesn't mark them dirty again.
+	bool bUpdatingLabels = false;
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	void UpdateLabels(const FVector& CameraLocation, const FRotator& CameraRotation, float CameraFOV);
+
+	// Bound to every label's TransformUpdated, which also fires when the structure or preview it's attached to moves.
+	void OnLabelMoved(USceneComponent* Label, EUpdateTransformFlags UpdateTransformFlags, ETeleportType Teleport);
+
+public:
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	virtual void Deinitialize() override;
+
+	void RegisterLabel(UTextRenderComponent* Label);
+	void UnregisterLabel(UTextRenderComponent* Label);
+
+	// ------ GETTERS ------
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Labels")
+	int32 GetNumLabels() const { return Labels.Num(); }
+};
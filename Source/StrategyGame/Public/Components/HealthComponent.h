@@ -6,23 +6,74 @@
 #include "Components/ActorComponent.h"
 #include "HealthComponent.generated.h"
 
+class UHealthComponent;
 
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FHealthChangedDelegate, UHealthComponent*, HealthComponent, float, NewHealth, float, Damage);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FDeathDelegate, UHealthComponent*, HealthComponent, AActor*, Killer);
+
+// Gives the owner health. The values live in the health subsystem's pool, and damage is queued and applied
+// once a frame, so the change and death events fire at most once per frame no matter how many hits landed.
+// Hits are queued against actors, so an actor can only have one health component.
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
 class STRATEGYGAME_API UHealthComponent : public UActorComponent
 {
 	GENERATED_BODY()
 
-public:	
+public:
 	// Sets default values for this component's properties
 	UHealthComponent();
 
 protected:
+
+	UPROPERTY(EditAnywhere, Category="Health")
+	float MaxHealth = 100.0f;
+
+	// Destroys the owner once health reaches 0, or returns it to the actor pool if it's poolable.
+	UPROPERTY(EditAnywhere, Category="Health")
+	bool bDestroyOwnerOnDeath = false;
+
+	// Position of this component in the health subsystem's pool.
+	int32 PoolIndex = INDEX_NONE;
+
+	friend class UHealthSubsystem;
+
 	// Called when the game starts
 	virtual void BeginPlay() override;
 
-public:	
-	// Called every frame
-	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Queues damage dealt through AActor::TakeDamage, so other damage sources go through the same pass.
+	UFUNCTION()
+	void OnOwnerTakeAnyDamage(AActor* DamagedActor, float Damage, const UDamageType* DamageType, AController* InstigatedBy, AActor* DamageCauser);
+
+public:
+
+	UPROPERTY(BlueprintAssignable, Category="Health")
+	FHealthChangedDelegate OnHealthChanged;
+
+	UPROPERTY(BlueprintAssignable, Category="Health")
+	FDeathDelegate OnDeath;
+
+	// Queues damage to be applied at the end of the frame. Negative damage heals.
+	UFUNCTION(BlueprintCallable, Category="Health")
+	void ApplyDamage(float Damage, AActor* DamageCauser = nullptr);
+
+	// Back to full health and alive, for owners that are reused from the actor pool.
+	UFUNCTION(BlueprintCallable, Category="Health")
+	void ResetHealth();
+
+	// ------ GETTERS ------
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Health")
+	float GetHealth() const;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Health")
+	float GetMaxHealth() const { return MaxHealth; }
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Health")
+	bool IsDead() const;
+
+	// ------ SETTERS ------
 
-		
+	void SetDestroyOwnerOnDeath(bool bNewDestroyOwnerOnDeath) { bDestroyOwnerOnDeath = bNewDestroyOwnerOnDeath; }
 };
@@ -26,6 +26,7 @@ protected:
 	float KnockbackForceMultiplier = 1.0f;
 
 	// If the projectile is null, this weapon will fire Hitscan / LineTrace.
+	// The projectile isn't spawned as an actor, the projectile subsystem simulates it using the class defaults' mesh, sphere radius and life span.
 	UPROPERTY(EditAnywhere, Category="Shooting")
 	TSubclassOf<AProjectile> Projectile;
 	
@@ -78,8 +79,6 @@ protected:
 
 public:
 	
-	// Called every frame
-	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
 
 	UFUNCTION(BlueprintCallable)
 	float RoundsPerMinuteToRoundsPerSecond(float FireRate) { return 1 / (FireRate / 60); }
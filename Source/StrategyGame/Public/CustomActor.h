@@ -6,10 +6,11 @@
 #include "GameFramework/Actor.h"
 #include "Game/StrategyGameModeBase.h"
 #include "Game/StrategyGameState.h"
+#include "Interfaces/PoolableInterface.h"
 #include "CustomActor.generated.h"
 
 UCLASS()
-class STRATEGYGAME_API ACustomActor : public AActor
+class STRATEGYGAME_API ACustomActor : public AActor, public IPoolableInterface
 {
 	GENERATED_BODY()
 
@@ -22,8 +23,39 @@ protected:
 	UPROPERTY() AStrategyGameState* StrategyGameState = nullptr;
 	UPROPERTY() AStrategyGameModeBase* StrategyGameMode = nullptr;
 
+	// How often the actor ticks, if it can tick at all.
+	UPROPERTY(EditDefaultsOnly, BlueprintGetter=GetTickPolicy, Category="Tick Policy")
+	FGameplayTickPolicy TickPolicy;
+
+	// Position in the tick policy subsystem's significance list, INDEX_NONE if it isn't in it.
+	int32 SignificanceIndex = INDEX_NONE;
+
+	friend class UTickPolicySubsystem;
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 public:
 
+	virtual void TickActor(float DeltaTime, ELevelTick TickType, FActorTickFunction& ThisTickFunction) override;
+
+	// ------ INTERFACE FUNCTIONS ------
+
+	// Reapplies the tick policy, the pool turns ticking off while the actor waits.
+	virtual void OnAcquiredFromPool_Implementation() override;
+	virtual void OnReturnedToPool_Implementation() override;
+
+	// Turns ticking on for actors using the OnDemand tick policy.
+	UFUNCTION(BlueprintCallable, Category="Tick Policy")
+	void WakeTick();
+
+	// Turns ticking back off for actors using the OnDemand tick policy, once they run out of work.
+	UFUNCTION(BlueprintCallable, Category="Tick Policy")
+	void SleepTick();
+
+	UFUNCTION(BlueprintGetter)
+	const FGameplayTickPolicy& GetTickPolicy() const { return TickPolicy; }
+
 	UFUNCTION(BlueprintCallable, BlueprintPure)
 	AStrategyGameState* GetStrategyGameState();
 
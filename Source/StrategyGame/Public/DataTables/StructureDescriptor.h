@@ -0,0 +1,63 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DataTables/StructureData.h"
+#include "Game/ResourceLedger.h"
+
+// What a structure does, resolved once from its FStructureData row.
+enum class EStructureFlags : uint32
+{
+	None								= 0,
+	GeneratesResources					= 1 << 0,
+	ConsumesResources					= 1 << 1,
+	ConsumesResourceFromNearbyNode		= 1 << 2,
+	IncreasesStorageCapacity			= 1 << 3,
+	IncreasesPopulationCapacity			= 1 << 4,
+	AllowWorkerEmployment				= 1 << 5,
+	AllowScientistEmployment			= 1 << 6,
+};
+ENUM_CLASS_FLAGS(EStructureFlags);
+
+// Immutable, flattened copy of an FStructureData row that the economy can read without map lookups or allocations.
+// Descriptors are shared between every structure that uses the same data table row.
+// Nothing points back into the data table, so a descriptor stays safe to read after its table is edited or reimported.
+struct STRATEGYGAME_API FStructureDescriptor
+{
+	EStructureFlags Flags = EStructureFlags::None;
+
+	int32 MaxWorkerCapacity = 0;
+	int32 AdditionalPopulationCapacity = 0;
+
+	// One bit per EResourceType that has a non-zero entry in the matching array below.
+	uint32 GeneratedResourceMask = 0;
+	uint32 ConsumedResourceMask = 0;
+	uint32 StorageResourceMask = 0;
+
+	// Per second rates, indexed by EResourceType and padded to match FResourceLedger.
+	alignas(16) float GenerationRates[FResourceLedger::NumSlots] = {};
+	alignas(16) float ConsumptionRates[FResourceLedger::NumSlots] = {};
+
+	// Storage capacity added while the structure is built, indexed by EResourceType.
+	int32 StorageIncrease[NumResourceTypes] = {};
+
+	bool HasFlag(EStructureFlags Flag) const { return EnumHasAnyFlags(Flags, Flag); }
+
+	bool Generates(EResourceType ResourceType) const { return (GeneratedResourceMask & (1u << static_cast<uint32>(ResourceType))) != 0; }
+	bool Consumes(EResourceType ResourceType) const { return (ConsumedResourceMask & (1u << static_cast<uint32>(ResourceType))) != 0; }
+
+	float GetGenerationRate(EResourceType ResourceType) const { return GenerationRates[static_cast<int32>(ResourceType)]; }
+	float GetConsumptionRate(EResourceType ResourceType) const { return ConsumptionRates[static_cast<int32>(ResourceType)]; }
+	int32 GetStorageIncrease(EResourceType ResourceType) const { return StorageIncrease[static_cast<int32>(ResourceType)]; }
+
+	// Returns the shared descriptor for a data table row, building it the first time the row is requested.
+	// Returns null if the row handle does not point to a valid FStructureData row.
+	static TSharedPtr<const FStructureDescriptor> Resolve(const FDataTableRowHandle& RowHandle);
+
+	// Drops every cached descriptor. Structures that already hold one keep it alive until they are destroyed.
+	static void ClearCache();
+
+	// Drops the cached descriptors built from one table, such as a transient table that's about to go away.
+	static void ClearCache(const UDataTable* Table);
+};
@@ -0,0 +1,34 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Timing hooks for the StrategyGame.TickCensus console command.
+// Ticks wrapped in an FTickCensusScope are timed per class while a census is running, and cost nothing otherwise.
+namespace TickCensus
+{
+	STRATEGYGAME_API bool IsCapturing();
+
+	// Adds one tick of the class to the running census. Game thread only.
+	STRATEGYGAME_API void RecordTick(const UClass* Class, double Seconds);
+}
+
+struct FTickCensusScope
+{
+	explicit FTickCensusScope(const UObject* InObject)
+		: Object(TickCensus::IsCapturing() ? InObject : nullptr)
+		, StartTime(Object ? FPlatformTime::Seconds() : 0.0)
+	{
+	}
+
+	~FTickCensusScope()
+	{
+		if (Object) TickCensus::RecordTick(Object->GetClass(), FPlatformTime::Seconds() - StartTime);
+	}
+
+private:
+
+	const UObject* Object;
+	double StartTime;
+};
@@ -4,10 +4,13 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Pawn.h"
+#include "Interfaces/PoolableInterface.h"
 #include "EnemyShip.generated.h"
 
+class UHealthComponent;
+
 UCLASS()
-class STRATEGYGAME_API AEnemyShip : public APawn
+class STRATEGYGAME_API AEnemyShip : public APawn, public IPoolableInterface
 {
 	GENERATED_BODY()
 
@@ -16,13 +19,68 @@ public:
 	AEnemyShip();
 
 protected:
+
+	UPROPERTY(EditAnywhere, Category="Enemy Ship")
+	UHealthComponent* HealthComponent;
+
+	// ------ SWARM ------
+
+	// Mesh the swarm draws this ship with while it isn't an actor.
+	UPROPERTY(EditDefaultsOnly, Category="Swarm")
+	UStaticMesh* SwarmMesh = nullptr;
+
+	UPROPERTY(EditDefaultsOnly, Category="Swarm")
+	FTransform SwarmMeshTransform = FTransform::Identity;
+
+	// Size of the ship for projectile hits while it isn't an actor.
+	UPROPERTY(EditDefaultsOnly, Category="Swarm")
+	float SwarmRadius = 200.0f;
+
+	UPROPERTY(EditDefaultsOnly, Category="Swarm")
+	float MaxSpeed = 2000.0f;
+
+	UPROPERTY(EditDefaultsOnly, Category="Swarm")
+	float MaxAcceleration = 1500.0f;
+
+	// Distance the ship circles its target at.
+	UPROPERTY(EditDefaultsOnly, Category="Swarm")
+	float AttackRange = 3000.0f;
+
+	// Index of the ship this actor was promoted from in the enemy swarm, INDEX_NONE if it was spawned on its own.
+	int32 SwarmIndex = INDEX_NONE;
+
+	friend class UEnemySwarmSubsystem;
+
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Takes the ship out of targeting and the swarm, when it's destroyed or pooled.
+	void RemoveFromWorldSystems();
+
 public:
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
 
 	// Called to bind functionality to input
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
+
+	// ------ INTERFACE FUNCTIONS ------
+
+	virtual void OnAcquiredFromPool_Implementation() override;
+	virtual void OnReturnedToPool_Implementation() override;
+
+	// ------ GETTERS ------
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Enemy Ship")
+	UHealthComponent* GetHealthComponent() const { return HealthComponent; }
+
+	UStaticMesh* GetSwarmMesh() const { return SwarmMesh; }
+	const FTransform& GetSwarmMeshTransform() const { return SwarmMeshTransform; }
+	float GetSwarmRadius() const { return SwarmRadius; }
+	float GetMaxSpeed() const { return MaxSpeed; }
+	float GetMaxAcceleration() const { return MaxAcceleration; }
+	float GetAttackRange() const { return AttackRange; }
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Swarm")
+	bool IsSwarmShip() const { return SwarmIndex != INDEX_NONE; }
 };
@@ -0,0 +1,191 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "EnemySwarmSubsystem.generated.h"
+
+class AActor;
+class AEnemyShip;
+class AInstancedRenderActor;
+class UInstancedStaticMeshComponent;
+
+// Movement settings and rendering for every swarm ship of one AEnemyShip class, read from its class default object.
+USTRUCT()
+struct FEnemySwarmClass
+{
+	GENERATED_BODY()
+
+	UPROPERTY() TSubclassOf<AEnemyShip> ShipClass;
+
+	// Draws every ship of this class that isn't an actor.
+	UPROPERTY() UInstancedStaticMeshComponent* InstancedMesh = nullptr;
+
+	FTransform MeshTransform = FTransform::Identity;
+
+	float Radius = 200.0f;
+	float MaxSpeed = 2000.0f;
+	float MaxAcceleration = 1500.0f;
+	float AttackRange = 3000.0f;
+};
+
+// Simulates enemy fleets as a swarm of plain data instead of one pawn per ship.
+// Every frame the ships steer towards the city and away from each other in one parallel pass over contiguous arrays,
+// and are drawn with one instanced mesh per ship class. A ship only becomes an AEnemyShip actor when something needs
+// one: a hit, or a player-controlled turret it flies close to. Automated turrets aim at ships by index without promoting them.
+// Promoted ships are still moved by the swarm, the actor just follows along.
+UCLASS()
+class STRATEGYGAME_API UEnemySwarmSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	UPROPERTY() TArray<FEnemySwarmClass> ShipClasses;
+
+	TMap<UClass*, int32> ShipClassIndices;
+
+	UPROPERTY() AInstancedRenderActor* RenderActor = nullptr;
+
+	// ------ SHIPS ------
+
+	TArray<FVector> Positions;
+	TArray<FVector> Velocities;
+	TArray<FVector> TargetLocations;
+	TArray<int32> ClassIndices;
+
+	// The actor a ship was promoted to, or nullptr while it's only drawn as an instance.
+	UPROPERTY() TArray<AEnemyShip*> Actors;
+
+	// Written by the steering pass, so every ship steers from the same snapshot.
+	TArray<FVector> NewVelocities;
+
+	// ------ SPATIAL HASH ------
+
+	struct FCellEntry
+	{
+		uint64 Cell;
+		int32 Ship;
+	};
+
+	// Ships sorted by the cell they're in, rebuilt after every move and whenever ships are added or removed.
+	TArray<FCellEntry> CellEntries;
+
+	// First entry and number of entries in CellEntries for each occupied cell.
+	TMap<uint64, FIntPoint> CellRanges;
+
+	bool bHashDirty = true;
+
+	// Largest radius of any ship class, traces search this much further so they can't miss a ship in the next cell.
+	float MaxShipRadius = 0.0f;
+
+	// ------ STEERING ------
+
+	// Ships closer than this push away from each other. Also the size of a hash cell.
+	UPROPERTY()
+	float SeparationRadius = 800.0f;
+
+	UPROPERTY()
+	float SeparationWeight = 1.5f;
+
+	// Only the first few neighbours found are used for separation, which keeps dense clumps from getting expensive.
+	UPROPERTY()
+	int32 MaxNeighbors = 8;
+
+	// Every frame one slice of the ships looks for the closest structure to attack.
+	UPROPERTY()
+	int32 RetargetSlices = 16;
+
+	int32 RetargetCursor = 0;
+
+	// Locations of every structure in the city, refreshed every TargetRefreshInterval seconds.
+	TArray<FVector> TargetPoints;
+
+	UPROPERTY()
+	float TargetRefreshInterval = 1.0f;
+
+	float TargetRefreshAccumulator = 0.0f;
+
+	// Below this many ships steering is run on the game thread.
+	UPROPERTY()
+	int32 MinParallelShips = 256;
+
+	// ------ PROMOTION ------
+
+	// Actors, like player-controlled turrets, that turn every ship within PromotionRadius of them into an actor.
+	TArray<TWeakObjectPtr<AActor>> PromotionSources;
+
+	UPROPERTY()
+	float PromotionRadius = 15000.0f;
+
+	UPROPERTY()
+	float PromotionInterval = 0.25f;
+
+	float PromotionAccumulator = 0.0f;
+
+	// Scratch array for rendering.
+	TArray<FTransform> InstanceTransforms;
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	int32 FindOrAddShipClass(TSubclassOf<AEnemyShip> ShipClass);
+
+	FIntVector WorldToCell(const FVector& Location) const;
+	static uint64 PackCell(const FIntVector& Cell);
+
+	void RefreshTargetPoints();
+
+	// Points a slice of the ships at their closest structure.
+	void RetargetShips();
+
+	void SteerShips(float DeltaTime);
+	void MoveShips(float DeltaTime);
+	void PromoteShipsNearSources();
+	void SyncActors();
+	void RenderShips();
+
+	// Called by AEnemyShip::EndPlay, removes the ship the actor was promoted from.
+	void RemoveShip(int32 Index);
+
+	friend class AEnemyShip;
+
+public:
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	virtual void Deinitialize() override;
+
+	// Adds a ship to the swarm. Returns its index, which stays valid until a ship is removed.
+	int32 SpawnShip(TSubclassOf<AEnemyShip> ShipClass, const FVector& Location, const FVector& Velocity = FVector::ZeroVector);
+
+	// Adds Count ships at random points within Radius of Center.
+	UFUNCTION(BlueprintCallable, Category="Enemy Swarm")
+	void SpawnFleet(TSubclassOf<AEnemyShip> ShipClass, FVector Center, int32 Count, float Radius = 10000.0f);
+
+	// Spawns an actor for the ship if it doesn't have one yet, and returns it.
+	AEnemyShip* PromoteShip(int32 Index);
+
+	// Rebuilds the spatial hash if ships were added or removed since it was last built.
+	void UpdateSpatialHash();
+
+	// Finds the first ship a sphere of Radius would hit moving from Start to End, or INDEX_NONE. OutTime is how far along
+	// the trace the hit is, from 0 to 1. Only reads the hash, so call UpdateSpatialHash first, after that it's safe to call in parallel.
+	int32 TraceShips(const FVector& Start, const FVector& End, float Radius, float& OutTime) const;
+
+	UFUNCTION(BlueprintCallable, Category="Enemy Swarm")
+	void AddPromotionSource(AActor* Source);
+
+	UFUNCTION(BlueprintCallable, Category="Enemy Swarm")
+	void RemovePromotionSource(AActor* Source);
+
+	// ------ GETTERS ------
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Enemy Swarm")
+	int32 GetNumShips() const { return Positions.Num(); }
+
+	const TArray<FVector>& GetShipPositions() const { return Positions; }
+
+	AEnemyShip* GetShipActor(int32 Index) const { return Actors.IsValidIndex(Index) ? Actors[Index] : nullptr; }
+};
@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ActorPoolSubsystem.generated.h"
+
+USTRUCT(BlueprintType)
+struct FActorPoolStats
+{
+	GENERATED_BODY()
+
+	// Acquires that reused a pooled actor.
+	UPROPERTY(BlueprintReadOnly)
+	int32 Hits = 0;
+
+	// Acquires that had to spawn a new actor.
+	UPROPERTY(BlueprintReadOnly)
+	int32 Misses = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 Releases = 0;
+
+	// Releases that destroyed the actor because the pool was full.
+	UPROPERTY(BlueprintReadOnly)
+	int32 Discards = 0;
+
+	// Actors currently waiting in the pool.
+	UPROPERTY(BlueprintReadOnly)
+	int32 Pooled = 0;
+};
+
+// Every inactive actor of one class.
+USTRUCT()
+struct FActorPool
+{
+	GENERATED_BODY()
+
+	UPROPERTY() TArray<AActor*> FreeActors;
+
+	int32 MaxSize = 32;
+
+	FActorPoolStats Stats;
+};
+
+// Reuses actors that are spawned and destroyed often, like build previews and promoted enemy ships.
+// Released actors are hidden, have collision and ticking turned off and wait in a pool for their class,
+// so acquiring one later is a move instead of a spawn, and nothing is left behind for garbage collection.
+// Only actors implementing IPoolableInterface are pooled, anything else is destroyed on release.
+UCLASS()
+class STRATEGYGAME_API UActorPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	UPROPERTY() TMap<UClass*, FActorPool> Pools;
+
+	// Every actor currently in a pool, so releasing one twice is harmless.
+	TSet<AActor*> PooledActors;
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	static void DeactivateActor(AActor* Actor);
+
+public:
+
+	virtual void Deinitialize() override;
+
+	// Returns a pooled actor of the class moved to Transform, or spawns a new one if the pool is empty.
+	UFUNCTION(BlueprintCallable, Category="Actor Pool", meta=(DeterminesOutputType="ActorClass"))
+	AActor* AcquireActor(TSubclassOf<AActor> ActorClass, const FTransform& Transform);
+
+	template <typename ActorType>
+	ActorType* AcquireActor(TSubclassOf<ActorType> ActorClass, const FTransform& Transform)
+	{
+		return Cast<ActorType>(AcquireActor(TSubclassOf<AActor>(ActorClass), Transform));
+	}
+
+	// Puts the actor back in its pool, or destroys it if it can't be pooled or the pool is full.
+	UFUNCTION(BlueprintCallable, Category="Actor Pool")
+	void ReleaseActor(AActor* Actor);
+
+	// Spawns actors into the class's pool until it holds Count of them.
+	UFUNCTION(BlueprintCallable, Category="Actor Pool")
+	void PrewarmPool(TSubclassOf<AActor> ActorClass, int32 Count);
+
+	UFUNCTION(BlueprintCallable, Category="Actor Pool")
+	void SetMaxPoolSize(TSubclassOf<AActor> ActorClass, int32 MaxSize);
+
+	// ------ GETTERS ------
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Actor Pool")
+	FActorPoolStats GetPoolStats(TSubclassOf<AActor> ActorClass) const;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Actor Pool")
+	bool IsPooled(const AActor* Actor) const { return PooledActors.Contains(Actor); }
+
+	void LogPoolStats() const;
+};
@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Game/StrategyGameState.h"
+#include "DataTables/StructureDescriptor.h"
+#include "EconomySubsystem.generated.h"
+
+class AStructure;
+
+// Advances every resource producer, consumer and extractor in the city in one fixed-step batch,
+// instead of each structure running its own looping timers.
+UCLASS()
+class STRATEGYGAME_API UEconomySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	UPROPERTY() AStrategyGameState* StrategyGameState = nullptr;
+
+	// How many in-game seconds pass between economy steps.
+	UPROPERTY()
+	float StepSeconds = 1.0f;
+
+	// Time that has passed since the last economy step.
+	UPROPERTY()
+	float StepAccumulator = 0.0f;
+
+	// Steps that can be left waiting for the next frame once the frame's budget runs out. Anything more is fast forwarded.
+	UPROPERTY()
+	int32 MaxBacklogSteps = 4;
+
+	// ------ PRODUCERS & CONSUMERS ------
+
+	UPROPERTY() TArray<AStructure*> Producers;
+
+	// Shared descriptor of each producer, parallel to Producers.
+	TArray<const FStructureDescriptor*> ProducerDescriptors;
+
+	UPROPERTY() TArray<AStructure*> Consumers;
+
+	// Shared descriptor of each consumer, parallel to Consumers.
+	TArray<const FStructureDescriptor*> ConsumerDescriptors;
+
+	UPROPERTY() TArray<AStructure*> Extractors;
+
+	// ------ STEP COST ------
+
+	float LastStepMilliseconds = 0.0f;
+	float AverageStepMilliseconds = 0.0f;
+	int64 StepCount = 0;
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	// Sums what every producer generates and every consumer uses in a single step, indexed by EResourceType.
+	void SumStepTotals(float* OutGenerated, float* OutConsumed) const;
+
+	// Swap-removes a structure and its descriptor, keeping the arrays contiguous.
+	static void RemoveEntry(TArray<AStructure*>& Structures, TArray<const FStructureDescriptor*>* Descriptors, AStructure* Structure);
+
+public:
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	UFUNCTION(BlueprintCallable, Category="Economy")
+	void RegisterProducer(AStructure* Structure);
+
+	UFUNCTION(BlueprintCallable, Category="Economy")
+	void RegisterConsumer(AStructure* Structure);
+
+	UFUNCTION(BlueprintCallable, Category="Economy")
+	void RegisterExtractor(AStructure* Structure);
+
+	// Removes the structure from every economy array it was registered in.
+	UFUNCTION(BlueprintCallable, Category="Economy")
+	void UnregisterStructure(AStructure* Structure);
+
+	// Advances the whole economy by a single fixed step.
+	UFUNCTION(BlueprintCallable, Category="Economy")
+	void StepEconomy();
+
+	// Advances the economy by the number of steps that fit into Seconds without running them one by one.
+	// Gives the same result as calling StepEconomy that many times, as long as no structures or workers change in between.
+	// Resources without extractors are solved in closed form. Resources with extractors are stepped until they settle,
+	// and nodes nobody is extracting from regenerate in a few substeps, which is the one part that's approximate.
+	UFUNCTION(BlueprintCallable, Category="Economy")
+	void FastForward(float Seconds);
+
+	// Same as FastForward, for a whole number of steps. Leaves the step accumulator alone.
+	void FastForwardSteps(int64 NumSteps);
+
+	// Resource amount after a single step that generates then consumes, clamped the same way the game state clamps it.
+	static float StepAmount(float Amount, float Capacity, float Generated, float Consumed);
+
+	// Resource amount after a number of steps that each generate then consume a fixed amount, clamped to the storage capacity.
+	static float AmountAfterSteps(float Amount, float Capacity, float Generated, float Consumed, int64 Steps);
+
+	// ------ GETTERS ------
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Economy")
+	float GetStepSeconds() const { return StepSeconds; }
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Economy")
+	int32 GetRegisteredStructureCount() const { return Producers.Num() + Consumers.Num() + Extractors.Num(); }
+
+	// How long the most recent economy step took to run, in milliseconds.
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Economy|Stats")
+	float GetLastStepMilliseconds() const { return LastStepMilliseconds; }
+
+	// Moving average of the economy step cost, in milliseconds.
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Economy|Stats")
+	float GetAverageStepMilliseconds() const { return AverageStepMilliseconds; }
+
+	// Average step cost divided by the number of registered structures. Should stay flat as the city grows.
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Economy|Stats")
+	float GetMicrosecondsPerStructure() const { return GetRegisteredStructureCount() > 0 ? AverageStepMilliseconds * 1000.0f / GetRegisteredStructureCount() : 0.0f; }
+};
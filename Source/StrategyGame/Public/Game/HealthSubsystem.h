@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HealthSubsystem.generated.h"
+
+class UHealthComponent;
+
+// Stores the health of every UHealthComponent in contiguous arrays and applies all damage in one pass a frame.
+// Hits push into a queue while the frame runs. The resolve pass sums the damage per component, subtracts it,
+// then fires one change event per damaged component and one death event per component that died.
+UCLASS()
+class STRATEGYGAME_API UHealthSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	// ------ POOL ------
+
+	UPROPERTY() TArray<UHealthComponent*> Components;
+
+	TArray<float> Health;
+	TArray<uint8> Dead;
+
+	// Pool index of each component's owner, so hits can be queued against an actor.
+	// Only one component per owner can be registered, a second one is refused.
+	TMap<AActor*, int32> OwnerIndices;
+
+	// ------ QUEUE ------
+
+	struct FQueuedDamage
+	{
+		TWeakObjectPtr<AActor> Target;
+		TWeakObjectPtr<AActor> Causer;
+		float Damage;
+	};
+
+	TArray<FQueuedDamage> DamageQueue;
+
+	// Scratch arrays for the resolve pass, parallel to the pool.
+	TArray<float> PendingDamage;
+	TArray<TWeakObjectPtr<AActor>> PendingCausers;
+	TArray<int32> DamagedIndices;
+
+	// Events to fire once the pool is updated, since handlers can add or remove components.
+	struct FHealthEvent
+	{
+		TWeakObjectPtr<UHealthComponent> Component;
+		TWeakObjectPtr<AActor> Causer;
+		float Health;
+		float Damage;
+		bool bDied;
+	};
+
+	TArray<FHealthEvent> HealthEvents;
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	// Hits on actors that don't have a health component go through AActor::TakeDamage, like before.
+	void ApplyUnpooledDamage(const FQueuedDamage& QueuedDamage);
+
+public:
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	virtual void Deinitialize() override;
+
+	// Adds the component to the pool, unless its owner already has a registered health component.
+	void RegisterHealth(UHealthComponent* HealthComponent);
+	void UnregisterHealth(UHealthComponent* HealthComponent);
+
+	// Queues damage against the actor to be applied in the next resolve pass. Negative damage heals.
+	UFUNCTION(BlueprintCallable, Category="Health")
+	void QueueDamage(AActor* Target, float Damage, AActor* DamageCauser = nullptr);
+
+	// Applies everything in the damage queue.
+	void ResolveDamage();
+
+	void ResetHealth(int32 PoolIndex);
+
+	// ------ GETTERS ------
+
+	float GetHealth(int32 PoolIndex) const { return Health.IsValidIndex(PoolIndex) ? Health[PoolIndex] : 0.0f; }
+	bool IsDead(int32 PoolIndex) const { return Dead.IsValidIndex(PoolIndex) && Dead[PoolIndex]; }
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Health")
+	int32 GetNumHealthComponents() const { return Components.Num(); }
+};
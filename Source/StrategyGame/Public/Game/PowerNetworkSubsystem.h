@@ -0,0 +1,173 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "PowerNetworkSubsystem.generated.h"
+
+// Models power lines and structures as a graph and keeps track of which of them share a network.
+// A structure links to any power line whose range reaches it, and power lines link to each other the same way.
+// Joining a node merges the networks it touches, the smaller network is relabeled into the larger one.
+// Removing a node only searches outwards from its old links, and stops as soon as the pieces it split off are found,
+// so the cost is proportional to the smaller pieces rather than the whole grid.
+// Every network sums its generation and consumption, and is balanced once a frame if either changed.
+UCLASS()
+class STRATEGYGAME_API UPowerNetworkSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	struct FPowerNode
+	{
+		FVector Location = FVector::ZeroVector;
+		float ConnectionRadius = 0.0f;
+		float Generation = 0.0f;
+		float Consumption = 0.0f;
+
+		// Power lines link to everything in range, other nodes only link to power lines.
+		bool bPowerLine = false;
+
+		int32 Network = INDEX_NONE;
+
+		// Position of the node in its network's member list.
+		int32 NetworkPosition = INDEX_NONE;
+
+		TArray<int32> Links;
+
+		// The last state the node was told about, so it's only notified when it actually changes.
+		bool bNotifiedConnected = false;
+		float NotifiedSatisfaction = 0.0f;
+
+		// Scratch for the split search.
+		uint32 SearchStamp = 0;
+		int32 Search = INDEX_NONE;
+	};
+
+	struct FPowerNetwork
+	{
+		TArray<int32> Members;
+
+		// Doubles, since the totals are adjusted in place every time a node joins or leaves.
+		double Generation = 0.0;
+		double Consumption = 0.0;
+
+		bool bConnected = false;
+		float Satisfaction = 0.0f;
+		bool bDirty = false;
+	};
+
+	// ------ GRAPH ------
+
+	TArray<FPowerNode> Nodes;
+	UPROPERTY() TArray<AActor*> NodeActors;
+	TMap<AActor*, int32> NodeIndices;
+	TArray<int32> FreeNodes;
+
+	TArray<FPowerNetwork> Networks;
+	TArray<int32> FreeNetworks;
+	TArray<int32> DirtyNetworks;
+
+	// Nodes that joined or moved to another network, or whose network changed, to be checked against the state they were last told about.
+	TArray<int32> NodesToNotify;
+
+	// ------ SPATIAL HASH ------
+
+	// Nodes are hashed by cell so new nodes only have to check the cells around them for links.
+	float CellSize = 4000.0f;
+	TMap<FIntPoint, TArray<int32>> CellNodes;
+
+	// Largest connection radius that has been registered, so lookups know how many cells to check.
+	float MaxConnectionRadius = 0.0f;
+
+	// ------ SPLIT SEARCH ------
+
+	uint32 SearchStamp = 0;
+	TArray<TArray<int32>> SearchQueues;
+	TArray<int32> SearchHeads;
+	TArray<int32> SearchGroups;
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	FIntPoint WorldToCell(const FVector& Location) const;
+
+	int32 AllocateNetwork();
+	void FreeNetwork(int32 NetworkIndex);
+	void MarkNetworkDirty(int32 NetworkIndex);
+
+	void AddToNetwork(int32 NodeIndex, int32 NetworkIndex);
+	void RemoveFromNetwork(int32 NodeIndex);
+
+	// Merges the smaller of the two networks into the larger one and returns the network that's left.
+	int32 MergeNetworks(int32 NetworkA, int32 NetworkB);
+
+	// Searches outwards from the removed node's old links at the same pace, merging searches that meet.
+	// Each search that runs out of nodes before the others meet it has found a piece that was split off.
+	void SplitNetwork(int32 NetworkIndex, const TArray<int32>& Seeds);
+
+	int32 FindSearchGroup(int32 Search);
+
+	// Updates each dirty network's balance and notifies the nodes whose state changed.
+	void SolveNetworks();
+
+	void NotifyNode(int32 NodeIndex);
+
+public:
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	virtual void Deinitialize() override;
+
+	// Registers every power line and structure that was already built when the level loaded.
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	// Adds a built power line or structure to the graph and links it to everything in range.
+	UFUNCTION(BlueprintCallable, Category="Power")
+	void RegisterNode(AActor* Actor);
+
+	UFUNCTION(BlueprintCallable, Category="Power")
+	void UnregisterNode(AActor* Actor);
+
+	// Reads the node's generation and consumption again, for when its load changes while it's built.
+	UFUNCTION(BlueprintCallable, Category="Power")
+	void RefreshNodeLoad(AActor* Actor);
+
+	// ------ GETTERS ------
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Power")
+	bool IsRegistered(AActor* Actor) const { return NodeIndices.Contains(Actor); }
+
+	// True if the actor's network has anything generating power in it.
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Power")
+	bool IsConnectedToPowerSource(AActor* Actor) const;
+
+	// Share of the network's consumption that its generation covers, between 0 and 1.
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Power")
+	float GetPowerSatisfaction(AActor* Actor) const;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Power")
+	bool AreConnected(AActor* ActorA, AActor* ActorB) const;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Power")
+	float GetNetworkGeneration(AActor* Actor) const;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Power")
+	float GetNetworkConsumption(AActor* Actor) const;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Power")
+	int32 GetNetworkSize(AActor* Actor) const;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Power")
+	int32 GetNumNetworks() const { return Networks.Num() - FreeNetworks.Num(); }
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Power")
+	int32 GetNumNodes() const { return NodeIndices.Num(); }
+
+	// Fills OutActors with the nodes the actor is directly linked to.
+	UFUNCTION(BlueprintCallable, Category="Power")
+	void GetLinkedNodes(AActor* Actor, TArray<AActor*>& OutActors) const;
+
+	void LogNetworks() const;
+};
@@ -0,0 +1,111 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ProjectileSubsystem.generated.h"
+
+class AProjectile;
+class AInstancedRenderActor;
+class UInstancedStaticMeshComponent;
+
+// Every live projectile of one AProjectile class, stored as parallel arrays.
+USTRUCT()
+struct FProjectileBatch
+{
+	GENERATED_BODY()
+
+	// Drawn with the mesh of the class default object, one instance per projectile.
+	UPROPERTY() UInstancedStaticMeshComponent* InstancedMesh = nullptr;
+
+	// Mesh transform relative to the projectile, taken from the class default object.
+	FTransform MeshTransform = FTransform::Identity;
+
+	float Radius = 10.0f;
+	float LifeSpan = 5.0f;
+
+	TArray<FVector> Positions;
+	TArray<FVector> PreviousPositions;
+	TArray<FVector> Velocities;
+	TArray<float> Damages;
+	TArray<float> KnockbackMultipliers;
+	TArray<float> Lifetimes;
+
+	// The actor that fired each projectile. It's ignored by the projectile's sweeps and credited with its damage.
+	TArray<TWeakObjectPtr<AActor>> Shooters;
+
+	int32 Num() const { return Positions.Num(); }
+
+	void Add(const FVector& Position, const FVector& Velocity, float Damage, float KnockbackMultiplier, AActor* Shooter);
+	void RemoveAtSwap(int32 Index);
+};
+
+// Simulates every projectile in the world without an actor per round.
+// Each frame the projectiles are moved in one loop, swept against the world in parallel,
+// and then drawn with a single instanced mesh per projectile class.
+UCLASS()
+class STRATEGYGAME_API UProjectileSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	UPROPERTY() TMap<TSubclassOf<AProjectile>, FProjectileBatch> Batches;
+
+	UPROPERTY() AInstancedRenderActor* RenderActor = nullptr;
+
+	// A hit waiting to be applied once every batch is done, so knockback doesn't move things mid-sweep.
+	struct FPendingHit
+	{
+		TWeakObjectPtr<AActor> Shooter;
+		FHitResult Hit;
+		FVector Velocity;
+		float Damage;
+		float KnockbackMultiplier;
+	};
+
+	TArray<FPendingHit> PendingHits;
+
+	// Scratch arrays reused between frames.
+	TArray<FHitResult> SweepHits;
+	TArray<uint8> SweepDidHit;
+	TArray<int32> SwarmHitShips;
+	TArray<float> SwarmHitTimes;
+	TArray<const AActor*> IgnoredActors;
+	TArray<FTransform> InstanceTransforms;
+
+	// Below this many projectiles the sweeps are run on the game thread.
+	UPROPERTY()
+	int32 MinParallelSweeps = 64;
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	FProjectileBatch& FindOrAddBatch(TSubclassOf<AProjectile> ProjectileClass);
+
+	// Moves every projectile in the batch and ages it.
+	static void IntegrateBatch(FProjectileBatch& Batch, float DeltaTime);
+
+	// Sweeps every projectile from its previous position to its current one, against the world and the enemy swarm.
+	void SweepBatch(const FProjectileBatch& Batch);
+
+	// Applies damage and knockback for the hits of the last sweep, then removes expired and spent projectiles.
+	void ResolveBatch(FProjectileBatch& Batch);
+
+	void RenderBatch(FProjectileBatch& Batch);
+
+public:
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	virtual void Deinitialize() override;
+
+	// Fires a projectile using the mesh, radius and life span of the projectile class.
+	void SpawnProjectile(TSubclassOf<AProjectile> ProjectileClass, const FVector& Location, const FVector& Velocity, float Damage, float KnockbackMultiplier, AActor* Shooter);
+
+	// ------ GETTERS ------
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Projectiles")
+	int32 GetNumProjectiles() const;
+};
@@ -0,0 +1,164 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Game/StrategyGameTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ResourceFieldSubsystem.generated.h"
+
+class AResourceNode;
+class AStrategyGameState;
+class AStructure;
+class UCurveFloat;
+
+// A spatial index of the resource nodes, so extractors can find the nearest node without physics overlaps.
+// Nodes are hashed into a grid per resource type, and a lookup searches rings of cells outwards from the location,
+// stopping once no closer node can be found. Nodes leave the index when they're emptied, and are flagged when an
+// extractor is assigned so lookups for unassigned nodes can skip them.
+// The field also keeps every node's reserve as a fixed-point amount, so fractional drains add up exactly, and
+// advances all extraction and regeneration in one batch per economy step instead of each node doing its own.
+UCLASS()
+class STRATEGYGAME_API UResourceFieldSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	// An extractor's node and rates, cached so extraction can be stepped many times in a row without asking the actors again.
+	struct FExtractorStep
+	{
+		AStructure* Extractor = nullptr;
+		int32 NodeIndex = INDEX_NONE;
+		int32 Resource = 0;
+		float DrainRate = 0.0f;
+		int64 DrainPerStep = 0;
+
+		// Set once the extractor has looked for a node and found none, so it isn't searched for again every step.
+		bool bNoNodeInRange = false;
+	};
+
+protected:
+
+	struct FFieldNode
+	{
+		FVector Location = FVector::ZeroVector;
+
+		// How far from the node an extractor can be.
+		float ExtractionRadius = 0.0f;
+
+		EResourceType ResourceType = EResourceType::Metal;
+		FIntPoint Cell = FIntPoint::ZeroValue;
+		bool bAssigned = false;
+	};
+
+	struct FNodeReserve
+	{
+		int64 Amount = 0;
+		int64 Capacity = 0;
+	};
+
+	// Reserves are stored in units of 1 / ReserveScale.
+	static constexpr int64 ReserveScale = 1 << 16;
+
+	static int64 ToReserve(double Amount) { return FMath::Max<int64>(static_cast<int64>(FMath::RoundToDouble(Amount * ReserveScale)), 0); }
+	static float FromReserve(int64 Reserve) { return static_cast<float>(static_cast<double>(Reserve) / ReserveScale); }
+
+	TArray<FFieldNode> Nodes;
+	UPROPERTY() TArray<AResourceNode*> NodeActors;
+	TMap<AResourceNode*, int32> NodeIndices;
+	TArray<int32> FreeNodes;
+
+	// Parallel to Nodes, kept apart so the batched extraction only touches the amounts.
+	TArray<FNodeReserve> Reserves;
+	UPROPERTY() TArray<UCurveFloat*> RegenerationCurves;
+
+	// Nodes with a regeneration curve.
+	TArray<int32> RegeneratingNodes;
+
+	// Scratch for StepExtraction.
+	TArray<FExtractorStep> ExtractorSteps;
+
+	// Bit per resource type whose storage was too full for an extractor in the last ExtractStep.
+	uint32 StorageFullMask = 0;
+
+	float CellSize = 2000.0f;
+
+	// Node indices by cell, one grid per resource type.
+	TMap<FIntPoint, TArray<int32>> TypeCells[NumResourceTypes];
+
+	int32 NumNodes[NumResourceTypes] = {};
+	int32 NumUnassignedNodes[NumResourceTypes] = {};
+
+	// Largest extraction radius that has been registered, so lookups know how many cells to check.
+	float MaxExtractionRadius = 0.0f;
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	FIntPoint WorldToCell(const FVector& Location) const;
+
+	// Returns the closest node of the type in range of Location, and its squared distance.
+	int32 FindNearestNodeOfType(EResourceType ResourceType, const FVector& Location, float Radius, bool bUnassignedOnly, float& OutDistanceSquared) const;
+
+	// Takes up to Amount from the node's reserve and returns how much was taken. Nodes that can't regenerate are destroyed once empty.
+	int64 DrainReserve(int32 NodeIndex, int64 Amount);
+
+	// Caches the extractor's current node and rates. Returns false if it has no node.
+	bool BindExtractorStep(FExtractorStep& Step, float StepSeconds) const;
+
+public:
+
+	virtual void Deinitialize() override;
+
+	UFUNCTION(BlueprintCallable, Category="Resources")
+	void RegisterNode(AResourceNode* Node);
+
+	UFUNCTION(BlueprintCallable, Category="Resources")
+	void UnregisterNode(AResourceNode* Node);
+
+	// Updates whether the node has an extractor, for when one is assigned or the extractor is removed.
+	UFUNCTION(BlueprintCallable, Category="Resources")
+	void SetNodeAssigned(AResourceNode* Node, bool bAssigned);
+
+	// Takes up to Amount from the node's reserve and returns how much was taken.
+	float DrainNode(AResourceNode* Node, float Amount);
+
+	// Drains each extractor's node by one step of its extraction rate and credits the game state with the totals.
+	// Extractors whose node is gone look for a new one instead.
+	void StepExtraction(const TArray<AStructure*>& Extractors, AStrategyGameState* StrategyGameState, float StepSeconds);
+
+	// Caches every extractor for ExtractStep. Returns a mask of the resource types they extract, or could once they find a node.
+	uint32 GatherExtractors(const TArray<AStructure*>& Extractors, float StepSeconds, TArray<FExtractorStep>& OutSteps) const;
+
+	// Runs one step of extraction against Amounts, indexed by EResourceType, and adds what was extracted up to Capacities.
+	// Returns false if no extractor did anything, in which case another step with the same amounts won't either.
+	// Resources whose storage stopped an extractor are kept in the storage full mask, nothing is reported per extractor.
+	bool ExtractStep(TArray<FExtractorStep>& Steps, float* Amounts, const float* Capacities, float StepSeconds);
+
+	// Regenerates every node with a regeneration curve, in NumSubsteps even steps for long skips.
+	void AdvanceRegeneration(float Seconds, int32 NumSubsteps = 1);
+
+	// Finds the closest node of any of the types in ResourceTypeMask whose extraction radius, plus Radius, reaches Location.
+	AResourceNode* FindNearestNode(uint32 ResourceTypeMask, const FVector& Location, float Radius, bool bUnassignedOnly = true) const;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Resources")
+	AResourceNode* FindNearestUnassignedNode(EResourceType ResourceType, FVector Location, float Radius) const;
+
+	// ------ GETTERS ------
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Resources")
+	bool IsRegistered(AResourceNode* Node) const { return NodeIndices.Contains(Node); }
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Resources")
+	float GetReserve(AResourceNode* Node) const;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Resources")
+	int32 GetNumNodes(EResourceType ResourceType) const { return NumNodes[static_cast<int32>(ResourceType)]; }
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Resources")
+	int32 GetNumUnassignedNodes(EResourceType ResourceType) const { return NumUnassignedNodes[static_cast<int32>(ResourceType)]; }
+
+	// Bit per EResourceType that had an extractor stopped by full storage in the last step.
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Resources")
+	int32 GetStorageFullResourceMask() const { return static_cast<int32>(StorageFullMask); }
+};
@@ -0,0 +1,115 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Game/StrategyGameTypes.h"
+
+struct FResourceTransaction;
+
+// Fixed-size resource amounts and capacities indexed by EResourceType.
+// Both arrays are padded to a multiple of four floats so every resource can be clamped in one vectorized pass.
+struct FResourceLedger
+{
+	static constexpr int32 NumSlots = (NumResourceTypes + 3) & ~3;
+
+	alignas(16) float Amounts[NumSlots] = {};
+	alignas(16) float Capacities[NumSlots] = {};
+
+	// Fills the ledger from the designer facing resource maps.
+	void Initialize(const TMap<EResourceType, float>& StartingAmounts, const TMap<EResourceType, int32>& StartingCapacities)
+	{
+		FMemory::Memzero(Amounts);
+		FMemory::Memzero(Capacities);
+
+		for (auto Resource : StartingAmounts) Amounts[Index(Resource.Key)] = Resource.Value;
+		for (auto Resource : StartingCapacities) Capacities[Index(Resource.Key)] = Resource.Value;
+
+		ClampAll();
+	}
+
+	// Clamps every amount between 0 and its capacity.
+	void ClampAll()
+	{
+		const VectorRegister4Float Zero = VectorZeroFloat();
+		for (int32 i = 0; i < NumSlots; i += 4)
+		{
+			const VectorRegister4Float Amount = VectorLoadAligned(&Amounts[i]);
+			const VectorRegister4Float Capacity = VectorLoadAligned(&Capacities[i]);
+			VectorStoreAligned(VectorMax(VectorMin(Amount, Capacity), Zero), &Amounts[i]);
+		}
+	}
+
+	float GetAmount(EResourceType ResourceType) const { return Amounts[Index(ResourceType)]; }
+	float GetCapacity(EResourceType ResourceType) const { return Capacities[Index(ResourceType)]; }
+
+	bool IsFull(EResourceType ResourceType) const { return GetAmount(ResourceType) >= GetCapacity(ResourceType); }
+
+	void SetAmount(EResourceType ResourceType, float NewAmount) { Amounts[Index(ResourceType)] = NewAmount; }
+	void SetCapacity(EResourceType ResourceType, float NewCapacity) { Capacities[Index(ResourceType)] = FMath::Max(NewCapacity, 0.0f); }
+
+	// Returns true if every cost in the transaction can be paid from the current amounts.
+	bool CanApply(const FResourceTransaction& Transaction) const;
+
+	// Adds every change in the transaction in one pass, then clamps. Refunds past a resource's capacity are lost.
+	void Apply(const FResourceTransaction& Transaction);
+
+	static int32 Index(EResourceType ResourceType) { return static_cast<int32>(ResourceType); }
+};
+
+// A bundle of resource costs and refunds that is checked and applied to the ledger as one change.
+// Build one up from many buildings and commit it through AStrategyGameState::CommitResourceTransaction.
+struct FResourceTransaction
+{
+	// Change to each resource, negative for costs. Padded to match FResourceLedger.
+	alignas(16) float Deltas[FResourceLedger::NumSlots] = {};
+
+	// One bit per EResourceType touched by the transaction.
+	int32 ResourceMask = 0;
+
+	void AddCost(EResourceType ResourceType, float Amount) { Add(ResourceType, -Amount); }
+	void AddRefund(EResourceType ResourceType, float Amount) { Add(ResourceType, Amount); }
+
+	// Adds a construction cost map, multiplied by Count for placing several of the same building.
+	void AddCosts(const TMap<EResourceType, int32>& Costs, int32 Count = 1)
+	{
+		for (auto Cost : Costs) AddCost(Cost.Key, static_cast<float>(Cost.Value) * Count);
+	}
+
+	void AddRefunds(const TMap<EResourceType, int32>& Refunds, int32 Count = 1)
+	{
+		for (auto Refund : Refunds) AddRefund(Refund.Key, static_cast<float>(Refund.Value) * Count);
+	}
+
+	bool IsEmpty() const { return ResourceMask == 0; }
+
+private:
+
+	void Add(EResourceType ResourceType, float Amount)
+	{
+		if (ResourceType >= EResourceType::MAX || Amount == 0.0f) return;
+
+		Deltas[FResourceLedger::Index(ResourceType)] += Amount;
+		ResourceMask |= 1 << static_cast<int32>(ResourceType);
+	}
+};
+
+inline bool FResourceLedger::CanApply(const FResourceTransaction& Transaction) const
+{
+	for (int32 i = 0; i < NumResourceTypes; i++)
+	{
+		if (Transaction.Deltas[i] < 0.0f && Amounts[i] + Transaction.Deltas[i] < 0.0f) return false;
+	}
+
+	return true;
+}
+
+inline void FResourceLedger::Apply(const FResourceTransaction& Transaction)
+{
+	for (int32 i = 0; i < NumSlots; i += 4)
+	{
+		VectorStoreAligned(VectorAdd(VectorLoadAligned(&Amounts[i]), VectorLoadAligned(&Transaction.Deltas[i])), &Amounts[i]);
+	}
+
+	ClampAll();
+}
@@ -21,6 +21,11 @@ protected:
 	UPROPERTY(EditAnywhere, Category="Time")
 	float SecondsInGameHours = 5.0f;
 
+	// How long the economy is allowed to spend stepping each frame, in milliseconds.
+	// At high time scales any steps that don't fit are fast forwarded together instead of stalling the frame.
+	UPROPERTY(EditAnywhere, Category="Time", meta=(ClampMin=0.1))
+	float SimulationBudgetMilliseconds = 2.0f;
+
 public:
 
 	// Gets the size of the snapping grid for structures.
@@ -30,5 +35,8 @@ public:
 	// Gets how real-life seconds it takes for an in-game hour to pass.
 	UFUNCTION(BlueprintGetter)
 	float GetSecondsInGameHours() { return SecondsInGameHours; }
+
+	UFUNCTION(BlueprintGetter)
+	float GetSimulationBudgetMilliseconds() { return SimulationBudgetMilliseconds; }
 	
 };
@@ -4,41 +4,17 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/GameStateBase.h"
+#include "Game/StrategyGameTypes.h"
+#include "Game/ResourceLedger.h"
 #include "StrategyGameState.generated.h"
 
 class AStrategyGameModeBase;
 class AStructure;
 class ARoad;
 
-UENUM(BlueprintType, DisplayName="Time Scale")
-enum class ETimeScale : uint8
-{
-	OneTimesSpeed		UMETA(DisplayName="1x Speed"),
-	TwoTimesSpeed		UMETA(DisplayName="2x Speed"),
-	ThreeTimesSpeed		UMETA(DisplayName="3x Speed"),
-};
-
-UENUM(BlueprintType, DisplayName="Resource Type")
-enum class EResourceType : uint8
-{
-	Metal						UMETA(DisplayName="Metal"),
-	Concrete					UMETA(DisplayName="Concrete"),
-	Oil							UMETA(DisplayName="Oil"),
-	AlienMaterial				UMETA(DisplayName="Alien Material"),
-	Food						UMETA(DisplayName="Food"),
-	Power						UMETA(DisplayName="Power"),
-	ResearchPoints				UMETA(DisplayName="Research Points"),
-};
-
-UENUM(BlueprintType, DisplayName="Citizen Type")
-enum class ECitizenType : uint8
-{
-	Worker			UMETA(DisplayName="Worker"),
-	Scientist		UMETA(DisplayName="Scientist"),
-};
-
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FTimeScaleChangedDelegate, ETimeScale, NewTimeScale);
-DECLARE_DYNAMIC_MULTICAST_DELEGATE(FResourcesChangedDelegate);
+// ChangedResourceMask has the bit (1 << EResourceType) set for every resource that changed since the last broadcast.
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FResourcesChangedDelegate, int32, ChangedResourceMask);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FPopulationChangedDelegate);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FAssignedWorkersChangedDelegate);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FStructureBuiltDelegate, AStructure*, BuiltStructure);
@@ -60,6 +36,10 @@ protected:
 	UPROPERTY(VisibleAnywhere, Category="Time")
 	ETimeScale TimeScale = ETimeScale::OneTimesSpeed;
 
+	// How many simulated seconds pass per real second. Only the economy, construction and the day cycle are sped up.
+	UPROPERTY(VisibleAnywhere, Category="Time")
+	float SimulationSpeed = 1.0f;
+
 	// The Time of Day in hours. Ranges between 0 and 24
 	UPROPERTY(VisibleAnywhere, Category="Time")
 	float TimeOfDay = 12.0f;
@@ -68,24 +48,45 @@ protected:
 	UPROPERTY(VisibleAnywhere, Category="Time")
 	int32 DaysCitySurvived = 0;
 
-	UPROPERTY() TArray<AStructure*> BuiltStructures;
-	
+	// The resources the city starts with. Runtime amounts are stored in ResourceLedger.
 	UPROPERTY(EditDefaultsOnly, Category="Resources")
 	TMap<EResourceType, float> ResourceInventory;
 
+	// The storage capacity the city starts with. Runtime capacities are stored in ResourceLedger.
 	UPROPERTY(EditDefaultsOnly, Category="Resources")
 	TMap<EResourceType, int32> MaximumResources;
 
+	// Current resource amounts and capacities, indexed by EResourceType.
+	FResourceLedger ResourceLedger;
+
+	// ------ NOTIFICATIONS ------
+
+	// How often, in seconds, resource and population changes are broadcast. 0 broadcasts at most once per frame.
+	UPROPERTY(EditDefaultsOnly, Category="Notifications", meta=(ClampMin=0))
+	float NotificationFlushInterval = 0.0f;
+
+	UPROPERTY() float TimeSinceNotificationFlush = 0.0f;
+
+	// One bit per EResourceType that has changed since the last flush.
+	UPROPERTY() int32 DirtyResourceMask = 0;
+
+	UPROPERTY() bool bPopulationDirty = false;
+
+	UPROPERTY() bool bAssignedWorkersDirty = false;
+
 	UPROPERTY(EditDefaultsOnly, Category="Population")
 	TMap<ECitizenType, int32> Population;
 
 	UPROPERTY(EditDefaultsOnly, Category="Population")
 	int32 PopulationCapacity = 0;
 
+	// Running total of citizens assigned to structures, indexed by ECitizenType.
+	int32 EmployedPopulation[NumCitizenTypes] = {};
+
+	virtual void PostInitializeComponents() override;
+
 	virtual void BeginPlay() override;
 
-	UFUNCTION() void OnStructureBuilt(AStructure* BuiltStructure);
-	UFUNCTION() void OnStructureDestroyed(AStructure* BuiltStructure);
 
 public:
 
@@ -96,7 +97,7 @@ public:
 	FResourcesChangedDelegate OnResourcesChanged;
 	
 	UPROPERTY(BlueprintAssignable, BlueprintCallable)
-	FResourcesChangedDelegate OnPopulationChanged;
+	FPopulationChangedDelegate OnPopulationChanged;
 
 	UPROPERTY(BlueprintAssignable, BlueprintCallable)
 	FAssignedWorkersChangedDelegate OnAssignedWorkersChanged;
@@ -114,15 +115,23 @@ public:
 	UFUNCTION()
 	void ClampResources();
 
-	// Finds all the structures that have been placed and returns an array.
-	UFUNCTION()
-	TArray<AStructure*> FindAllStructures();
-
 	UFUNCTION()
 	void UpdateTimeOfDay(float DeltaSeconds);
 
 	virtual void Tick(float DeltaSeconds) override;
 
+	// Broadcasts every resource and population change accumulated since the last flush as a single event.
+	UFUNCTION(BlueprintCallable, Category="Notifications")
+	void FlushNotifications();
+
+	void MarkResourceDirty(EResourceType ResourceType) { DirtyResourceMask |= 1 << static_cast<int32>(ResourceType); }
+
+	void MarkPopulationDirty() { bPopulationDirty = true; }
+
+	// Checks if a resource's bit is set in a mask broadcast by OnResourcesChanged.
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Notifications")
+	static bool IsResourceInMask(int32 ResourceMask, EResourceType ResourceType) { return (ResourceMask & (1 << static_cast<int32>(ResourceType))) != 0; }
+
 	UFUNCTION(BlueprintCallable, BlueprintPure)
 	AStrategyGameModeBase* GetStrategyGameMode();
 
@@ -132,6 +141,24 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Time")
 	ETimeScale GetTimeScale() { return TimeScale; }
 
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Time")
+	float GetSimulationSpeed() { return SimulationSpeed; }
+
+	// Gets how many simulated seconds pass per real second at a time scale.
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Time")
+	static float GetTimeScaleMultiplier(ETimeScale InTimeScale);
+
+	// Skips forward an amount of in-game hours, fast forwarding the economy in one go instead of simulating every step.
+	UFUNCTION(BlueprintCallable, Category="Time")
+	void SkipHours(float Hours);
+
+	// Skips forward to the next time the clock reaches Hour, between 0 and 24.
+	UFUNCTION(BlueprintCallable, Category="Time")
+	void SkipToHour(float Hour);
+
+	UFUNCTION(BlueprintCallable, Category="Time")
+	void SkipDays(int32 Days) { SkipHours(Days * 24.0f); }
+
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Time")
 	float GetTimeOfDay() { return TimeOfDay; }
 
@@ -139,14 +166,16 @@ public:
 	int32 GetDaysCityHasSurvived() { return DaysCitySurvived; }
 
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Resources")
-	float GetResourceAmount(EResourceType ResourceType) { return ResourceInventory.FindRef(ResourceType); }
+	float GetResourceAmount(EResourceType ResourceType) { return ResourceLedger.GetAmount(ResourceType); }
 
 	// Gets the resource amount floored to an int32. Useful for UI and displaying resource counts.
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Resources")
 	int32 GetResourceAmountInt32(EResourceType ResourceType) { return FMath::FloorToInt32(GetResourceAmount(ResourceType)); }
 
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Resources")
-	int32 GetResourceCapacity(EResourceType ResourceType) { return MaximumResources.FindRef(ResourceType); }
+	int32 GetResourceCapacity(EResourceType ResourceType) { return FMath::FloorToInt32(ResourceLedger.GetCapacity(ResourceType)); }
+
+	const FResourceLedger& GetResourceLedger() const { return ResourceLedger; }
 
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Population")
 	int32 GetPopulation(ECitizenType WorkerType) { return Population.FindRef(WorkerType); }
@@ -158,13 +187,13 @@ public:
 	int32 GetPopulationCapacity() { return PopulationCapacity; }
 
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Population")
-	int32 GetEmployedPopulation(ECitizenType WorkerType);
+	int32 GetEmployedPopulation(ECitizenType WorkerType) { return EmployedPopulation[static_cast<int32>(WorkerType)]; }
 
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Population")
 	int32 GetUnemployedPopulation(ECitizenType WorkerType) { return GetPopulation(WorkerType) - GetEmployedPopulation(WorkerType); }
 
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Population")
-	int32 GetTotalEmployedPopulation();
+	int32 GetTotalEmployedPopulation() { return GetEmployedPopulation(ECitizenType::Worker) + GetEmployedPopulation(ECitizenType::Scientist); }
 
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Population")
 	int32 GetTotalUnemployedPopulation() { return GetTotalPopulation() - GetTotalEmployedPopulation(); }
@@ -172,14 +201,27 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Population")
 	int32 GetHomelessPopulation();
 
-	// Attempts to add resources to the ResourceInventory Map. Returns if it was successful.
+	// Attempts to add resources to the ResourceLedger. Returns the new resource amount.
 	UFUNCTION(BlueprintCallable, Category="Resources")
 	float AddResources(EResourceType ResourceType, float Amount);
 
-	// Attempts to remove resources from the ResourceInventory Map. Returns if it was successful.
+	// Attempts to remove resources from the ResourceLedger. Returns the new resource amount.
 	UFUNCTION(BlueprintCallable, Category="Resources")
 	float ConsumeResources(EResourceType ResourceType, float Amount);
 
+	// Overwrites a resource amount, clamped between 0 and its capacity. Used when the economy is fast forwarded.
+	float SetResourceAmount(EResourceType ResourceType, float NewAmount);
+
+	bool CanAfford(const FResourceTransaction& Transaction) const { return ResourceLedger.CanApply(Transaction); }
+
+	// Checks if there are enough resources to pay a cost, such as a construction cost.
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Resources", DisplayName="CanAfford")
+	bool BP_CanAfford(const TMap<EResourceType, int32>& Cost, int32 Count = 1);
+
+	// Checks and applies every cost and refund in the transaction as one change, followed by a single resource notification.
+	// Returns false without changing anything if any of the costs can't be paid.
+	bool CommitResourceTransaction(const FResourceTransaction& Transaction);
+
 	UFUNCTION(BlueprintCallable, Category="Resources")
 	int32 IncreaseResourceStorage(EResourceType ResourceType, int32 IncreaseAmount);
 	
@@ -197,4 +239,12 @@ public:
 
 	UFUNCTION(BlueprintCallable, Category="Population")
 	int32 DecreasePopulationCapacity(int32 DecreaseAmount);
+
+	// Called by structures whenever citizens are assigned to or removed from them. Delta is negative when removing.
+	void ChangeEmployedPopulation(ECitizenType WorkerType, int32 Delta);
+
+	// Recounts the workers assigned to every structure and checks it matches the running totals.
+	// Runs after every employment change while StrategyGame.Population.VerifyEmployment is enabled.
+	UFUNCTION(BlueprintCallable, Category="Population")
+	bool VerifyEmployedPopulation();
 };
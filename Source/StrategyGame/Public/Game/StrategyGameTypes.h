@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "StrategyGameTypes.generated.h"
+
+UENUM(BlueprintType, DisplayName="Time Scale")
+enum class ETimeScale : uint8
+{
+	OneTimesSpeed		UMETA(DisplayName="1x Speed"),
+	TwoTimesSpeed		UMETA(DisplayName="2x Speed"),
+	ThreeTimesSpeed		UMETA(DisplayName="3x Speed"),
+	TenTimesSpeed		UMETA(DisplayName="10x Speed"),
+	TwentyFiveTimesSpeed	UMETA(DisplayName="25x Speed"),
+	FiftyTimesSpeed		UMETA(DisplayName="50x Speed"),
+};
+
+UENUM(BlueprintType, DisplayName="Resource Type")
+enum class EResourceType : uint8
+{
+	Metal						UMETA(DisplayName="Metal"),
+	Concrete					UMETA(DisplayName="Concrete"),
+	Oil							UMETA(DisplayName="Oil"),
+	AlienMaterial				UMETA(DisplayName="Alien Material"),
+	Food						UMETA(DisplayName="Food"),
+	Power						UMETA(DisplayName="Power"),
+	ResearchPoints				UMETA(DisplayName="Research Points"),
+
+	MAX							UMETA(Hidden),
+};
+ENUM_RANGE_BY_COUNT(EResourceType, EResourceType::MAX);
+
+// Number of resource types, useful for sizing arrays indexed by EResourceType.
+constexpr int32 NumResourceTypes = static_cast<int32>(EResourceType::MAX);
+
+UENUM(BlueprintType, DisplayName="Citizen Type")
+enum class ECitizenType : uint8
+{
+	Worker			UMETA(DisplayName="Worker"),
+	Scientist		UMETA(DisplayName="Scientist"),
+
+	MAX				UMETA(Hidden),
+};
+ENUM_RANGE_BY_COUNT(ECitizenType, ECitizenType::MAX);
+
+constexpr int32 NumCitizenTypes = static_cast<int32>(ECitizenType::MAX);
+
+UENUM(BlueprintType, DisplayName="Structure Capability")
+enum class EStructureCapability : uint8
+{
+	Generator		UMETA(DisplayName="Generator"),
+	Consumer		UMETA(DisplayName="Consumer"),
+	Extractor		UMETA(DisplayName="Extractor"),
+	Storage			UMETA(DisplayName="Storage"),
+	Housing			UMETA(DisplayName="Housing"),
+
+	MAX				UMETA(Hidden),
+};
+ENUM_RANGE_BY_COUNT(EStructureCapability, EStructureCapability::MAX);
+
+constexpr int32 NumStructureCapabilities = static_cast<int32>(EStructureCapability::MAX);
+
+// Stable reference to a structure in the structure registry.
+// The generation changes every time a slot is reused, so a handle to a removed structure never resolves to a new one.
+USTRUCT(BlueprintType)
+struct FStructureHandle
+{
+	GENERATED_BODY()
+
+	UPROPERTY() int32 Index = INDEX_NONE;
+	UPROPERTY() int32 Generation = 0;
+
+	bool IsValid() const { return Index != INDEX_NONE; }
+	void Invalidate() { Index = INDEX_NONE; Generation = 0; }
+
+	bool operator==(const FStructureHandle& Other) const { return Index == Other.Index && Generation == Other.Generation; }
+	bool operator!=(const FStructureHandle& Other) const { return !(*this == Other); }
+
+	friend uint32 GetTypeHash(const FStructureHandle& Handle) { return HashCombine(GetTypeHash(Handle.Index), GetTypeHash(Handle.Generation)); }
+};
+
+UENUM(BlueprintType, DisplayName="Gameplay Tick Policy")
+enum class EGameplayTickPolicy : uint8
+{
+	// Ticks every frame, the same as a regular actor.
+	EveryFrame		UMETA(DisplayName="Every Frame"),
+	// Never ticks, even if a subclass can.
+	Never			UMETA(DisplayName="Never"),
+	// Only ticks between WakeTick and SleepTick, for actors that have work to do some of the time.
+	OnDemand		UMETA(DisplayName="On Demand"),
+	// Ticks every Interval seconds.
+	Interval		UMETA(DisplayName="Interval"),
+	// Ticks less often the further the actor is from the camera, and not at all when it's far away.
+	Significance	UMETA(DisplayName="Significance"),
+};
+
+// How often an actor ticks, applied by the tick policy subsystem when the actor begins play.
+USTRUCT(BlueprintType)
+struct FGameplayTickPolicy
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="Tick Policy")
+	EGameplayTickPolicy Policy = EGameplayTickPolicy::EveryFrame;
+
+	// Seconds between ticks.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="Tick Policy", meta=(EditCondition="Policy == EGameplayTickPolicy::Interval", EditConditionHides, ClampMin=0))
+	float Interval = 0.5f;
+
+	// Within this distance of the camera the actor ticks every frame.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="Tick Policy", meta=(EditCondition="Policy == EGameplayTickPolicy::Significance", EditConditionHides, ClampMin=0))
+	float NearDistance = 5000.0f;
+
+	// Between NearDistance and this distance the actor ticks every FarInterval seconds, any further and it stops ticking.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="Tick Policy", meta=(EditCondition="Policy == EGameplayTickPolicy::Significance", EditConditionHides, ClampMin=0))
+	float FarDistance = 25000.0f;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category="Tick Policy", meta=(EditCondition="Policy == EGameplayTickPolicy::Significance", EditConditionHides, ClampMin=0))
+	float FarInterval = 0.25f;
+};
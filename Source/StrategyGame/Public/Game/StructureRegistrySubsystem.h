@@ -0,0 +1,104 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Game/StrategyGameTypes.h"
+#include "StructureRegistrySubsystem.generated.h"
+
+class AStructure;
+
+// Structures in one bucket, along with the registry slot of each entry so swap-removes can fix up the moved entry.
+USTRUCT()
+struct FStructureBucket
+{
+	GENERATED_BODY()
+
+	UPROPERTY() TArray<AStructure*> Structures;
+
+	TArray<int32> Slots;
+};
+
+// Keeps track of every built structure in the world.
+// Structures are handed a stable FStructureHandle and sorted into buckets by class and by capability,
+// so gameplay and UI can iterate only the structures they care about. Adding and removing are O(1).
+UCLASS()
+class STRATEGYGAME_API UStructureRegistrySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	struct FSlot
+	{
+		AStructure* Structure = nullptr;
+		UClass* Class = nullptr;
+		int32 Generation = 0;
+
+		// Position of the structure in AllStructures, its class bucket and each capability bucket, INDEX_NONE if it isn't in one.
+		int32 AllPosition = INDEX_NONE;
+		int32 ClassPosition = INDEX_NONE;
+		int32 CapabilityPositions[NumStructureCapabilities];
+	};
+
+	TArray<FSlot> Slots;
+
+	// Slots that were freed and can be reused by the next registered structure.
+	TArray<int32> FreeSlots;
+
+	UPROPERTY() FStructureBucket AllStructures;
+
+	UPROPERTY() TMap<UClass*, FStructureBucket> ClassBuckets;
+
+	// Indexed by EStructureCapability.
+	UPROPERTY() TArray<FStructureBucket> CapabilityBuckets;
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	// Adds a slot to the end of a bucket and returns its position.
+	static int32 AddToBucket(FStructureBucket& Bucket, AStructure* Structure, int32 Slot);
+
+	// Swap-removes the entry at Position. Returns the slot of the entry that was moved into Position, or INDEX_NONE.
+	static int32 RemoveFromBucket(FStructureBucket& Bucket, int32 Position);
+
+	// Returns true if the structure belongs in the capability bucket, based on its structure data.
+	static bool HasCapability(AStructure* Structure, EStructureCapability Capability);
+
+public:
+
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// Registers every structure that was already built when the level loaded.
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	// Adds the structure to the registry, or returns its existing handle if it's already registered.
+	UFUNCTION(BlueprintCallable, Category="Structures")
+	FStructureHandle RegisterStructure(AStructure* Structure);
+
+	UFUNCTION(BlueprintCallable, Category="Structures")
+	void UnregisterStructure(AStructure* Structure);
+
+	// ------ GETTERS ------
+
+	// Returns the structure a handle points to, or nullptr if it has been removed.
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Structures")
+	AStructure* ResolveHandle(FStructureHandle Handle) const;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Structures")
+	bool IsRegistered(AStructure* Structure) const;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Structures")
+	int32 GetNumStructures() const { return AllStructures.Structures.Num(); }
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Structures")
+	const TArray<AStructure*>& GetAllStructures() const { return AllStructures.Structures; }
+
+	// Returns the structures of exactly this class, subclasses have their own bucket.
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Structures")
+	const TArray<AStructure*>& GetStructuresOfClass(TSubclassOf<AStructure> StructureClass) const;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Structures")
+	const TArray<AStructure*>& GetStructuresWithCapability(EStructureCapability Capability) const;
+};
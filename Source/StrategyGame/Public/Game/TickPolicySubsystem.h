@@ -0,0 +1,66 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Game/StrategyGameTypes.h"
+#include "TickPolicySubsystem.generated.h"
+
+class ACustomActor;
+
+// Applies each actor's FGameplayTickPolicy when it begins play.
+// Actors using the Significance policy are kept in one list and re-bucketed by camera distance a few times a second,
+// so only the ones close enough to matter pay for a tick.
+UCLASS()
+class STRATEGYGAME_API UTickPolicySubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	enum class ESignificanceBucket : uint8
+	{
+		Unknown,
+		Near,
+		Far,
+		Culled,
+	};
+
+	UPROPERTY() TArray<ACustomActor*> SignificanceActors;
+
+	// Current bucket of each significance actor, parallel to SignificanceActors.
+	TArray<ESignificanceBucket> SignificanceBuckets;
+
+	// How many seconds pass between significance updates.
+	UPROPERTY()
+	float SignificanceUpdateInterval = 0.25f;
+
+	UPROPERTY()
+	float SignificanceUpdateAccumulator = 0.0f;
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	// Puts every significance actor in the right bucket for the current camera location.
+	void UpdateSignificance();
+
+	static void ApplySignificanceBucket(ACustomActor* Actor, ESignificanceBucket Bucket);
+
+public:
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	virtual void Deinitialize() override;
+
+	// Applies the actor's tick policy. Called by ACustomActor::BeginPlay.
+	void RegisterActor(ACustomActor* Actor);
+
+	// Called by ACustomActor::EndPlay.
+	void UnregisterActor(ACustomActor* Actor);
+
+	// ------ GETTERS ------
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Tick Policy")
+	int32 GetNumSignificanceActors() const { return SignificanceActors.Num(); }
+};
@@ -33,8 +33,4 @@ protected:
 public:
 
 	virtual bool Interact(APlayerCharacter* InteractInstigator) override;
-	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
-
 };
@@ -0,0 +1,32 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Interface.h"
+#include "PoolableInterface.generated.h"
+
+// This class does not need to be modified.
+UINTERFACE(MinimalAPI)
+class UPoolableInterface : public UInterface
+{
+	GENERATED_BODY()
+};
+
+// Actors that can be reused by the actor pool subsystem instead of being destroyed.
+// BeginPlay only runs the first time, so anything it sets up that has to be fresh for each use belongs in OnAcquiredFromPool.
+class STRATEGYGAME_API IPoolableInterface
+{
+	GENERATED_BODY()
+
+	// Add interface functions to this class. This is the class that will be inherited to implement this interface.
+public:
+
+	// Called after the actor is taken out of the pool and moved into place.
+	UFUNCTION(BlueprintCallable, BlueprintNativeEvent)
+	void OnAcquiredFromPool();
+
+	// Called before the actor is hidden and put back in the pool. Undo anything that registered the actor with the world here.
+	UFUNCTION(BlueprintCallable, BlueprintNativeEvent)
+	void OnReturnedToPool();
+};
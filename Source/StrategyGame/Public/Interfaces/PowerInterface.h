@@ -31,4 +31,20 @@ public:
 
 	UFUNCTION(BlueprintCallable, BlueprintNativeEvent)
 	bool DisconnectPower(APowerLine* PowerLine);
+
+	// Power per second this adds to its network.
+	UFUNCTION(BlueprintCallable, BlueprintNativeEvent)
+	float GetPowerGeneration();
+
+	// Power per second this draws from its network.
+	UFUNCTION(BlueprintCallable, BlueprintNativeEvent)
+	float GetPowerConsumption();
+
+	// How far this reaches from its location. Two nodes link when their radii overlap.
+	UFUNCTION(BlueprintCallable, BlueprintNativeEvent)
+	float GetPowerConnectionRadius();
+
+	// Called by the power network subsystem when this gains or loses a power source, or the network's balance changes.
+	UFUNCTION(BlueprintCallable, BlueprintNativeEvent)
+	void OnPowerNetworkChanged(bool bConnectedToPowerSource, float Satisfaction);
 };
@@ -107,7 +107,7 @@ public:
 	virtual void Tick(float DeltaTime) override;
 
 	UFUNCTION(BlueprintCallable)
-	ARemoteControlTurret* SetControlledTurret(ARemoteControlTurret* NewTurret) { return ControlledTurret = NewTurret; }	
+	ARemoteControlTurret* SetControlledTurret(ARemoteControlTurret* NewTurret);
 
 	// ------ GETTERS ------
 
@@ -96,6 +96,44 @@ protected:
 
 	// The Structure that has been clicked on / selected.
 	UPROPERTY() ABuildable* SelectedBuildable = nullptr;
+
+	// Hands the blueprint back to the actor pool, so picking the same building again doesn't spawn a new one.
+	void ReleaseBuildableBlueprint();
+
+	// Last snapped location the blueprint was moved to, so it's only moved when the cursor reaches another cell.
+	FVector LastBlueprintLocation = FVector(TNumericLimits<float>::Max());
+
+	// ------ CURSOR ------
+
+	// The cursor ray is only deprojected again when the mouse or the camera moves.
+	FVector2D CursorScreenPosition = FVector2D::ZeroVector;
+	FVector CursorViewLocation = FVector::ZeroVector;
+	FRotator CursorViewRotation = FRotator::ZeroRotator;
+	FVector CursorRayOrigin = FVector::ZeroVector;
+	FVector CursorRayDirection = FVector::ZeroVector;
+	bool bCursorRayValid = false;
+
+	// Bumped every time the cursor ray changes.
+	uint32 CursorRayVersion = 0;
+
+	FVector CursorGroundLocation = FVector::ZeroVector;
+	uint32 CursorGroundVersion = MAX_uint32;
+
+	// Ground height per snapping cell, traced once the first time the cursor lands on the cell.
+	TMap<FIntPoint, float> GroundHeightCache;
+
+	// Ignores this pawn, its child actors and the blueprint. Only rebuilt when the blueprint changes.
+	FCollisionQueryParams CursorTraceParams;
+
+	void RefreshCursorTraceParams();
+
+	// Deprojects the mouse again if it or the camera moved. Returns true if the ray changed.
+	bool UpdateCursorRay();
+
+	// Intersects the cursor ray with the cached ground heights instead of tracing against the landscape.
+	bool GetCursorGroundLocation(FVector& OutLocation);
+
+	float GetGroundHeight(const FVector& Location);
 	
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
@@ -143,6 +181,10 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void MoveBlueprintToMousePos();
 
+	// Clears the cached ground heights, for when the landscape under the build grid changes.
+	UFUNCTION(BlueprintCallable)
+	void InvalidateGroundHeightCache();
+
 	UFUNCTION()
 	void OnTimeScaleChanged(const ETimeScale NewTimeScale);
 
@@ -78,6 +78,9 @@ protected:
 	UPROPERTY(EditAnywhere, Category = "Input|RTS") UInputAction* Input_RTS_1xSpeed;
 	UPROPERTY(EditAnywhere, Category = "Input|RTS") UInputAction* Input_RTS_2xSpeed;
 	UPROPERTY(EditAnywhere, Category = "Input|RTS") UInputAction* Input_RTS_3xSpeed;
+	UPROPERTY(EditAnywhere, Category = "Input|RTS") UInputAction* Input_RTS_10xSpeed;
+	UPROPERTY(EditAnywhere, Category = "Input|RTS") UInputAction* Input_RTS_25xSpeed;
+	UPROPERTY(EditAnywhere, Category = "Input|RTS") UInputAction* Input_RTS_50xSpeed;
 	
 	UPROPERTY(EditAnywhere, Category = "Input|Turret") UInputAction* Input_Turret_Look;
 	UPROPERTY(EditAnywhere, Category = "Input|Turret") UInputAction* Input_Turret_Fire;
@@ -156,6 +159,12 @@ public:
 	void RTS_Set2xSpeed();
 	
 	void RTS_Set3xSpeed();
+
+	void RTS_Set10xSpeed();
+
+	void RTS_Set25xSpeed();
+
+	void RTS_Set50xSpeed();
 	
 	void ReturnToFirstPerson();
 
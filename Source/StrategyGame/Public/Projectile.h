@@ -69,6 +69,8 @@ public:
 	UFUNCTION(BlueprintCallable, BlueprintPure)
 	USphereComponent* GetSphere() const { return Sphere; }
 
+	float GetInitialLifeSpan() const { return InitialLifeSpan; }
+
 	// ------ SETTERS ------
 
 	void AddActorToIgnore(AActor* Actor) { ActorsToIgnore.Add(Actor); }
@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "InstancedRenderActor.generated.h"
+
+class UInstancedStaticMeshComponent;
+
+// Holds instanced mesh components for things that are simulated outside of actors, like projectiles.
+// Each mesh gets one component, so every instance of it is drawn together.
+UCLASS(NotPlaceable, Transient)
+class STRATEGYGAME_API AInstancedRenderActor : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	AInstancedRenderActor();
+
+protected:
+
+	UPROPERTY(VisibleAnywhere)
+	USceneComponent* SceneComponent;
+
+	UPROPERTY()
+	TMap<UStaticMesh*, UInstancedStaticMeshComponent*> InstancedMeshes;
+
+public:
+
+	// Returns the component drawing the mesh, creating it the first time the mesh is used.
+	UInstancedStaticMeshComponent* GetInstancedMesh(UStaticMesh* Mesh, bool bCastShadow = false);
+
+	// Sets the component to exactly Transforms.Num() instances, all in world space.
+	static void UpdateInstances(UInstancedStaticMeshComponent* InstancedMesh, const TArray<FTransform>& Transforms);
+};
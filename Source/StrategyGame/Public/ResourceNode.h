@@ -3,12 +3,12 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "Components/SphereComponent.h"
 #include "Game/StrategyGameState.h"
 #include "CustomActor.h"
 #include "ResourceNode.generated.h"
 
 class ABuildable;
+class UCurveFloat;
 
 UCLASS()
 class STRATEGYGAME_API AResourceNode : public ACustomActor
@@ -26,40 +26,61 @@ protected:
 	UPROPERTY(EditDefaultsOnly)
 	UStaticMeshComponent* StaticMesh = nullptr;
 
-	UPROPERTY(EditDefaultsOnly)
-	USphereComponent* Sphere;
-
 	UPROPERTY() ABuildable* AssignedExtractor;
 
 	UPROPERTY(EditDefaultsOnly, Category="Resources")
 	EResourceType ResourceType = EResourceType::Metal;
 
+	// The reserve the node starts with. Once it's in play, the reserve is kept by the resource field.
+	UPROPERTY(EditDefaultsOnly, Category="Resources")
+	float ResourceAmount = 500.0f;
+
+	// Resources regenerated per second, by how full the node is from 0 to 1. Nodes without a curve are used up when emptied.
 	UPROPERTY(EditDefaultsOnly, Category="Resources")
-	int32 ResourceAmount = 500;
+	UCurveFloat* RegenerationCurve = nullptr;
+
+	// How far from the node an extractor can be built.
+	UPROPERTY(EditDefaultsOnly, Category="Resources")
+	float ExtractionRadius = 2000.0f;
 	
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 public:
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
 
+	// Takes up to DecreaseAmount from the reserve and returns how much was taken.
 	UFUNCTION(BlueprintCallable)
-	void DrainResource(int32 DecreaseAmount);
+	float DrainResource(float DecreaseAmount);
 
 	// ------ SETTERS ------
 
 	UFUNCTION(BlueprintCallable)
 	void SetAssignedExtractor(ABuildable* NewExtractor);
 
+	// Frees the node for another extractor, if Extractor is the one assigned to it.
+	UFUNCTION(BlueprintCallable)
+	void ClearAssignedExtractor(ABuildable* Extractor);
+
 	// ------ GETTERS ------
 
+	// What's left in the reserve.
+	UFUNCTION(BlueprintCallable, BlueprintPure)
+	float GetResourceAmount();
+
 	UFUNCTION(BlueprintCallable, BlueprintPure)
-	int32 GetResourceAmount() { return ResourceAmount; }
+	float GetStartingResourceAmount() const { return ResourceAmount; }
+
+	UFUNCTION(BlueprintCallable, BlueprintPure)
+	UCurveFloat* GetRegenerationCurve() const { return RegenerationCurve; }
 	
 	UFUNCTION(BlueprintCallable, BlueprintPure)
 	EResourceType GetResourceType() { return ResourceType; }
 
 	UFUNCTION(BlueprintCallable, BlueprintPure)
 	ABuildable* GetAssignedExtractor() { return AssignedExtractor; }
+
+	UFUNCTION(BlueprintCallable, BlueprintPure)
+	float GetExtractionRadius() const { return ExtractionRadius; }
 };
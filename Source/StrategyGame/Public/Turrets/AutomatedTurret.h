@@ -6,7 +6,6 @@
 #include "Turret.h"
 #include "AutomatedTurret.generated.h"
 
-class AEnemyShip;
 class USphereComponent;
 
 UCLASS()
@@ -23,23 +22,45 @@ protected:
 	UPROPERTY(EditAnywhere, Category="Automated Turret")
 	USphereComponent* SphereComponent;
 
-	UPROPERTY()
-	FTimerHandle ScanForEnemiesTimer;
-
 	UPROPERTY(VisibleAnywhere, Category="Automated Turret")
 	AActor* TargetEnemy = nullptr;
+
+	// Index of the swarm ship to shoot at while it isn't an actor, or INDEX_NONE. Aimed at by its swarm position,
+	// so picking a target never spawns an actor. The ship only becomes one when a shot hits it.
+	UPROPERTY(VisibleAnywhere, Category="Automated Turret")
+	int32 TargetSwarmShip = INDEX_NONE;
 	
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 public:
 
+	// Targets are normally handed out by the targeting subsystem, this looks up the closest enemy for just this turret.
 	UFUNCTION(BlueprintCallable, Category="AutomatedTurret")
 	void ScanForEnemies();
 
+	// Sets the enemy to shoot at, the turret only ticks while it has one.
+	UFUNCTION(BlueprintCallable, Category="AutomatedTurret")
+	void SetTargetEnemy(AActor* NewTargetEnemy);
+
+	// Sets the swarm ship to shoot at instead of an actor, INDEX_NONE clears it.
+	void SetTargetSwarmShip(int32 NewTargetSwarmShip);
+
 	UFUNCTION(BlueprintCallable, Category="AutomatedTurret")
 	void AimAtTarget(FVector TargetPos);
 	
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
+
+	// ------ GETTERS ------
+
+	FVector GetTargetingOrigin() const;
+	float GetTargetingRange() const;
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="AutomatedTurret")
+	AActor* GetTargetEnemy() const { return TargetEnemy; }
+
+	int32 GetTargetSwarmShip() const { return TargetSwarmShip; }
 };
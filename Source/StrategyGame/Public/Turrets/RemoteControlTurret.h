@@ -33,8 +33,13 @@ protected:
 
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 public:
 
+	// While a player is controlling the turret, swarm ships flying near it are turned into actors.
+	void SetPlayerControlled(bool bPlayerControlled);
+
 	UFUNCTION(BlueprintCallable)
 	void Look(FVector2D Input);
 
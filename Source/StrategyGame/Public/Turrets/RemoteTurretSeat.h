@@ -33,9 +33,4 @@ protected:
 	virtual void BeginPlay() override;
 
 	virtual void OnInteract(APlayerCharacter* InteractInstigator) override;
-
-public:
-	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
 };
@@ -0,0 +1,137 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TargetingSubsystem.generated.h"
+
+class AAutomatedTurret;
+
+// Picks targets for every automated turret.
+// Enemy positions are put into a uniform spatial hash at most once a frame, and every TargetingInterval all turrets
+// look up their closest enemy in it in one parallel pass, instead of each turret running its own physics sweep.
+// Ships in the enemy swarm are hashed alongside the registered enemies. Turrets aim at them by swarm index, so only a
+// hit promotes a ship to an actor.
+UCLASS()
+class STRATEGYGAME_API UTargetingSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+protected:
+
+	// ------ ENEMIES ------
+
+	UPROPERTY() TArray<AActor*> Enemies;
+
+	// Position of each enemy in Enemies, for swap-removes.
+	TMap<AActor*, int32> EnemyIndices;
+
+	// Enemy locations at the time the hash was built. The first NumHashedActors are Enemies, the rest are swarm ships.
+	TArray<FVector> EnemyPositions;
+
+	int32 NumHashedActors = 0;
+
+	// ------ SPATIAL HASH ------
+
+	struct FCellEntry
+	{
+		uint64 Cell;
+		int32 Enemy;
+	};
+
+	// Enemies sorted by the cell they're in.
+	TArray<FCellEntry> CellEntries;
+
+	// First entry and number of entries in CellEntries for each occupied cell.
+	TMap<uint64, FIntPoint> CellRanges;
+
+	// Size of a hash cell in world units. Roughly a turret's range works best.
+	UPROPERTY()
+	float CellSize = 4000.0f;
+
+	// Frame the hash was last built on.
+	uint64 HashFrame = MAX_uint64;
+
+	// ------ TURRETS ------
+
+	UPROPERTY() TArray<AAutomatedTurret*> Turrets;
+
+	TMap<AAutomatedTurret*, int32> TurretIndices;
+
+	// How many seconds pass between target assignments.
+	UPROPERTY()
+	float TargetingInterval = 0.2f;
+
+	UPROPERTY()
+	float TargetingAccumulator = 0.0f;
+
+	// Below this many turrets targets are assigned on the game thread.
+	UPROPERTY()
+	int32 MinParallelTurrets = 32;
+
+	// Scratch arrays for the assignment pass.
+	TArray<FVector> TurretOrigins;
+	TArray<float> TurretRanges;
+	TArray<int32> TurretTargets;
+
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	FIntVector WorldToCell(const FVector& Location) const;
+	static uint64 PackCell(const FIntVector& Cell);
+
+	// Rebuilds the spatial hash if it hasn't been built this frame.
+	void UpdateSpatialHash();
+
+	// Index in Enemies of the closest enemy within Range of Origin, or INDEX_NONE. Only reads the hash, so it's safe to call in parallel.
+	int32 FindClosestEnemyIndex(const FVector& Origin, float Range) const;
+
+	// Turns an index from the hash into an actor, promoting swarm ships. Never removes enemies, so other indices stay valid.
+	// Only for callers that need an actor, turrets are handed swarm ships by index.
+	AActor* ResolveEnemy(int32 Index);
+
+	// Hands the turret the enemy at an index from the hash, as an actor or a swarm ship.
+	void SetTurretTarget(AAutomatedTurret* Turret, int32 Index) const;
+
+	template <typename MapType, typename ElementType>
+	static void RemoveIndexed(TArray<ElementType*>& Array, MapType& Indices, ElementType* Element);
+
+public:
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	virtual void Deinitialize() override;
+
+	UFUNCTION(BlueprintCallable, Category="Targeting")
+	void RegisterEnemy(AActor* Enemy);
+
+	// Removes the enemy from targeting and clears it from every turret aiming at it.
+	UFUNCTION(BlueprintCallable, Category="Targeting")
+	void UnregisterEnemy(AActor* Enemy);
+
+	// Makes the next query rebuild the hash, for when enemy indices change.
+	void InvalidateSpatialHash() { HashFrame = MAX_uint64; }
+
+	// Called by the swarm when a ship moves to another index. Turrets aiming at OldIndex aim at NewIndex instead,
+	// or stop aiming if it's INDEX_NONE.
+	void RemapSwarmShip(int32 OldIndex, int32 NewIndex);
+
+	void RegisterTurret(AAutomatedTurret* Turret);
+	void UnregisterTurret(AAutomatedTurret* Turret);
+
+	// Gives every registered turret the closest enemy in its range.
+	void AssignTargets();
+
+	// Gives just this turret the closest enemy in its range.
+	void AssignTarget(AAutomatedTurret* Turret);
+
+	// Returns the closest enemy within Range of Origin, or nullptr.
+	UFUNCTION(BlueprintCallable, Category="Targeting")
+	AActor* FindClosestEnemy(FVector Origin, float Range);
+
+	// ------ GETTERS ------
+
+	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Targeting")
+	int32 GetNumEnemies() const { return Enemies.Num(); }
+};
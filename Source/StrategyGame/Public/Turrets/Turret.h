@@ -42,15 +42,10 @@ public:
 	virtual void Fire();
 
 	virtual void Reload();
-	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
 
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Turret|Getters")
 	UShootingComponent* GetShootingComponent() { return ShootingComponent; }
 
 	UFUNCTION(BlueprintCallable, BlueprintPure, Category="Turret|Getters")
 	TArray<UArrowComponent*> GetMuzzleLocations() { return MuzzleLocations; }
-
-	
 };
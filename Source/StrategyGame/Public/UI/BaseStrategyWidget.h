@@ -59,11 +59,17 @@ protected:
 	void BP_OnBuildableDeSelected();
 
 	UFUNCTION()
-	void OnResourcesChanged();
+	void OnResourcesChanged(int32 ChangedResourceMask);
 
+	// Fires on any resource, population or worker change, like it always has. Kept so existing widgets keep working,
+	// new widgets should use OnResourceMaskChanged, OnPopulationChanged and OnAssignedWorkersChanged instead.
 	UFUNCTION(BlueprintImplementableEvent, DisplayName="OnResourcesChanged")
 	void BP_OnResourcesChanged();
 
+	// ChangedResourceMask has one bit per EResourceType that changed, use IsResourceInMask to only redraw those resources.
+	UFUNCTION(BlueprintImplementableEvent, DisplayName="OnResourceMaskChanged")
+	void BP_OnResourceMaskChanged(int32 ChangedResourceMask);
+
 	UFUNCTION()
 	void OnPopulationChanged();
 
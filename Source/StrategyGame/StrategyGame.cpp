@@ -3,4 +3,6 @@
 #include "StrategyGame.h"
 #include "Modules/ModuleManager.h"
 
+DEFINE_LOG_CATEGORY(LogStrategyGame);
+
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, StrategyGame, "StrategyGame" );
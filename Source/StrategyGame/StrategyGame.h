@@ -3,4 +3,8 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
 
+DECLARE_LOG_CATEGORY_EXTERN(LogStrategyGame, Log, All);
+
+DECLARE_STATS_GROUP(TEXT("StrategyGame"), STATGROUP_StrategyGame, STATCAT_Advanced);